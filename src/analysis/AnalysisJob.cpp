@@ -0,0 +1,114 @@
+#include "AnalysisJob.h"
+#include "../compression/ArchiveCompressor.h"
+#include "../utils/ThreadPool.h"
+#include <stdexcept>
+
+namespace {
+
+size_t jobCount(const AnalysisJob::Request& request) {
+    return request.archive ? request.levels.size() : request.files.size() * request.levels.size();
+}
+
+uint64_t totalBytes(const AnalysisJob::Request& request) {
+    uint64_t total = 0;
+    for (const auto& file : request.files) {
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(file, ec);
+        total += ec ? 0 : size;
+    }
+    return total * request.levels.size();
+}
+
+AnalysisJob::Request validated(AnalysisJob::Request request) {
+    if (!request.compressor || request.files.empty() || request.levels.empty()) {
+        throw std::invalid_argument("An analysis job needs a compressor, files and levels");
+    }
+    if (request.archive && !dynamic_cast<ArchiveCompressor*>(request.compressor)) {
+        throw std::invalid_argument("Archive jobs need the archive compressor");
+    }
+    return request;
+}
+
+} // namespace
+
+AnalysisJob::AnalysisJob(Request request)
+    : request_(validated(std::move(request))),
+      progress_(jobCount(request_), totalBytes(request_)),
+      slots_(jobCount(request_)),
+      collector_(
+          [this](const AnalysisResult& row) {
+              // Runs under the collector's lock, so one writer at a time
+              size_t index = published_.load(std::memory_order_relaxed);
+              if (index < slots_.size()) {
+                  slots_[index] = row;
+                  published_.store(index + 1, std::memory_order_release);
+              }
+          },
+          request_.on_error) {
+    request_.options.progress = &progress_;
+    thread_ = std::thread([this]() { run(); });
+}
+
+AnalysisJob::~AnalysisJob() {
+    cancel();
+    wait();
+}
+
+void AnalysisJob::wait() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void AnalysisJob::run() {
+    if (request_.prepare) {
+        progress_.beginPreparing();
+        JobProgress::Status status = JobProgress::Status::Cancelled;
+        try {
+            request_.prepare(progress_);
+            status = JobProgress::Status::Pending;
+        } catch (const AnalysisCancelled&) {
+        } catch (const std::exception& e) {
+            collector_.addError("Error preparing analysis: " + std::string(e.what()));
+            status = JobProgress::Status::Failed;
+        }
+        progress_.endPreparing();
+        if (status != JobProgress::Status::Pending) {
+            for (size_t i = 0; i < progress_.jobCount(); ++i) {
+                progress_.finish(i, status, 0);
+            }
+            finished_.store(true, std::memory_order_release);
+            return;
+        }
+    }
+
+    if (request_.archive) {
+        // Each archive already spreads over frame threads where it can
+        auto* archive = static_cast<ArchiveCompressor*>(request_.compressor);
+        uint64_t archive_bytes = progress_.totalBytes() / request_.levels.size();
+        for (size_t i = 0; i < request_.levels.size(); ++i) {
+            if (progress_.cancelled()) {
+                progress_.finish(i, JobProgress::Status::Cancelled, 0);
+                continue;
+            }
+            progress_.start(i);
+            AnalysisOptions options = request_.options;
+            options.progress_job = i;
+            try {
+                collector_.add(Analyzer::analyzeArchive(*archive, request_.files, request_.levels[i], options));
+                progress_.finish(i, JobProgress::Status::Done, archive_bytes);
+            } catch (const AnalysisCancelled&) {
+                progress_.finish(i, JobProgress::Status::Cancelled, 0);
+            } catch (const std::exception& e) {
+                collector_.addError("Error processing archive: " + std::string(e.what()));
+                progress_.finish(i, JobProgress::Status::Failed, archive_bytes);
+            }
+        }
+    } else {
+        unsigned threads = request_.threads ? request_.threads : ThreadPool::defaultThreadCount();
+        ThreadPool pool(threads);
+        Analyzer::analyzeFiles(*request_.compressor, request_.files, request_.levels, pool, collector_,
+                               request_.options);
+    }
+    finished_.store(true, std::memory_order_release);
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Analyzer.h"
+#include "JobProgress.h"
+#include "ResultCollector.h"
+
+// Runs one analysis on a thread of its own, for callers that must stay
+// responsive: the GUI polls progress() and the published rows every frame
+// and can cancel() at any point. Rows go into slots reserved up front (one
+// per job) and are published by bumping a counter, so readers never take a
+// lock and never see a row that is still being written.
+class AnalysisJob {
+public:
+    struct Request {
+        Compressor* compressor = nullptr;          // Not owned; must outlive the job
+        std::vector<std::filesystem::path> files;
+        std::vector<int> levels;
+        unsigned threads = 0;                      // Pool size for per-file jobs; 0 = hardware concurrency
+        bool archive = false;                      // One archive of all files per level (ArchiveCompressor)
+        AnalysisOptions options;                   // progress and progress_job are set by the job
+        ResultCollector::ErrorCallback on_error;   // Called from worker threads
+        // Runs on the job's thread before the first file, e.g. to train a
+        // dictionary and set it on the compressor; it should call
+        // progress.throwIfCancelled() often. If it throws, no file is analyzed.
+        std::function<void(const JobProgress& progress)> prepare;
+    };
+
+    // Starts the run; throws std::invalid_argument for a request without a
+    // compressor, files or levels, or an archive request for another codec
+    explicit AnalysisJob(Request request);
+    // Cancels the run and waits for it
+    ~AnalysisJob();
+
+    AnalysisJob(const AnalysisJob&) = delete;
+    AnalysisJob& operator=(const AnalysisJob&) = delete;
+
+    void cancel() { progress_.cancel(); }
+    bool cancelled() const { return progress_.cancelled(); }
+    // True once every worker is done; rows and errors are then final
+    bool finished() const { return finished_.load(std::memory_order_acquire); }
+    void wait();
+
+    const JobProgress& progress() const { return progress_; }
+    const Request& request() const { return request_; }
+
+    // Rows published so far, in completion order; rows below the count
+    // never change
+    size_t resultCount() const { return published_.load(std::memory_order_acquire); }
+    const AnalysisResult& result(size_t index) const { return slots_[index]; }
+    std::vector<std::string> errors() const { return collector_.errors(); }
+
+private:
+    Request request_;
+    JobProgress progress_;
+    std::vector<AnalysisResult> slots_;
+    std::atomic<size_t> published_{0};
+    ResultCollector collector_;
+    std::atomic<bool> finished_{false};
+    std::thread thread_;
+
+    void run();
+};
\ No newline at end of file
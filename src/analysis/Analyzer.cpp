@@ -0,0 +1,608 @@
+#include "Analyzer.h"
+#include "JobProgress.h"
+#include "ResultCache.h"
+#include "ResultCollector.h"
+#include "../compression/ArchiveCompressor.h"
+#include "../utils/FileHandler.h"
+#include "../utils/MappedFile.h"
+#include "../utils/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+
+namespace {
+
+// Streamed chunks of the original count towards the job's progress, and
+// every chunk is a point where a cancelled job stops
+void checkpoint(const AnalysisOptions& options, uint64_t bytes) {
+    if (options.progress) {
+        options.progress->throwIfCancelled();
+        if (bytes) {
+            options.progress->addBytes(options.progress_job, bytes);
+        }
+    }
+}
+
+// Benchmark options that stop between runs once the job is cancelled. A
+// buffered run itself cannot be interrupted, so callers check again after
+// Benchmark::run to drop a row that finished after the cancel.
+BenchmarkOptions checkedBenchmark(const AnalysisOptions& options) {
+    BenchmarkOptions benchmark = options.benchmark;
+    if (options.progress) {
+        JobProgress* progress = options.progress;
+        benchmark.before_run = [progress]() { progress->throwIfCancelled(); };
+    }
+    return benchmark;
+}
+
+// Time spent in the analysis' own work inside a timed codec call, so it can
+// be taken out of the codec's time; the buffered paths do that work untimed
+class OverheadTimer {
+public:
+    template <typename Work>
+    void measure(Work&& work) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        work();
+        total_ += std::chrono::high_resolution_clock::now() - start_time;
+    }
+
+    std::chrono::nanoseconds total() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(total_);
+    }
+
+private:
+    std::chrono::high_resolution_clock::duration total_{0};
+};
+
+// Passes bytes through while recording what the analysis needs from the
+// original: CRC-32 for round-trip verification, the entropy profile, and
+// the leading bytes for file type detection
+class ProfilingSource : public ByteSource {
+public:
+    ProfilingSource(ByteSource& inner, const AnalysisOptions& options)
+        : inner_(inner), options_(options), entropy_(options.entropy_window) {}
+
+    size_t read(uint8_t* buffer, size_t capacity) override {
+        size_t count = inner_.read(buffer, capacity);
+        overhead_.measure([&]() {
+            checkpoint(options_, count);
+            checksum_.write(buffer, count);
+            entropy_.update(ByteView(buffer, count));
+            if (head_.size() < kHeadSize) {
+                size_t take = std::min(count, kHeadSize - head_.size());
+                head_.insert(head_.end(), buffer, buffer + take);
+            }
+        });
+        return count;
+    }
+
+    const ChecksumSink& checksum() const { return checksum_; }
+    EntropyProfile finishEntropy() { return entropy_.finish(); }
+    const std::vector<uint8_t>& head() const { return head_; }
+    std::chrono::nanoseconds overhead() const { return overhead_.total(); }
+
+private:
+    static constexpr size_t kHeadSize = 1024;  // All detectFileType looks at
+
+    ByteSource& inner_;
+    const AnalysisOptions& options_;
+    ChecksumSink checksum_;
+    EntropyProfiler entropy_;
+    std::vector<uint8_t> head_;
+    OverheadTimer overhead_;
+};
+
+// Records the length, CRC-32 and entropy profile of everything written to it
+class PayloadSink : public ByteSink {
+public:
+    explicit PayloadSink(const AnalysisOptions& options) : options_(options), entropy_(options.entropy_window) {}
+
+    void write(const uint8_t* data, size_t size) override {
+        overhead_.measure([&]() {
+            checkpoint(options_, size);
+            checksum_.write(data, size);
+            entropy_.update(ByteView(data, size));
+        });
+    }
+
+    const ChecksumSink& checksum() const { return checksum_; }
+    EntropyProfile finish() { return entropy_.finish(); }
+    std::chrono::nanoseconds overhead() const { return overhead_.total(); }
+
+private:
+    const AnalysisOptions& options_;
+    ChecksumSink checksum_;
+    EntropyProfiler entropy_;
+    OverheadTimer overhead_;
+};
+
+// Checks for cancellation on every chunk of the round trip and verifies it
+// through inner, timing both as overhead
+class CheckedSink : public ByteSink {
+public:
+    CheckedSink(ByteSink& inner, const AnalysisOptions& options) : inner_(inner), options_(options) {}
+
+    void write(const uint8_t* data, size_t size) override {
+        overhead_.measure([&]() {
+            checkpoint(options_, 0);
+            inner_.write(data, size);
+        });
+    }
+
+    std::chrono::nanoseconds overhead() const { return overhead_.total(); }
+
+private:
+    ByteSink& inner_;
+    const AnalysisOptions& options_;
+    OverheadTimer overhead_;
+};
+
+// Removes a scratch file when the analysis finishes or throws
+struct TempFile {
+    std::filesystem::path path;
+    ~TempFile() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+};
+
+// "Gzip (Level 6)" -> "Gzip (Level 6, note)"
+std::string annotateLabel(std::string label, const std::string& note) {
+    if (!label.empty() && label.back() == ')') {
+        label.insert(label.size() - 1, ", " + note);
+    } else {
+        label += " (" + note + ")";
+    }
+    return label;
+}
+
+// Setup time and memory fields shared by the buffered analysis paths
+void copyStats(AnalysisResult& row, const Compressor::CompressionResult& result) {
+    row.memory_used = result.memory_used;
+    row.compression_setup_us = result.compression_setup_time.count() / 1000.0;
+    row.decompression_setup_us = result.decompression_setup_time.count() / 1000.0;
+    row.compression_codec_memory = result.compression_codec_memory;
+    row.compression_buffer_memory = result.compression_buffer_memory;
+    row.decompression_codec_memory = result.decompression_codec_memory;
+    row.decompression_buffer_memory = result.decompression_buffer_memory;
+    row.compression_stats = result.compression_stats;
+    row.decompression_stats = result.decompression_stats;
+}
+
+// Entropy fields shared by every analysis path
+void copyEntropy(AnalysisResult& row, EntropyProfile&& profile) {
+    row.entropy = profile.order0;
+    row.entropy_order1 = profile.order1;
+    row.entropy_order2 = profile.order2;
+    row.high_entropy_fraction = profile.high_entropy_fraction;
+    row.entropy_profile = std::move(profile.windows);
+}
+
+} // namespace
+
+AnalysisResult Analyzer::analyzeFile(Compressor& compressor,
+                                     const std::filesystem::path& file_path,
+                                     int level,
+                                     const AnalysisOptions& options) {
+    if (options.estimate != AnalysisOptions::Estimate::Off || options.skip_ratio > 0.0) {
+        AnalysisResult estimate = estimateFile(compressor, file_path, level, options);
+        estimate.skipped = options.skip_ratio > 0.0 && estimate.estimated_ratio_low >= options.skip_ratio;
+        if (options.estimate == AnalysisOptions::Estimate::Only || estimate.skipped) {
+            return estimate;
+        }
+        AnalysisOptions full = options;
+        full.estimate = AnalysisOptions::Estimate::Off;
+        full.skip_ratio = 0.0;
+        AnalysisResult row = analyzeFile(compressor, file_path, level, full);
+        row.estimated_ratio = estimate.estimated_ratio;
+        row.estimated_ratio_low = estimate.estimated_ratio_low;
+        row.estimated_ratio_high = estimate.estimated_ratio_high;
+        row.sampled_fraction = estimate.sampled_fraction;
+        return row;
+    }
+
+    if (compressor.supportsStreaming()) {
+        // Pipes and devices have no meaningful size; they take the buffered path
+        std::error_code ec;
+        uintmax_t size = std::filesystem::is_regular_file(file_path, ec) ? std::filesystem::file_size(file_path, ec) : 0;
+        if (options.streaming || (!ec && size >= options.streaming_threshold)) {
+            return analyzeFileStreaming(compressor, file_path, level, options);
+        }
+    }
+
+    MappedFile file(file_path);
+    ByteView file_data = file.view();
+    auto result = Benchmark::run([&]() { return compressor.compress(file_data, level); },
+                                 file_data.size(), checkedBenchmark(options));
+    checkpoint(options, 0);
+
+    AnalysisResult row;
+    row.filename = file_path.filename().string();
+    row.algorithm = compressor.getAlgorithmLabel(level);
+    if (!result.chosen_algorithm.empty()) {
+        row.algorithm += ": " + result.chosen_algorithm;
+    }
+    row.policy = result.policy;
+    row.file_type = FileHandler::detectFileType(file_data);
+    row.ratio = result.compression_ratio;
+    copyEntropy(row, EntropyProfiler::profile(file_data, options.entropy_window));
+    row.compression_time_us = std::chrono::duration_cast<std::chrono::microseconds>(result.compression_time).count();
+    row.decompression_time_us = std::chrono::duration_cast<std::chrono::microseconds>(result.decompression_time).count();
+    row.compression_throughput = result.compression_stats.median;
+    row.decompression_throughput = result.decompression_stats.median;
+    row.original_size = file_data.size();
+    row.compressed_size = result.compressed_size;
+    row.reference_ratio = result.reference_ratio;
+    copyStats(row, result);
+    return row;
+}
+
+AnalysisResult Analyzer::analyzeFileStreaming(Compressor& compressor,
+                                              const std::filesystem::path& file_path,
+                                              int level,
+                                              const AnalysisOptions& options) {
+    TempFile compressed{FileHandler::createTempFilePath("dca-stream")};
+
+    FileSource file_source(file_path);
+    ProfilingSource source(file_source, options);
+    Compressor::StreamResult compressed_stats;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    {
+        FileSink sink(compressed.path);
+        compressed_stats = compressor.compressStream(source, sink, level);
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto compression_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time - source.overhead());
+
+    FileSource compressed_source(compressed.path);
+    ChecksumSink round_trip;
+    CheckedSink checked_round_trip(round_trip, options);
+    start_time = std::chrono::high_resolution_clock::now();
+    auto decompressed_stats = compressor.decompressStream(compressed_source, checked_round_trip);
+    end_time = std::chrono::high_resolution_clock::now();
+    auto decompression_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time - checked_round_trip.overhead());
+
+    if (round_trip.size() != source.checksum().size() || round_trip.crc() != source.checksum().crc()) {
+        throw std::runtime_error("Round-trip mismatch after streaming decompression");
+    }
+
+    uint64_t original_size = compressed_stats.bytes_in;
+    AnalysisResult row;
+    row.filename = file_path.filename().string();
+    row.algorithm = annotateLabel(compressor.getAlgorithmLabel(level), "streamed");
+    row.file_type = FileHandler::detectFileType(source.head());
+    row.ratio = original_size ? static_cast<double>(compressed_stats.bytes_out) / original_size : 0.0;
+    copyEntropy(row, source.finishEntropy());
+    row.compression_time_us = compression_time.count();
+    row.decompression_time_us = decompression_time.count();
+    row.compression_throughput = FileHandler::calculateThroughput(original_size, compression_time.count());
+    row.decompression_throughput = FileHandler::calculateThroughput(original_size, decompression_time.count());
+    row.compression_stats = Benchmark::summarize({row.compression_throughput});
+    row.decompression_stats = Benchmark::summarize({row.decompression_throughput});
+    row.original_size = original_size;
+    row.compressed_size = compressed_stats.bytes_out;
+    row.compression_setup_us = compressed_stats.setup_time.count() / 1000.0;
+    row.decompression_setup_us = decompressed_stats.setup_time.count() / 1000.0;
+    row.compression_codec_memory = compressed_stats.codec_memory;
+    row.compression_buffer_memory = compressed_stats.buffer_memory;
+    row.decompression_codec_memory = decompressed_stats.codec_memory;
+    row.decompression_buffer_memory = decompressed_stats.buffer_memory;
+    row.memory_used = std::max(compressed_stats.codec_memory + compressed_stats.buffer_memory,
+                               decompressed_stats.codec_memory + decompressed_stats.buffer_memory);
+    return row;
+}
+
+AnalysisResult Analyzer::estimateFile(Compressor& compressor,
+                                      const std::filesystem::path& file_path,
+                                      int level,
+                                      const AnalysisOptions& options) {
+    MappedFile file(file_path, MappedFile::Access::Random);
+    ByteView file_data = file.view();
+    CompressibilityEstimate estimate = Estimator::estimate(compressor, file_data, level, options.estimator);
+
+    std::string label = annotateLabel(compressor.getAlgorithmLabel(level), "estimated");
+
+    // Times are extrapolated from the sample to the whole file
+    double scale = estimate.sampled_bytes ? static_cast<double>(file_data.size()) / estimate.sampled_bytes : 0.0;
+    AnalysisResult row;
+    row.filename = file_path.filename().string();
+    row.algorithm = label;
+    row.file_type = FileHandler::detectFileType(file_data);
+    row.ratio = estimate.ratio;
+    row.entropy = FileHandler::calculateEntropy(estimate.histogram);
+    row.compression_throughput = estimate.compression_throughput;
+    row.decompression_throughput = estimate.decompression_throughput;
+    row.compression_time_us = estimate.compression_throughput > 0.0
+        ? static_cast<long long>(file_data.size() / (estimate.compression_throughput * 1024.0 * 1024.0) * 1e6) : 0;
+    row.decompression_time_us = estimate.decompression_throughput > 0.0
+        ? static_cast<long long>(file_data.size() / (estimate.decompression_throughput * 1024.0 * 1024.0) * 1e6) : 0;
+    row.compression_stats = Benchmark::summarize({row.compression_throughput});
+    row.decompression_stats = Benchmark::summarize({row.decompression_throughput});
+    row.memory_used = 0;
+    row.original_size = file_data.size();
+    row.compressed_size = static_cast<size_t>(estimate.compressed_bytes * scale + 0.5);
+    row.estimated_ratio = estimate.ratio;
+    row.estimated_ratio_low = estimate.ratio_low;
+    row.estimated_ratio_high = estimate.ratio_high;
+    row.sampled_fraction = file_data.size() ? static_cast<double>(estimate.sampled_bytes) / file_data.size() : 0.0;
+    row.estimated_only = true;
+    return row;
+}
+
+AnalysisResult Analyzer::analyzeArchive(ArchiveCompressor& compressor,
+                                        const std::vector<std::filesystem::path>& file_paths,
+                                        int level,
+                                        const AnalysisOptions& options) {
+    if (file_paths.empty()) {
+        throw std::runtime_error("Archive analysis requires at least one file");
+    }
+    bool stream = options.streaming;
+    if (!stream) {
+        uintmax_t total_size = 0;
+        for (const auto& file_path : file_paths) {
+            std::error_code ec;
+            uintmax_t size = std::filesystem::file_size(file_path, ec);
+            total_size += ec ? 0 : size;
+        }
+        stream = total_size >= options.streaming_threshold;
+    }
+    if (stream) {
+        return analyzeArchiveStreaming(compressor, file_paths, level, options);
+    }
+
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> files;
+    std::vector<std::string> names = ArchiveCompressor::memberNames(file_paths);
+    size_t total_original_size = 0;
+    for (size_t i = 0; i < file_paths.size(); ++i) {
+        checkpoint(options, 0);
+        auto file_data = FileHandler::readFile(file_paths[i]);
+        total_original_size += file_data.size();
+        files.emplace_back(names[i], std::move(file_data));
+    }
+
+    auto result = Benchmark::run([&]() { return compressor.compress(files, level); },
+                                 total_original_size, checkedBenchmark(options));
+    checkpoint(options, 0);
+
+    AnalysisResult row;
+    row.filename = "Archive (" + std::to_string(files.size()) + " files)";
+    row.algorithm = compressor.getAlgorithmLabel(level);
+    row.file_type = "Archive";
+    row.ratio = result.compression_ratio;
+    // Profile the files back to back, as the archive stream sees them
+    EntropyProfiler entropy(options.entropy_window);
+    for (const auto& file : files) {
+        entropy.update(file.second);
+    }
+    copyEntropy(row, entropy.finish());
+    row.compression_time_us = std::chrono::duration_cast<std::chrono::microseconds>(result.compression_time).count();
+    row.decompression_time_us = std::chrono::duration_cast<std::chrono::microseconds>(result.decompression_time).count();
+    row.compression_throughput = result.compression_stats.median;
+    row.decompression_throughput = result.decompression_stats.median;
+    row.original_size = total_original_size;
+    row.compressed_size = result.compressed_size;
+    row.member_extraction_us = result.member_extraction_time.count() / 1000.0;
+    copyStats(row, result);
+    return row;
+}
+
+AnalysisResult Analyzer::analyzeArchiveStreaming(ArchiveCompressor& compressor,
+                                                 const std::vector<std::filesystem::path>& file_paths,
+                                                 int level,
+                                                 const AnalysisOptions& options) {
+    if (file_paths.empty()) {
+        throw std::runtime_error("Archive analysis requires at least one file");
+    }
+    TempFile compressed{FileHandler::createTempFilePath("dca-archive")};
+
+    // Profile member data only, back to back, as the buffered path does
+    PayloadSink payload(options);
+    Compressor::StreamResult compressed_stats;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    {
+        FileSink sink(compressed.path);
+        compressed_stats = compressor.compressFiles(file_paths, sink, level, &payload);
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto compression_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time - payload.overhead());
+
+    ChecksumSink round_trip;
+    CheckedSink checked_round_trip(round_trip, options);
+    start_time = std::chrono::high_resolution_clock::now();
+    auto decompressed_stats = compressor.extractAll(compressed.path, checked_round_trip);
+    end_time = std::chrono::high_resolution_clock::now();
+    auto decompression_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time - checked_round_trip.overhead());
+
+    if (round_trip.size() != payload.checksum().size() || round_trip.crc() != payload.checksum().crc()) {
+        throw std::runtime_error("Round-trip mismatch after streaming archive decompression");
+    }
+
+    double member_extraction_us = 0.0;
+    if (compressor.getOptions().layout == ArchiveCompressor::Layout::Indexed) {
+        std::string middle = ArchiveCompressor::memberNames(file_paths)[file_paths.size() / 2];
+        start_time = std::chrono::high_resolution_clock::now();
+        compressor.extractMember(compressed.path, middle);
+        end_time = std::chrono::high_resolution_clock::now();
+        member_extraction_us = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count() / 1000.0;
+    }
+
+    // Ratio and speeds count member data, like the buffered archive path
+    uint64_t original_size = payload.checksum().size();
+    AnalysisResult row;
+    row.filename = "Archive (" + std::to_string(file_paths.size()) + " files)";
+    row.algorithm = annotateLabel(compressor.getAlgorithmLabel(level), "streamed");
+    row.file_type = "Archive";
+    row.ratio = original_size ? static_cast<double>(compressed_stats.bytes_out) / original_size : 0.0;
+    copyEntropy(row, payload.finish());
+    row.compression_time_us = compression_time.count();
+    row.decompression_time_us = decompression_time.count();
+    row.compression_throughput = FileHandler::calculateThroughput(original_size, compression_time.count());
+    row.decompression_throughput = FileHandler::calculateThroughput(original_size, decompression_time.count());
+    row.compression_stats = Benchmark::summarize({row.compression_throughput});
+    row.decompression_stats = Benchmark::summarize({row.decompression_throughput});
+    row.original_size = original_size;
+    row.compressed_size = compressed_stats.bytes_out;
+    row.compression_setup_us = compressed_stats.setup_time.count() / 1000.0;
+    row.decompression_setup_us = decompressed_stats.setup_time.count() / 1000.0;
+    row.compression_codec_memory = compressed_stats.codec_memory;
+    row.compression_buffer_memory = compressed_stats.buffer_memory;
+    row.decompression_codec_memory = decompressed_stats.codec_memory;
+    row.decompression_buffer_memory = decompressed_stats.buffer_memory;
+    row.memory_used = std::max(compressed_stats.codec_memory + compressed_stats.buffer_memory,
+                               decompressed_stats.codec_memory + decompressed_stats.buffer_memory);
+    row.member_extraction_us = member_extraction_us;
+    return row;
+}
+
+void Analyzer::analyzeFiles(Compressor& compressor,
+                            const std::vector<std::filesystem::path>& file_paths,
+                            const std::vector<int>& levels,
+                            ThreadPool& pool,
+                            ResultCollector& collector,
+                            const AnalysisOptions& options) {
+    struct Job {
+        const std::filesystem::path* path;
+        int level;
+        uintmax_t size;
+        size_t index;  // For options.progress
+    };
+    std::vector<Job> jobs;
+    for (size_t i = 0; i < file_paths.size(); ++i) {
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(file_paths[i], ec);
+        for (size_t j = 0; j < levels.size(); ++j) {
+            jobs.push_back({&file_paths[i], levels[j], ec ? 0 : size, i * levels.size() + j});
+        }
+    }
+    std::stable_sort(jobs.begin(), jobs.end(),
+                     [](const Job& a, const Job& b) { return a.size > b.size; });
+
+    std::vector<std::future<void>> pending;
+    pending.reserve(jobs.size());
+    for (const Job& job : jobs) {
+        pending.push_back(pool.submit([&compressor, &collector, &options, job]() {
+            JobProgress* progress = options.progress;
+            auto finish = [&](JobProgress::Status status, uint64_t bytes) {
+                if (progress) progress->finish(job.index, status, bytes);
+            };
+            if (progress && progress->cancelled()) {
+                finish(JobProgress::Status::Cancelled, 0);
+                return;
+            }
+            if (progress) progress->start(job.index);
+            AnalysisOptions job_options = options;
+            job_options.progress_job = job.index;
+            try {
+                std::string key;
+                if (options.cache) {
+                    key = options.cache->key(compressor, *job.path, job.level, options);
+                }
+                if (!key.empty()) {
+                    if (auto row = options.cache->find(key)) {
+                        // Same content may have been cached under another name
+                        row->filename = job.path->filename().string();
+                        row->cached = true;
+                        collector.add(std::move(*row));
+                        finish(JobProgress::Status::Cached, job.size);
+                        return;
+                    }
+                }
+                AnalysisResult row = analyzeFile(compressor, *job.path, job.level, job_options);
+                if (!key.empty()) {
+                    options.cache->store(key, row);
+                }
+                collector.add(std::move(row));
+                finish(JobProgress::Status::Done, job.size);
+            } catch (const AnalysisCancelled&) {
+                finish(JobProgress::Status::Cancelled, 0);
+            } catch (const std::exception& e) {
+                collector.addError("Error processing file " + job.path->string() + ": " + e.what());
+                // Counted as processed, so the ETA covers the remaining files only
+                finish(JobProgress::Status::Failed, job.size);
+            }
+        }));
+    }
+    for (auto& future : pending) {
+        future.get();
+    }
+}
+
+std::vector<std::string> Analyzer::resultHeaders() {
+    return {
+        "File", "Type", "Algorithm", "Ratio", "Entropy", "Order-1 Entropy", "Order-2 Entropy",
+        "High-Entropy Share (%)", "Original Size (KB)", "Compressed Size (KB)",
+        "Compression Speed (MB/s)", "Decompression Speed (MB/s)", "Time (ms)",
+        "Ratio Cost vs Single Stream (%)", "Compression Setup (us)", "Decompression Setup (us)",
+        "Compression Codec Memory (KB)", "Compression Buffer Memory (KB)",
+        "Decompression Codec Memory (KB)", "Decompression Buffer Memory (KB)",
+        "Repetitions",
+        "Compression MB/s Min", "Compression MB/s Median", "Compression MB/s Mean",
+        "Compression MB/s P95", "Compression MB/s Stddev",
+        "Decompression MB/s Min", "Decompression MB/s Median", "Decompression MB/s Mean",
+        "Decompression MB/s P95", "Decompression MB/s Stddev",
+        "Estimated Ratio", "Estimate 95% Low", "Estimate 95% High", "Sampled (%)", "Estimate Error (%)",
+        "Policy", "Member Extraction (us)"
+    };
+}
+
+std::vector<std::string> Analyzer::resultRow(const AnalysisResult& result) {
+    return {
+        result.filename,
+        result.file_type,
+        result.algorithm,
+        std::to_string(result.ratio),
+        std::to_string(result.entropy),
+        std::to_string(result.entropy_order1),
+        std::to_string(result.entropy_order2),
+        std::to_string(result.high_entropy_fraction * 100.0),
+        std::to_string(result.original_size / 1024.0),
+        std::to_string(result.compressed_size / 1024.0),
+        std::to_string(result.compression_throughput),
+        std::to_string(result.decompression_throughput),
+        std::to_string((result.compression_time_us + result.decompression_time_us) / 1000.0),
+        result.reference_ratio > 0.0 ? std::to_string(ratioCost(result)) : "",
+        std::to_string(result.compression_setup_us),
+        std::to_string(result.decompression_setup_us),
+        std::to_string(result.compression_codec_memory / 1024.0),
+        std::to_string(result.compression_buffer_memory / 1024.0),
+        std::to_string(result.decompression_codec_memory / 1024.0),
+        std::to_string(result.decompression_buffer_memory / 1024.0),
+        std::to_string(result.compression_stats.samples),
+        std::to_string(result.compression_stats.min),
+        std::to_string(result.compression_stats.median),
+        std::to_string(result.compression_stats.mean),
+        std::to_string(result.compression_stats.p95),
+        std::to_string(result.compression_stats.stddev),
+        std::to_string(result.decompression_stats.min),
+        std::to_string(result.decompression_stats.median),
+        std::to_string(result.decompression_stats.mean),
+        std::to_string(result.decompression_stats.p95),
+        std::to_string(result.decompression_stats.stddev),
+        result.estimated_ratio > 0.0 ? std::to_string(result.estimated_ratio) : "",
+        result.estimated_ratio > 0.0 ? std::to_string(result.estimated_ratio_low) : "",
+        result.estimated_ratio > 0.0 ? std::to_string(result.estimated_ratio_high) : "",
+        result.estimated_ratio > 0.0 ? std::to_string(result.sampled_fraction * 100.0) : "",
+        hasEstimateError(result) ? std::to_string(estimateError(result)) : "",
+        result.policy,
+        result.member_extraction_us > 0.0 ? std::to_string(result.member_extraction_us) : ""
+    };
+}
+
+double Analyzer::ratioCost(const AnalysisResult& result) {
+    if (result.reference_ratio <= 0.0) return 0.0;
+    return (result.ratio / result.reference_ratio - 1.0) * 100.0;
+}
+
+bool Analyzer::hasEstimateError(const AnalysisResult& result) {
+    return result.estimated_ratio > 0.0 && !result.estimated_only && result.ratio > 0.0;
+}
+
+double Analyzer::estimateError(const AnalysisResult& result) {
+    if (!hasEstimateError(result)) return 0.0;
+    return (result.estimated_ratio / result.ratio - 1.0) * 100.0;
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "Benchmark.h"
+#include "EntropyProfile.h"
+#include "Estimator.h"
+#include "../compression/Compressor.h"
+
+class ArchiveCompressor;
+class JobProgress;
+class ResultCache;
+class ResultCollector;
+class ThreadPool;
+
+// One row of analysis output, shared by the GUI results table, the batch
+// driver and the CSV/JSON exporters
+struct AnalysisResult {
+    std::string filename;
+    std::string algorithm;
+    std::string file_type;
+    double ratio;
+    double entropy;          // Order-0, bits/byte
+    double entropy_order1 = 0.0;
+    double entropy_order2 = 0.0;
+    double high_entropy_fraction = 0.0;  // Share of bytes in windows likely compressed already
+    std::vector<float> entropy_profile;  // Order-0 entropy per entropy_window bytes
+    long long compression_time_us;
+    long long decompression_time_us;
+    double compression_throughput;  // MB/s, median over repetitions
+    double decompression_throughput;  // MB/s, median over repetitions
+    size_t memory_used;      // Peak codec + buffer bytes of the larger phase
+    size_t original_size;    // Size in bytes
+    size_t compressed_size;  // Size in bytes
+    double reference_ratio = 0.0;  // Single-stream ratio for parallel modes, 0 if not measured
+    double compression_setup_us = 0.0;    // Codec context setup included in compression_time_us
+    double decompression_setup_us = 0.0;  // Codec context setup included in decompression_time_us
+    // Peak bytes per phase: codec state (allocator hooks) and data buffers
+    size_t compression_codec_memory = 0;
+    size_t compression_buffer_memory = 0;
+    size_t decompression_codec_memory = 0;
+    size_t decompression_buffer_memory = 0;
+    ThroughputStats compression_stats;
+    ThroughputStats decompression_stats;
+    // Sampling estimate, when the options asked for one; estimated_ratio is 0
+    // otherwise. If estimated_only, ratio, sizes, times and speeds are the
+    // extrapolated figures rather than those of a full run.
+    double estimated_ratio = 0.0;
+    double estimated_ratio_low = 0.0;   // 95% confidence interval
+    double estimated_ratio_high = 0.0;
+    double sampled_fraction = 0.0;
+    bool estimated_only = false;
+    bool skipped = false;  // Full run skipped because the estimate reached skip_ratio
+    std::string policy;    // Why a per-input compressor (AutoCompressor) chose its setting
+    double member_extraction_us = 0.0;  // Archives: time to extract one member; 0 if not measured
+    bool cached = false;   // Reused from a ResultCache instead of measured in this run
+};
+
+// Settings that apply to a whole analysis run
+struct AnalysisOptions {
+    bool streaming = false;                     // Always use the constant-memory path
+    uint64_t streaming_threshold = 1ull << 30;  // Files at least this large stream anyway
+    BenchmarkOptions benchmark;                 // Buffered paths only; streaming runs once
+    size_t entropy_window = EntropyProfiler::kDefaultWindowSize;  // Bytes per entropy profile point
+
+    // Sampling estimator: Only reports the estimate instead of compressing
+    // whole files; Check runs both and reports how far off the estimate was
+    enum class Estimate { Off, Only, Check };
+    Estimate estimate = Estimate::Off;
+    EstimateOptions estimator;
+    // If positive, files whose estimated ratio is at least this even at the
+    // low end of its interval are not compressed in full (implies estimating)
+    double skip_ratio = 0.0;
+
+    // analyzeFiles reuses the rows of unchanged files from here and stores
+    // the rest; not owned
+    ResultCache* cache = nullptr;
+
+    // Progress and cancellation (see JobProgress); not owned. progress_job
+    // is the job the analysis reports to; analyzeFiles sets it per job.
+    JobProgress* progress = nullptr;
+    size_t progress_job = 0;
+};
+
+class Analyzer {
+public:
+    // Read, compress and measure a single file. Large files (or all files,
+    // if options.streaming) go through analyzeFileStreaming when supported.
+    static AnalysisResult analyzeFile(Compressor& compressor,
+                                      const std::filesystem::path& file_path,
+                                      int level,
+                                      const AnalysisOptions& options = {});
+
+    // Constant-memory variant: compresses to a temp file in chunks, then
+    // streams it back through decompression and checks length and CRC-32
+    // against the original, without ever holding either side in memory
+    static AnalysisResult analyzeFileStreaming(Compressor& compressor,
+                                               const std::filesystem::path& file_path,
+                                               int level,
+                                               const AnalysisOptions& options = {});
+
+    // Estimate ratio and speeds from a sample of blocks without reading the
+    // whole file (see Estimator); the row is marked estimated_only
+    static AnalysisResult estimateFile(Compressor& compressor,
+                                       const std::filesystem::path& file_path,
+                                       int level,
+                                       const AnalysisOptions& options = {});
+
+    // Pack all files into one archive and measure it as a single row. If
+    // options.streaming, or the files total at least streaming_threshold,
+    // this goes through analyzeArchiveStreaming.
+    static AnalysisResult analyzeArchive(ArchiveCompressor& compressor,
+                                         const std::vector<std::filesystem::path>& file_paths,
+                                         int level,
+                                         const AnalysisOptions& options = {});
+
+    // Constant-memory archive: members are read from disk in chunks and
+    // compressed in the configured layout to a temp file, which is then
+    // inflated back and checked by length and CRC-32; no member is ever held
+    // whole in memory. Indexed archives also time one member's extraction.
+    static AnalysisResult analyzeArchiveStreaming(ArchiveCompressor& compressor,
+                                                  const std::vector<std::filesystem::path>& file_paths,
+                                                  int level,
+                                                  const AnalysisOptions& options = {});
+
+    // Analyze every (file, level) pair on the pool, largest files first so
+    // one big file does not end up running alone at the tail of the batch.
+    // Rows and per-file errors go to the collector; blocks until all finish.
+    // With options.cache, a job whose key is cached reports the stored row.
+    // With options.progress, job (i, j) is file i at levels[j], numbered
+    // i * levels.size() + j; cancelled jobs are not errors.
+    static void analyzeFiles(Compressor& compressor,
+                             const std::vector<std::filesystem::path>& file_paths,
+                             const std::vector<int>& levels,
+                             ThreadPool& pool,
+                             ResultCollector& collector,
+                             const AnalysisOptions& options = {});
+
+    // Column names and string cells used by every exporter
+    static std::vector<std::string> resultHeaders();
+    static std::vector<std::string> resultRow(const AnalysisResult& result);
+
+    // Percent larger than the single-stream output (0 if not measured)
+    static double ratioCost(const AnalysisResult& result);
+
+    // Percent by which the sampled estimate missed the full run's ratio;
+    // hasEstimateError is false unless both were measured
+    static bool hasEstimateError(const AnalysisResult& result);
+    static double estimateError(const AnalysisResult& result);
+};
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "Benchmark.h"
+#include "../utils/FileHandler.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// Two-sided 95% Student's t quantiles for 1-30 degrees of freedom
+constexpr double kStudentT95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+// Linear interpolation between closest ranks; sorted must be non-empty
+double percentile(const std::vector<double>& sorted, double fraction) {
+    double rank = fraction * (sorted.size() - 1);
+    size_t lower = static_cast<size_t>(rank);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (rank - lower);
+}
+
+template <typename Duration>
+Duration medianDuration(std::vector<Duration> durations) {
+    std::sort(durations.begin(), durations.end());
+    return durations[durations.size() / 2];
+}
+
+} // namespace
+
+ThroughputStats Benchmark::summarize(std::vector<double> throughputs) {
+    ThroughputStats stats;
+    if (throughputs.empty()) {
+        return stats;
+    }
+    std::sort(throughputs.begin(), throughputs.end());
+    stats.samples = static_cast<unsigned>(throughputs.size());
+    stats.min = throughputs.front();
+    stats.median = percentile(throughputs, 0.5);
+    // The slowest 5% of runs are below this, i.e. p95 latency as throughput
+    stats.p95 = percentile(throughputs, 0.05);
+    stats.mean = std::accumulate(throughputs.begin(), throughputs.end(), 0.0) / throughputs.size();
+    if (throughputs.size() > 1) {
+        double squares = 0.0;
+        for (double value : throughputs) {
+            squares += (value - stats.mean) * (value - stats.mean);
+        }
+        stats.stddev = std::sqrt(squares / (throughputs.size() - 1));
+    }
+    return stats;
+}
+
+double Benchmark::relativeConfidence(const ThroughputStats& stats) {
+    if (stats.samples < 2 || stats.mean <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double t = studentT95(stats.samples - 1);
+    return t * stats.stddev / std::sqrt(static_cast<double>(stats.samples)) / stats.mean;
+}
+
+double Benchmark::studentT95(size_t degrees) {
+    if (degrees == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return degrees <= std::size(kStudentT95) ? kStudentT95[degrees - 1] : 1.96;
+}
+
+Compressor::CompressionResult Benchmark::run(const std::function<Compressor::CompressionResult()>& run_once,
+                                             uint64_t bytes,
+                                             const BenchmarkOptions& options) {
+    for (unsigned i = 0; i < options.warmup_runs; ++i) {
+        if (options.before_run) {
+            options.before_run();
+        }
+        run_once();
+    }
+
+    unsigned minimum = std::max(1u, options.repetitions);
+    if (options.target_ci > 0.0) {
+        minimum = std::max(2u, minimum);
+    }
+    unsigned maximum = options.target_ci > 0.0 ? std::max(minimum, options.max_repetitions) : minimum;
+
+    Compressor::CompressionResult result;
+    std::vector<std::chrono::nanoseconds> compression_times;
+    std::vector<std::chrono::nanoseconds> decompression_times;
+    std::vector<double> compression_throughputs;
+    std::vector<double> decompression_throughputs;
+    size_t memory_used = 0;
+    size_t codec_memory[2] = {0, 0};
+    size_t buffer_memory[2] = {0, 0};
+
+    while (compression_times.size() < maximum) {
+        if (options.before_run) {
+            options.before_run();
+        }
+        result = run_once();
+        compression_times.push_back(result.compression_time);
+        decompression_times.push_back(result.decompression_time);
+        compression_throughputs.push_back(FileHandler::calculateThroughput(bytes, result.compression_time));
+        decompression_throughputs.push_back(FileHandler::calculateThroughput(bytes, result.decompression_time));
+        memory_used = std::max(memory_used, result.memory_used);
+        codec_memory[0] = std::max(codec_memory[0], result.compression_codec_memory);
+        codec_memory[1] = std::max(codec_memory[1], result.decompression_codec_memory);
+        buffer_memory[0] = std::max(buffer_memory[0], result.compression_buffer_memory);
+        buffer_memory[1] = std::max(buffer_memory[1], result.decompression_buffer_memory);
+
+        if (compression_times.size() >= minimum && options.target_ci > 0.0 &&
+            relativeConfidence(summarize(compression_throughputs)) <= options.target_ci &&
+            relativeConfidence(summarize(decompression_throughputs)) <= options.target_ci) {
+            break;
+        }
+    }
+
+    result.compression_time = medianDuration(compression_times);
+    result.decompression_time = medianDuration(decompression_times);
+    result.compression_stats = summarize(std::move(compression_throughputs));
+    result.decompression_stats = summarize(std::move(decompression_throughputs));
+    result.memory_used = memory_used;
+    result.compression_codec_memory = codec_memory[0];
+    result.decompression_codec_memory = codec_memory[1];
+    result.compression_buffer_memory = buffer_memory[0];
+    result.decompression_buffer_memory = buffer_memory[1];
+    return result;
+}
\ No newline at end of file
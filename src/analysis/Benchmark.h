@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "../compression/Compressor.h"
+
+// How many times each measurement is repeated
+struct BenchmarkOptions {
+    unsigned warmup_runs = 0;        // Untimed runs first, to fault in pages and warm caches
+    unsigned repetitions = 1;        // Measured runs (the minimum when target_ci is set)
+    double target_ci = 0.0;          // Keep going until the 95% CI half-width is within this
+                                     // fraction of the mean throughput; 0 = fixed count
+    unsigned max_repetitions = 100;  // Upper bound when chasing target_ci
+    std::function<void()> before_run;  // Called before every run, warmups included; may throw to stop
+};
+
+class Benchmark {
+public:
+    // Call run_once for the warmups and measured repetitions and fold the
+    // results into one: times are per-phase medians, throughput statistics
+    // come from every measured run, memory peaks are the maximum seen, and
+    // everything else is from the last run. bytes is the uncompressed size.
+    static Compressor::CompressionResult run(const std::function<Compressor::CompressionResult()>& run_once,
+                                             uint64_t bytes,
+                                             const BenchmarkOptions& options);
+
+    static ThroughputStats summarize(std::vector<double> throughputs);
+
+    // Half-width of the 95% confidence interval of the mean, relative to the
+    // mean (Student's t, so small sample counts are not overconfident)
+    static double relativeConfidence(const ThroughputStats& stats);
+
+    // Two-sided 95% Student's t quantile for the given degrees of freedom
+    static double studentT95(size_t degrees);
+};
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include "Dedup.h"
+#include "ResultCollector.h"
+#include "../compression/Compressor.h"
+#include "../compression/Stream.h"
+#include "../utils/FileHandler.h"
+#include "../utils/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kArchiveMagic[4] = {'D', 'C', 'A', 'D'};
+constexpr uint32_t kArchiveVersion = 1;
+enum RecordType : uint8_t { kEndRecord = 0, kSegmentRecord = 1, kFileRecord = 2 };
+
+template <typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// Set of fingerprints split into shards with their own lock, so workers
+// rarely wait on each other. Each shard is an open-addressing table with
+// linear probing; an all-zero fingerprint marks an empty slot.
+class FingerprintTable {
+public:
+    // True if the fingerprint was not in the table yet (it is now)
+    bool insert(ChunkFingerprint fingerprint) {
+        if (fingerprint == ChunkFingerprint{}) {
+            fingerprint.low = 1;
+        }
+        Shard& shard = shards_[fingerprint.high >> (64 - kShardBits)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if ((shard.used + 1) * 10 > shard.slots.size() * 7) {
+            grow(shard);
+        }
+        size_t mask = shard.slots.size() - 1;
+        for (size_t i = fingerprint.low & mask;; i = (i + 1) & mask) {
+            ChunkFingerprint& slot = shard.slots[i];
+            if (slot == ChunkFingerprint{}) {
+                slot = fingerprint;
+                ++shard.used;
+                return true;
+            }
+            if (slot == fingerprint) {
+                return false;
+            }
+        }
+    }
+
+    size_t memoryUsage() {
+        size_t bytes = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            bytes += shard.slots.capacity() * sizeof(ChunkFingerprint);
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr unsigned kShardBits = 6;
+
+    struct Shard {
+        std::mutex mutex;
+        std::vector<ChunkFingerprint> slots;
+        size_t used = 0;
+    };
+    std::array<Shard, size_t(1) << kShardBits> shards_;
+
+    static void grow(Shard& shard) {
+        std::vector<ChunkFingerprint> slots(std::max<size_t>(1024, shard.slots.size() * 2));
+        size_t mask = slots.size() - 1;
+        for (const ChunkFingerprint& fingerprint : shard.slots) {
+            if (fingerprint == ChunkFingerprint{}) {
+                continue;
+            }
+            size_t i = fingerprint.low & mask;
+            while (slots[i] != ChunkFingerprint{}) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = fingerprint;
+        }
+        shard.slots.swap(slots);
+    }
+};
+
+// Appends whole records to the archive file; one writer shared by all workers
+class ArchiveWriter {
+public:
+    ArchiveWriter(const std::filesystem::path& path, const std::string& codec_name) : sink_(path) {
+        std::vector<uint8_t> header(kArchiveMagic, kArchiveMagic + sizeof(kArchiveMagic));
+        put(header, kArchiveVersion);
+        put(header, static_cast<uint32_t>(codec_name.size()));
+        header.insert(header.end(), codec_name.begin(), codec_name.end());
+        write(header);
+    }
+
+    void write(const std::vector<uint8_t>& record) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sink_.write(record.data(), record.size());
+        bytes_written_ += record.size();
+    }
+
+    uint64_t finish(uint64_t file_count) {
+        std::vector<uint8_t> end;
+        put(end, static_cast<uint8_t>(kEndRecord));
+        put(end, file_count);
+        write(end);
+        sink_.flush();
+        return bytes_written_;
+    }
+
+private:
+    std::mutex mutex_;
+    FileSink sink_;
+    uint64_t bytes_written_ = 0;
+};
+
+struct FileTotals {
+    uint64_t bytes = 0;
+    uint64_t chunks = 0;
+    uint64_t unique_chunks = 0;
+    uint64_t unique_bytes = 0;
+    uint64_t compressed_bytes = 0;
+};
+
+// Chunks one file a segment at a time: the input buffer holds a segment plus
+// one maximum-size chunk of lookahead, and only the segment's new chunks are
+// kept for compression
+FileTotals dedupFile(Compressor& compressor, const std::filesystem::path& path, uint64_t file_id,
+                     const ContentChunker& chunker, const DedupOptions& options, FingerprintTable& table,
+                     ArchiveWriter* archive) {
+    FileTotals totals;
+    FileSource source(path);
+    std::vector<uint8_t> input(options.segment_size + chunker.maxSize());
+    size_t filled = 0;
+    size_t pos = 0;
+    bool eof = false;
+    auto refill = [&]() {
+        std::memmove(input.data(), input.data() + pos, filled - pos);
+        filled -= pos;
+        pos = 0;
+        while (!eof && filled < input.size()) {
+            size_t count = source.read(input.data() + filled, input.size() - filled);
+            eof = count == 0;
+            filled += count;
+        }
+    };
+
+    std::vector<uint8_t> unique;
+    unique.reserve(options.segment_size + chunker.maxSize());
+    // Not a ScratchArena buffer: compressInto may use the arena itself
+    // (AutoCompressor runs its trials there)
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> record;
+    uint32_t segment_chunks = 0;
+    uint64_t segment_bytes = 0;
+    auto begin_segment = [&]() {
+        unique.clear();
+        segment_chunks = 0;
+        segment_bytes = 0;
+        if (archive) {
+            record.clear();
+            put(record, static_cast<uint8_t>(kSegmentRecord));
+            put(record, file_id);
+            put(record, uint32_t(0));  // Chunk count, patched in flush_segment
+        }
+    };
+    auto flush_segment = [&]() {
+        if (segment_chunks == 0) {
+            return;
+        }
+        size_t compressed_size = 0;
+        if (!unique.empty()) {
+            compressed.resize(compressor.compressBound(unique.size(), options.level));
+            compressed_size = compressor.compressInto(unique, compressed, options.level);
+            totals.compressed_bytes += compressed_size;
+        }
+        if (archive) {
+            std::memcpy(record.data() + 1 + sizeof(uint64_t), &segment_chunks, sizeof(segment_chunks));
+            put(record, static_cast<uint64_t>(unique.size()));
+            put(record, static_cast<uint64_t>(compressed_size));
+            record.insert(record.end(), compressed.data(), compressed.data() + compressed_size);
+            archive->write(record);
+        }
+        begin_segment();
+    };
+
+    begin_segment();
+    refill();
+    while (pos < filled) {
+        if (!eof && filled - pos < chunker.maxSize()) {
+            refill();
+        }
+        ByteView chunk(input.data() + pos, chunker.next(ByteView(input.data() + pos, filled - pos)));
+        ChunkFingerprint fingerprint = ChunkFingerprint::of(chunk);
+        bool is_new = table.insert(fingerprint);
+        ++totals.chunks;
+        if (is_new) {
+            ++totals.unique_chunks;
+            totals.unique_bytes += chunk.size();
+            unique.insert(unique.end(), chunk.begin(), chunk.end());
+        }
+        if (archive) {
+            put(record, fingerprint.high);
+            put(record, fingerprint.low);
+            put(record, static_cast<uint32_t>(chunk.size()));
+            put(record, static_cast<uint8_t>(is_new));
+        }
+        ++segment_chunks;
+        segment_bytes += chunk.size();
+        totals.bytes += chunk.size();
+        pos += chunk.size();
+        if (segment_bytes >= options.segment_size) {
+            flush_segment();
+        }
+    }
+    flush_segment();
+
+    if (archive) {
+        std::string name = path.string();
+        record.clear();
+        put(record, static_cast<uint8_t>(kFileRecord));
+        put(record, file_id);
+        put(record, static_cast<uint32_t>(name.size()));
+        record.insert(record.end(), name.begin(), name.end());
+        put(record, totals.bytes);
+        archive->write(record);
+    }
+    return totals;
+}
+
+} // namespace
+
+DedupResult Dedup::run(Compressor& compressor,
+                       const std::vector<std::filesystem::path>& file_paths,
+                       const DedupOptions& options,
+                       ThreadPool& pool,
+                       ResultCollector& collector) {
+    ContentChunker chunker(options.chunking);
+    if (options.segment_size == 0) {
+        throw std::invalid_argument("Dedup segment size must be positive");
+    }
+    std::unique_ptr<ArchiveWriter> archive;
+    if (!options.archive_path.empty()) {
+        archive = std::make_unique<ArchiveWriter>(options.archive_path, compressor.getName());
+    }
+
+    struct Job {
+        const std::filesystem::path* path;
+        uint64_t file_id;
+        uintmax_t size;
+    };
+    std::vector<Job> jobs;
+    for (size_t i = 0; i < file_paths.size(); ++i) {
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(file_paths[i], ec);
+        jobs.push_back({&file_paths[i], i, ec ? 0 : size});
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.size > b.size; });
+
+    FingerprintTable table;
+    std::mutex totals_mutex;
+    size_t failed = 0;
+    DedupResult result;
+    result.algorithm = compressor.getAlgorithmLabel(options.level);
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> pending;
+    pending.reserve(jobs.size());
+    for (const Job& job : jobs) {
+        pending.push_back(pool.submit([&, job]() {
+            try {
+                FileTotals totals = dedupFile(compressor, *job.path, job.file_id, chunker, options, table,
+                                              archive.get());
+                std::lock_guard<std::mutex> lock(totals_mutex);
+                ++result.files;
+                result.total_bytes += totals.bytes;
+                result.chunks += totals.chunks;
+                result.unique_chunks += totals.unique_chunks;
+                result.unique_bytes += totals.unique_bytes;
+                result.compressed_bytes += totals.compressed_bytes;
+            } catch (const std::exception& e) {
+                collector.addError("Error deduplicating file " + job.path->string() + ": " + e.what());
+                std::lock_guard<std::mutex> lock(totals_mutex);
+                ++failed;
+            }
+        }));
+    }
+    for (auto& future : pending) {
+        future.get();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+
+    if (archive && failed) {
+        // The failed files' chunks are in the table but some were never
+        // written, and other files may reference them
+        archive.reset();
+        std::error_code ec;
+        std::filesystem::remove(options.archive_path, ec);
+        collector.addError("Dedup archive not written: " + std::to_string(failed) + " file(s) failed");
+    } else if (archive) {
+        result.archive_size = archive->finish(result.files);
+    }
+    if (result.total_bytes) {
+        result.dedup_ratio = static_cast<double>(result.unique_bytes) / result.total_bytes;
+        result.combined_ratio = static_cast<double>(result.compressed_bytes) / result.total_bytes;
+    }
+    result.throughput = FileHandler::calculateThroughput(
+        result.total_bytes, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+    result.index_memory = table.memoryUsage();
+    return result;
+}
+
+std::vector<std::string> Dedup::reportHeaders() {
+    return {"Algorithm", "Files", "Total (KB)", "Chunks", "Unique Chunks", "Avg Chunk (KB)", "Unique (KB)",
+            "Dedup Ratio", "Comp (KB)", "Combined Ratio", "MB/s", "Index (KB)", "Archive (KB)"};
+}
+
+std::vector<std::string> Dedup::reportRow(const DedupResult& result) {
+    double average_chunk = result.chunks ? static_cast<double>(result.total_bytes) / result.chunks : 0.0;
+    return {
+        result.algorithm,
+        std::to_string(result.files),
+        std::to_string(result.total_bytes / 1024.0),
+        std::to_string(result.chunks),
+        std::to_string(result.unique_chunks),
+        std::to_string(average_chunk / 1024.0),
+        std::to_string(result.unique_bytes / 1024.0),
+        std::to_string(result.dedup_ratio),
+        std::to_string(result.compressed_bytes / 1024.0),
+        std::to_string(result.combined_ratio),
+        std::to_string(result.throughput),
+        std::to_string(result.index_memory / 1024.0),
+        std::to_string(result.archive_size / 1024.0)
+    };
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../utils/ContentChunker.h"
+
+class Compressor;
+class ResultCollector;
+class ThreadPool;
+
+struct DedupOptions {
+    ContentChunker::Options chunking;
+    int level = 6;
+    // Input bytes per segment: unique chunks are compressed one segment at a
+    // time, which bounds memory per worker to a few segments
+    size_t segment_size = 4 * 1024 * 1024;
+    // Write a deduplicated archive here if set (see Dedup::run)
+    std::filesystem::path archive_path;
+};
+
+// Totals over every file of a dedup run. Ratios are output / input, like
+// AnalysisResult::ratio, so lower is better.
+struct DedupResult {
+    std::string algorithm;             // Label of the codec used on unique chunks
+    size_t files = 0;
+    uint64_t total_bytes = 0;
+    uint64_t chunks = 0;
+    uint64_t unique_chunks = 0;
+    uint64_t unique_bytes = 0;
+    uint64_t compressed_bytes = 0;     // Unique chunks after compression
+    double dedup_ratio = 0.0;          // unique_bytes / total_bytes
+    double combined_ratio = 0.0;       // compressed_bytes / total_bytes
+    double throughput = 0.0;           // MB/s of input over the wall-clock time
+    size_t index_memory = 0;           // Bytes held by the fingerprint table
+    uint64_t archive_size = 0;         // 0 unless an archive was written
+};
+
+class Dedup {
+public:
+    // Chunk every file on the pool, largest first, streaming it from disk a
+    // segment at a time. Chunks are looked up in one fingerprint table shared
+    // by all workers, so duplicates are found across files; the first chunk
+    // to be inserted counts as unique. Unique chunks are compressed with the
+    // compressor (which needs compressInto) per segment. Memory is a few
+    // segments per worker plus 23 to 46 bytes per unique chunk for the table.
+    // Errors for single files go to the collector; if any file fails, the
+    // archive is deleted rather than left with missing chunks. Throws
+    // std::invalid_argument for bad chunk sizes, std::runtime_error if the
+    // archive cannot be written.
+    //
+    // Archive layout (all integers little-endian), records in completion order:
+    //   "DCAD" u32 version, u32 codec_name_len, codec_name
+    //   segment: u8 1, u64 file_id, u32 chunk_count,
+    //            chunk_count x {fingerprint (16 bytes), u32 size, u8 stored_here},
+    //            u64 raw_size, u64 compressed_size, compressed bytes of the
+    //            stored_here chunks in order
+    //   file:    u8 2, u64 file_id, u32 name_len, name, u64 size (after its segments)
+    //   end:     u8 0, u64 file_count (files with a file record)
+    // A file's segments are in order, but a chunk may be referenced before
+    // the segment storing it, so readers index every segment first.
+    static DedupResult run(Compressor& compressor,
+                           const std::vector<std::filesystem::path>& file_paths,
+                           const DedupOptions& options,
+                           ThreadPool& pool,
+                           ResultCollector& collector);
+
+    // Column names and string cells for the report
+    static std::vector<std::string> reportHeaders();
+    static std::vector<std::string> reportRow(const DedupResult& result);
+};
\ No newline at end of file
@@ -0,0 +1,307 @@
+#include "EntropyProfile.h"
+#include "../utils/FileHandler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+// Context tables are folded into 64-bit totals at least this often, so no
+// 32-bit counter can wrap
+constexpr uint64_t kFoldBytes = uint64_t(1) << 31;
+
+// Smallest slice worth a thread of its own
+constexpr size_t kMinSlice = 16 * 1024 * 1024;
+
+// H(X | context) from a [context][byte] count table
+template <typename Count>
+double conditionalEntropy(const std::vector<Count>& counts) {
+    double bits = 0.0;
+    uint64_t total = 0;
+    for (size_t context = 0; context < counts.size(); context += 256) {
+        uint64_t row = 0;
+        double row_bits = 0.0;
+        for (size_t byte = 0; byte < 256; ++byte) {
+            uint64_t count = counts[context + byte];
+            if (count == 0) continue;
+            row += count;
+            row_bits += count * std::log2(static_cast<double>(count));
+        }
+        if (row == 0) continue;
+        bits += row * std::log2(static_cast<double>(row)) - row_bits;
+        total += row;
+    }
+    return total ? bits / total : 0.0;
+}
+
+// Same from (context << 8 | byte) keys, one per counted byte; sorts them
+double sparseConditionalEntropy(std::vector<uint32_t>& keys) {
+    std::sort(keys.begin(), keys.end());
+    double bits = 0.0;
+    for (size_t begin = 0; begin < keys.size();) {
+        uint32_t context = keys[begin] >> 8;
+        size_t end = begin;
+        double row_bits = 0.0;
+        while (end < keys.size() && keys[end] >> 8 == context) {
+            size_t run = end + 1;
+            while (run < keys.size() && keys[run] == keys[end]) ++run;
+            row_bits += (run - end) * std::log2(static_cast<double>(run - end));
+            end = run;
+        }
+        uint64_t row = end - begin;
+        bits += row * std::log2(static_cast<double>(row)) - row_bits;
+        begin = end;
+    }
+    return keys.empty() ? 0.0 : bits / keys.size();
+}
+
+// Cleared context tables left by the thread's last dense profile, so a run
+// over many files allocates them once per worker
+struct SpareTables {
+    std::vector<uint32_t> order1;
+    std::vector<uint32_t> order2;
+};
+
+SpareTables& spareTables() {
+    thread_local SpareTables spare;
+    return spare;
+}
+
+} // namespace
+
+EntropyProfiler::EntropyProfiler(size_t window_size) : window_size_(window_size) {
+    if (window_size < kMinWindowSize) {
+        throw std::invalid_argument("Entropy window must be at least " + std::to_string(kMinWindowSize) +
+                                    " bytes, got " + std::to_string(window_size));
+    }
+}
+
+EntropyProfiler::~EntropyProfiler() {
+    releaseTables();
+}
+
+void EntropyProfiler::update(ByteView data) {
+    if (!dense() && sparse_.size() + data.size() <= kSparseLimit) {
+        sparse_.insert(sparse_.end(), data.begin(), data.end());
+    } else {
+        if (!dense()) makeDense();
+        size_t offset = 0;
+        while (offset < data.size()) {
+            size_t take = static_cast<size_t>(std::min<uint64_t>(data.size() - offset, kFoldBytes - unfolded_bytes_));
+            countContexts(data.data() + offset, take);
+            unfolded_bytes_ += take;
+            if (unfolded_bytes_ == kFoldBytes) fold();
+            offset += take;
+        }
+    }
+
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t take = std::min(window_size_ - window_fill_, data.size() - offset);
+        ByteHistogram::accumulate(data.subview(offset, take), window_counts_);
+        window_fill_ += take;
+        offset += take;
+        if (window_fill_ == window_size_) closeWindow();
+    }
+}
+
+void EntropyProfiler::makeDense() {
+    SpareTables& spare = spareTables();
+    if (!spare.order1.empty()) {
+        order1_.swap(spare.order1);
+        order2_.swap(spare.order2);
+    } else {
+        order1_.assign(kOrder1Contexts * 256, 0);
+        order2_.assign(kOrder2Contexts * 256, 0);
+    }
+    countContexts(sparse_.data(), sparse_.size());
+    unfolded_bytes_ += sparse_.size();
+    std::vector<uint8_t>().swap(sparse_);
+}
+
+void EntropyProfiler::releaseTables() {
+    if (!dense()) return;
+    SpareTables& spare = spareTables();
+    if (spare.order1.empty()) {
+        std::fill(order1_.begin(), order1_.end(), 0);
+        std::fill(order2_.begin(), order2_.end(), 0);
+        order1_.swap(spare.order1);
+        order2_.swap(spare.order2);
+    }
+    std::vector<uint32_t>().swap(order1_);
+    std::vector<uint32_t>().swap(order2_);
+}
+
+void EntropyProfiler::countContexts(const uint8_t* data, size_t size) {
+    size_t i = 0;
+    // The first bytes of the input have no (or only a partial) context
+    for (; i < size && history_length_ < 2; ++i) {
+        if (history_length_ == 1) {
+            order1_[(size_t(history_[1]) << 8) | data[i]]++;
+        }
+        history_[0] = history_[1];
+        history_[1] = data[i];
+        history_length_++;
+    }
+
+    uint32_t* order1 = order1_.data();
+    uint32_t* order2 = order2_.data();
+    size_t prev2 = history_[0];
+    size_t prev1 = history_[1];
+    for (; i < size; ++i) {
+        size_t byte = data[i];
+        order1[(prev1 << 8) | byte]++;
+        order2[(((prev2 >> 4) << 8 | prev1) << 8) | byte]++;
+        prev2 = prev1;
+        prev1 = byte;
+    }
+    history_[0] = static_cast<uint8_t>(prev2);
+    history_[1] = static_cast<uint8_t>(prev1);
+}
+
+void EntropyProfiler::closeWindow() {
+    double entropy = FileHandler::calculateEntropy(window_counts_);
+    windows_.push_back(static_cast<float>(entropy));
+    if (entropy >= EntropyProfile::kStoredThreshold) {
+        high_entropy_bytes_ += window_fill_;
+    }
+    for (size_t byte = 0; byte < 256; ++byte) {
+        total_counts_[byte] += window_counts_[byte];
+    }
+    window_counts_.fill(0);
+    window_fill_ = 0;
+}
+
+void EntropyProfiler::fold() {
+    if (order1_totals_.empty()) {
+        order1_totals_.assign(order1_.size(), 0);
+        order2_totals_.assign(order2_.size(), 0);
+    }
+    for (size_t i = 0; i < order1_.size(); ++i) {
+        order1_totals_[i] += order1_[i];
+    }
+    for (size_t i = 0; i < order2_.size(); ++i) {
+        order2_totals_[i] += order2_[i];
+    }
+    std::fill(order1_.begin(), order1_.end(), 0);
+    std::fill(order2_.begin(), order2_.end(), 0);
+    unfolded_bytes_ = 0;
+}
+
+void EntropyProfiler::append(EntropyProfiler& next) {
+    if (!dense()) makeDense();
+    if (!next.dense()) next.makeDense();
+    fold();
+    for (size_t i = 0; i < order1_.size(); ++i) {
+        order1_totals_[i] += next.order1_[i] + (next.order1_totals_.empty() ? 0 : next.order1_totals_[i]);
+    }
+    for (size_t i = 0; i < order2_.size(); ++i) {
+        order2_totals_[i] += next.order2_[i] + (next.order2_totals_.empty() ? 0 : next.order2_totals_[i]);
+    }
+    history_[0] = next.history_[0];
+    history_[1] = next.history_[1];
+
+    windows_.insert(windows_.end(), next.windows_.begin(), next.windows_.end());
+    high_entropy_bytes_ += next.high_entropy_bytes_;
+    for (size_t byte = 0; byte < 256; ++byte) {
+        total_counts_[byte] += next.total_counts_[byte];
+    }
+    window_counts_ = next.window_counts_;
+    window_fill_ = next.window_fill_;
+}
+
+EntropyProfile EntropyProfiler::finish() {
+    if (window_fill_ > 0) closeWindow();
+
+    EntropyProfile profile;
+    profile.window_size = window_size_;
+    profile.windows = std::move(windows_);
+    profile.order0 = FileHandler::calculateEntropy(total_counts_);
+    if (!dense()) {
+        // Same contexts as countContexts, as keys instead of table cells
+        std::vector<uint32_t> order1;
+        std::vector<uint32_t> order2;
+        order1.reserve(sparse_.size());
+        order2.reserve(sparse_.size());
+        uint32_t prev2 = history_[0];
+        uint32_t prev1 = history_[1];
+        unsigned length = history_length_;
+        for (uint32_t byte : sparse_) {
+            if (length >= 1) order1.push_back(prev1 << 8 | byte);
+            if (length >= 2) order2.push_back((((prev2 >> 4) << 8 | prev1) << 8) | byte);
+            prev2 = prev1;
+            prev1 = byte;
+            length = std::min(length + 1, 2u);
+        }
+        profile.order1 = sparseConditionalEntropy(order1);
+        profile.order2 = sparseConditionalEntropy(order2);
+    } else if (order1_totals_.empty()) {
+        // Never folded, so the 32-bit tables hold every count
+        profile.order1 = conditionalEntropy(order1_);
+        profile.order2 = conditionalEntropy(order2_);
+    } else {
+        fold();
+        profile.order1 = conditionalEntropy(order1_totals_);
+        profile.order2 = conditionalEntropy(order2_totals_);
+    }
+    releaseTables();
+    uint64_t total = 0;
+    for (uint64_t count : total_counts_) {
+        total += count;
+    }
+    profile.high_entropy_fraction = total ? static_cast<double>(high_entropy_bytes_) / total : 0.0;
+    return profile;
+}
+
+EntropyProfile EntropyProfiler::profile(ByteView data, size_t window_size, unsigned max_threads) {
+    size_t threads = max_threads ? max_threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, data.size() / kMinSlice);
+    if (data.size() < ByteHistogram::kParallelThreshold || threads <= 1) {
+        EntropyProfiler profiler(window_size);
+        profiler.update(data);
+        return profiler.finish();
+    }
+
+    // Slices start on window boundaries so no window straddles two threads,
+    // and each is seeded with the two bytes before it so every context counts
+    size_t slice = (data.size() + threads - 1) / threads;
+    slice = (slice + window_size - 1) / window_size * window_size;
+    std::vector<EntropyProfiler> profilers;
+    for (size_t offset = 0; offset < data.size(); offset += slice) {
+        profilers.emplace_back(window_size);
+        if (offset > 0) {
+            profilers.back().history_[0] = data[offset - 2];
+            profilers.back().history_[1] = data[offset - 1];
+            profilers.back().history_length_ = 2;
+        }
+    }
+    auto run = [&data, &profilers, slice](size_t i) {
+        size_t offset = i * slice;
+        profilers[i].update(data.subview(offset, std::min(slice, data.size() - offset)));
+    };
+
+    std::vector<std::thread> workers;
+    size_t inline_from = 1;
+    for (; inline_from < profilers.size(); ++inline_from) {
+        try {
+            workers.emplace_back(run, inline_from);
+        } catch (const std::system_error&) {
+            break;  // Out of threads; the rest is profiled here
+        }
+    }
+    run(0);
+    for (size_t i = inline_from; i < profilers.size(); ++i) {
+        run(i);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (size_t i = 1; i < profilers.size(); ++i) {
+        profilers[0].append(profilers[i]);
+    }
+    return profilers[0].finish();
+}
\ No newline at end of file
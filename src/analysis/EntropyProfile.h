@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../utils/ByteHistogram.h"
+#include "../utils/ByteView.h"
+#include <cstdint>
+#include <vector>
+
+// Entropy figures for one input, in bits per byte
+struct EntropyProfile {
+    size_t window_size = 0;
+    std::vector<float> windows;  // Order-0 entropy of each window; the last may be shorter
+    double order0 = 0.0;
+    double order1 = 0.0;  // Conditioned on the previous byte
+    double order2 = 0.0;  // Conditioned on the previous byte and the high nibble of the one before
+    // Share of bytes in windows at or above kStoredThreshold, i.e. regions
+    // that are likely compressed already and better stored than deflated
+    double high_entropy_fraction = 0.0;
+
+    static constexpr double kStoredThreshold = 7.5;
+};
+
+// Builds an EntropyProfile in one pass over data fed in arbitrary chunks.
+// Order-2 contexts keep only the high nibble of the older byte so the count
+// table stays at 4 MiB; the figure is therefore an upper bound on the exact
+// order-2 entropy, but never above order-1.
+// Inputs up to kSparseLimit bytes are kept and their contexts counted by
+// sorting at finish(), since clearing and scanning the tables would cost far
+// more than the data. Larger inputs use the tables, borrowed from a spare
+// set kept per thread.
+class EntropyProfiler {
+public:
+    static constexpr size_t kDefaultWindowSize = 64 * 1024;
+    static constexpr size_t kMinWindowSize = 1024;
+    static constexpr size_t kSparseLimit = 64 * 1024;
+
+    // Throws std::invalid_argument if window_size is below kMinWindowSize
+    explicit EntropyProfiler(size_t window_size = kDefaultWindowSize);
+    ~EntropyProfiler();
+    EntropyProfiler(EntropyProfiler&&) = default;
+    EntropyProfiler& operator=(EntropyProfiler&&) = default;
+
+    void update(ByteView data);
+    // Closes the last window and computes the figures; call once
+    EntropyProfile finish();
+
+    // Profile of a whole buffer. Large inputs are split on window boundaries
+    // and profiled on up to max_threads threads (0 = hardware concurrency).
+    static EntropyProfile profile(ByteView data, size_t window_size = kDefaultWindowSize,
+                                  unsigned max_threads = 0);
+
+private:
+    static constexpr size_t kOrder1Contexts = 256;
+    static constexpr size_t kOrder2Contexts = 256 * 16;
+
+    size_t window_size_;
+    size_t window_fill_ = 0;
+    ByteHistogram::Counts window_counts_{};
+    ByteHistogram::Counts total_counts_{};
+    std::vector<float> windows_;
+    uint64_t high_entropy_bytes_ = 0;
+
+    // Context counts as [context][byte], empty until the input outgrows
+    // sparse_. The 32-bit tables are folded into the 64-bit totals before
+    // they can wrap.
+    uint8_t history_[2] = {0, 0};
+    unsigned history_length_ = 0;  // Bytes of history_ that are valid, up to 2
+    uint64_t unfolded_bytes_ = 0;
+    std::vector<uint8_t> sparse_;  // Input not counted yet; follows history_
+    std::vector<uint32_t> order1_;
+    std::vector<uint32_t> order2_;
+    std::vector<uint64_t> order1_totals_;
+    std::vector<uint64_t> order2_totals_;
+
+    bool dense() const { return !order1_.empty(); }
+    // Takes the tables and counts the kept input into them
+    void makeDense();
+    // Returns the tables, cleared, to the thread's spare set
+    void releaseTables();
+    void countContexts(const uint8_t* data, size_t size);
+    void closeWindow();
+    void fold();
+    // Appends a profiler that continued exactly where this one stopped,
+    // on a window boundary
+    void append(EntropyProfiler& next);
+};
\ No newline at end of file
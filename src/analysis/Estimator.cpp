@@ -0,0 +1,102 @@
+#include "Estimator.h"
+#include "Benchmark.h"
+#include "../utils/FileHandler.h"
+#include "../utils/ScratchArena.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+CompressibilityEstimate Estimator::estimate(Compressor& compressor, ByteView data, int level,
+                                            const EstimateOptions& options) {
+    if (options.block_size == 0) {
+        throw std::invalid_argument("Estimator block size must be positive");
+    }
+    if (options.blocks < 2) {
+        throw std::invalid_argument("Estimator needs at least 2 sample blocks");
+    }
+
+    CompressibilityEstimate estimate;
+    if (data.empty()) {
+        return estimate;
+    }
+
+    // An input no bigger than the sample is compressed whole: splitting it
+    // would bias the ratio by the block boundaries, and the interval would
+    // still claim zero width
+    size_t block_size = options.block_size;
+    size_t total_blocks = (data.size() + block_size - 1) / block_size;
+    std::vector<size_t> picks;
+    if (total_blocks <= options.blocks) {
+        block_size = data.size();
+        total_blocks = 1;
+        picks.push_back(0);
+    } else {
+        // One block from each stratum keeps every region of the input in the
+        // sample. Seeded from the size so reruns look at the same blocks.
+        std::mt19937_64 rng(data.size());
+        for (size_t s = 0; s < options.blocks; ++s) {
+            size_t begin = s * total_blocks / options.blocks;
+            size_t end = (s + 1) * total_blocks / options.blocks;
+            picks.push_back(begin + rng() % (end - begin));
+        }
+    }
+
+    ScratchArena& arena = ScratchArena::local();
+    MutableByteView compressed = arena.buffer(ScratchArena::Compressed, compressor.compressBound(block_size, level));
+    MutableByteView decompressed = arena.buffer(ScratchArena::Decompressed, block_size);
+
+    std::vector<double> original_sizes;
+    std::vector<double> compressed_sizes;
+    std::chrono::nanoseconds compression_time{0};
+    std::chrono::nanoseconds decompression_time{0};
+    for (size_t pick : picks) {
+        size_t offset = pick * block_size;
+        ByteView block = data.subview(offset, std::min(block_size, data.size() - offset));
+
+        auto start = std::chrono::steady_clock::now();
+        size_t compressed_size = compressor.compressInto(block, compressed, level);
+        auto middle = std::chrono::steady_clock::now();
+        size_t restored = compressor.decompressInto(ByteView(compressed.data(), compressed_size),
+                                                    MutableByteView(decompressed.data(), block.size()));
+        auto end = std::chrono::steady_clock::now();
+        if (restored != block.size() || std::memcmp(decompressed.data(), block.data(), block.size()) != 0) {
+            throw std::runtime_error("Round-trip mismatch in sampled block at offset " + std::to_string(offset));
+        }
+
+        compression_time += middle - start;
+        decompression_time += end - middle;
+        original_sizes.push_back(static_cast<double>(block.size()));
+        compressed_sizes.push_back(static_cast<double>(compressed_size));
+        estimate.sampled_bytes += block.size();
+        estimate.compressed_bytes += compressed_size;
+        ByteHistogram::accumulate(block, estimate.histogram);
+    }
+
+    size_t n = picks.size();
+    estimate.blocks = n;
+    estimate.ratio = static_cast<double>(estimate.compressed_bytes) / estimate.sampled_bytes;
+    estimate.compression_throughput = FileHandler::calculateThroughput(estimate.sampled_bytes, compression_time);
+    estimate.decompression_throughput = FileHandler::calculateThroughput(estimate.sampled_bytes, decompression_time);
+
+    // Variance of a ratio estimator under simple random sampling with the
+    // finite population correction. Stratification only lowers the true
+    // variance, so the interval errs on the wide side.
+    double half_width = 0.0;
+    if (n < total_blocks) {
+        double mean_size = static_cast<double>(estimate.sampled_bytes) / n;
+        double residuals = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double residual = compressed_sizes[i] - estimate.ratio * original_sizes[i];
+            residuals += residual * residual;
+        }
+        double variance = (1.0 - static_cast<double>(n) / total_blocks) * (residuals / (n - 1)) /
+                          (n * mean_size * mean_size);
+        half_width = Benchmark::studentT95(n - 1) * std::sqrt(variance);
+    }
+    estimate.ratio_low = std::max(0.0, estimate.ratio - half_width);
+    estimate.ratio_high = estimate.ratio + half_width;
+    return estimate;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../compression/Compressor.h"
+#include "../utils/ByteHistogram.h"
+#include "../utils/ByteView.h"
+
+// How much of an input the sampling estimator compresses
+struct EstimateOptions {
+    size_t block_size = 128 * 1024;  // Bytes per sampled block
+    size_t blocks = 32;              // Blocks per input, at least 2
+};
+
+// Ratio and throughput extrapolated from a sample of blocks
+struct CompressibilityEstimate {
+    double ratio = 0.0;
+    double ratio_low = 0.0;   // 95% confidence interval of ratio
+    double ratio_high = 0.0;
+    double compression_throughput = 0.0;    // MB/s over the sampled bytes
+    double decompression_throughput = 0.0;
+    uint64_t sampled_bytes = 0;
+    uint64_t compressed_bytes = 0;
+    size_t blocks = 0;
+    ByteHistogram::Counts histogram{};  // Of the sampled bytes
+};
+
+class Estimator {
+public:
+    // Compresses and round-trips options.blocks blocks, one from each of as
+    // many equal strata of data, and extrapolates to the whole input. Blocks
+    // are compressed independently, so for codecs whose window reaches past
+    // block_size the estimate leans pessimistic. Inputs of no more blocks
+    // than that are compressed whole, so their ratio is exact.
+    // Throws std::invalid_argument for bad options and std::runtime_error if
+    // a block does not survive the round trip.
+    static CompressibilityEstimate estimate(Compressor& compressor, ByteView data, int level,
+                                            const EstimateOptions& options = {});
+};
\ No newline at end of file
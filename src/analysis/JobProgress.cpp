@@ -0,0 +1,60 @@
+#include "JobProgress.h"
+#include <algorithm>
+
+JobProgress::JobProgress(size_t jobs, uint64_t total_bytes)
+    : jobs_(jobs), total_bytes_(total_bytes), start_time_(std::chrono::steady_clock::now()),
+      analysis_start_(start_time_.time_since_epoch().count()),
+      status_(new std::atomic<uint8_t>[jobs]), job_bytes_(new std::atomic<uint64_t>[jobs]) {
+    for (size_t i = 0; i < jobs; ++i) {
+        status_[i].store(static_cast<uint8_t>(Status::Pending), std::memory_order_relaxed);
+        job_bytes_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void JobProgress::addBytes(size_t job, uint64_t bytes) {
+    job_bytes_[job].fetch_add(bytes, std::memory_order_relaxed);
+    processed_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void JobProgress::finish(size_t job, Status status, uint64_t job_bytes) {
+    // Only the job's own worker touches its counter. A streamed file may
+    // have been read past the size it had when the run started.
+    uint64_t counted = job_bytes_[job].load(std::memory_order_relaxed);
+    if (job_bytes > counted) {
+        job_bytes_[job].store(job_bytes, std::memory_order_relaxed);
+        processed_.fetch_add(job_bytes - counted, std::memory_order_relaxed);
+    }
+    setStatus(job, status);
+}
+
+void JobProgress::endPreparing() {
+    analysis_start_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    preparing_.store(false, std::memory_order_relaxed);
+}
+
+double JobProgress::fraction() const {
+    return total_bytes_ ? std::min(1.0, static_cast<double>(processedBytes()) / total_bytes_) : 0.0;
+}
+
+double JobProgress::etaSeconds() const {
+    uint64_t processed = processedBytes();
+    if (processed == 0) {
+        return -1.0;
+    }
+    std::chrono::steady_clock::duration since(analysis_start_.load(std::memory_order_relaxed));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch() - since).count();
+    uint64_t remaining = total_bytes_ > processed ? total_bytes_ - processed : 0;
+    return seconds * remaining / processed;
+}
+
+const char* JobProgress::statusName(Status status) {
+    switch (status) {
+        case Status::Pending: return "pending";
+        case Status::Running: return "running";
+        case Status::Done: return "done";
+        case Status::Cached: return "cached";
+        case Status::Failed: return "failed";
+        case Status::Cancelled: return "cancelled";
+    }
+    return "";
+}
\ No newline at end of file
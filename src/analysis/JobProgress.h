@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+// Thrown out of an analysis step once its JobProgress is cancelled
+class AnalysisCancelled : public std::runtime_error {
+public:
+    AnalysisCancelled() : std::runtime_error("Analysis cancelled") {}
+};
+
+// Progress, per-job status and the cancel flag of one analysis run, shared
+// by the workers doing it and whoever watches it. Everything is atomic, so
+// polling it every frame never blocks a worker. A job is one (file, level)
+// pair, or one archive per level.
+class JobProgress {
+public:
+    enum class Status : uint8_t { Pending, Running, Done, Cached, Failed, Cancelled };
+
+    JobProgress(size_t jobs, uint64_t total_bytes);
+
+    // Workers stop at their next check (between streamed chunks, benchmark
+    // runs and jobs) by throwing AnalysisCancelled
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+    void throwIfCancelled() const {
+        if (cancelled()) throw AnalysisCancelled();
+    }
+
+    // Input bytes of job consumed so far, for jobs that report as they stream
+    void addBytes(size_t job, uint64_t bytes);
+    // Final status; counts the rest of the job's job_bytes as processed
+    void finish(size_t job, Status status, uint64_t job_bytes);
+    void start(size_t job) { setStatus(job, Status::Running); }
+
+    // A stage before the first job, such as training a dictionary. The ETA
+    // is measured from its end.
+    void beginPreparing() { preparing_.store(true, std::memory_order_relaxed); }
+    void endPreparing();
+    bool preparing() const { return preparing_.load(std::memory_order_relaxed); }
+
+    size_t jobCount() const { return jobs_; }
+    Status status(size_t job) const { return static_cast<Status>(status_[job].load(std::memory_order_relaxed)); }
+    uint64_t processedBytes() const { return processed_.load(std::memory_order_relaxed); }
+    uint64_t totalBytes() const { return total_bytes_; }
+    double fraction() const;
+
+    std::chrono::steady_clock::duration elapsed() const { return std::chrono::steady_clock::now() - start_time_; }
+    // Time left at the average rate so far; negative until there is a rate
+    double etaSeconds() const;
+
+    static const char* statusName(Status status);
+
+private:
+    size_t jobs_;
+    uint64_t total_bytes_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::atomic<std::chrono::steady_clock::rep> analysis_start_;  // Ticks when jobs began
+    std::atomic<bool> preparing_{false};
+    std::atomic<bool> cancelled_{false};
+    std::atomic<uint64_t> processed_{0};
+    std::unique_ptr<std::atomic<uint8_t>[]> status_;
+    std::unique_ptr<std::atomic<uint64_t>[]> job_bytes_;  // Already counted per job
+
+    void setStatus(size_t job, Status status) {
+        status_[job].store(static_cast<uint8_t>(status), std::memory_order_relaxed);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "ResultCache.h"
+#include "../utils/ContentHash.h"
+#include "../utils/MappedFile.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Bump when the key or row format changes; older lines then never match
+constexpr int kFormatVersion = 1;
+constexpr const char* kLogName = "results.jsonl";
+
+// Hashed in slices so the hasher runs just behind the mapping's read-ahead
+constexpr size_t kHashSlice = 1024 * 1024;
+
+json statsToJson(const ThroughputStats& stats) {
+    return {stats.samples, stats.min, stats.median, stats.mean, stats.p95, stats.stddev};
+}
+
+ThroughputStats statsFromJson(const json& value) {
+    ThroughputStats stats;
+    stats.samples = value.at(0).get<unsigned>();
+    stats.min = value.at(1).get<double>();
+    stats.median = value.at(2).get<double>();
+    stats.mean = value.at(3).get<double>();
+    stats.p95 = value.at(4).get<double>();
+    stats.stddev = value.at(5).get<double>();
+    return stats;
+}
+
+json rowToJson(const AnalysisResult& row) {
+    return {
+        {"filename", row.filename},
+        {"algorithm", row.algorithm},
+        {"file_type", row.file_type},
+        {"ratio", row.ratio},
+        {"entropy", row.entropy},
+        {"entropy_order1", row.entropy_order1},
+        {"entropy_order2", row.entropy_order2},
+        {"high_entropy_fraction", row.high_entropy_fraction},
+        {"entropy_profile", row.entropy_profile},
+        {"compression_time_us", row.compression_time_us},
+        {"decompression_time_us", row.decompression_time_us},
+        {"compression_throughput", row.compression_throughput},
+        {"decompression_throughput", row.decompression_throughput},
+        {"memory_used", row.memory_used},
+        {"original_size", row.original_size},
+        {"compressed_size", row.compressed_size},
+        {"reference_ratio", row.reference_ratio},
+        {"compression_setup_us", row.compression_setup_us},
+        {"decompression_setup_us", row.decompression_setup_us},
+        {"compression_codec_memory", row.compression_codec_memory},
+        {"compression_buffer_memory", row.compression_buffer_memory},
+        {"decompression_codec_memory", row.decompression_codec_memory},
+        {"decompression_buffer_memory", row.decompression_buffer_memory},
+        {"compression_stats", statsToJson(row.compression_stats)},
+        {"decompression_stats", statsToJson(row.decompression_stats)},
+        {"estimated_ratio", row.estimated_ratio},
+        {"estimated_ratio_low", row.estimated_ratio_low},
+        {"estimated_ratio_high", row.estimated_ratio_high},
+        {"sampled_fraction", row.sampled_fraction},
+        {"estimated_only", row.estimated_only},
+        {"skipped", row.skipped},
+        {"policy", row.policy},
+        {"member_extraction_us", row.member_extraction_us}
+    };
+}
+
+// Throws json exceptions for missing or mistyped fields
+AnalysisResult rowFromJson(const json& value) {
+    AnalysisResult row;
+    row.filename = value.at("filename").get<std::string>();
+    row.algorithm = value.at("algorithm").get<std::string>();
+    row.file_type = value.at("file_type").get<std::string>();
+    row.ratio = value.at("ratio").get<double>();
+    row.entropy = value.at("entropy").get<double>();
+    row.entropy_order1 = value.at("entropy_order1").get<double>();
+    row.entropy_order2 = value.at("entropy_order2").get<double>();
+    row.high_entropy_fraction = value.at("high_entropy_fraction").get<double>();
+    row.entropy_profile = value.at("entropy_profile").get<std::vector<float>>();
+    row.compression_time_us = value.at("compression_time_us").get<long long>();
+    row.decompression_time_us = value.at("decompression_time_us").get<long long>();
+    row.compression_throughput = value.at("compression_throughput").get<double>();
+    row.decompression_throughput = value.at("decompression_throughput").get<double>();
+    row.memory_used = value.at("memory_used").get<size_t>();
+    row.original_size = value.at("original_size").get<size_t>();
+    row.compressed_size = value.at("compressed_size").get<size_t>();
+    row.reference_ratio = value.at("reference_ratio").get<double>();
+    row.compression_setup_us = value.at("compression_setup_us").get<double>();
+    row.decompression_setup_us = value.at("decompression_setup_us").get<double>();
+    row.compression_codec_memory = value.at("compression_codec_memory").get<size_t>();
+    row.compression_buffer_memory = value.at("compression_buffer_memory").get<size_t>();
+    row.decompression_codec_memory = value.at("decompression_codec_memory").get<size_t>();
+    row.decompression_buffer_memory = value.at("decompression_buffer_memory").get<size_t>();
+    row.compression_stats = statsFromJson(value.at("compression_stats"));
+    row.decompression_stats = statsFromJson(value.at("decompression_stats"));
+    row.estimated_ratio = value.at("estimated_ratio").get<double>();
+    row.estimated_ratio_low = value.at("estimated_ratio_low").get<double>();
+    row.estimated_ratio_high = value.at("estimated_ratio_high").get<double>();
+    row.sampled_fraction = value.at("sampled_fraction").get<double>();
+    row.estimated_only = value.at("estimated_only").get<bool>();
+    row.skipped = value.at("skipped").get<bool>();
+    row.policy = value.at("policy").get<std::string>();
+    row.member_extraction_us = value.at("member_extraction_us").get<double>();
+    return row;
+}
+
+// The analysis settings that change a row; thread counts and output format do not
+std::string optionsKey(const AnalysisOptions& options) {
+    const BenchmarkOptions& benchmark = options.benchmark;
+    return "stream " + std::to_string(options.streaming) + "/" + std::to_string(options.streaming_threshold) +
+           " bench " + std::to_string(benchmark.warmup_runs) + "/" + std::to_string(benchmark.repetitions) + "/" +
+           std::to_string(benchmark.target_ci) + "/" + std::to_string(benchmark.max_repetitions) +
+           " entropy " + std::to_string(options.entropy_window) +
+           " estimate " + std::to_string(static_cast<int>(options.estimate)) + "/" +
+           std::to_string(options.estimator.blocks) + "/" + std::to_string(options.estimator.block_size) +
+           " skip " + std::to_string(options.skip_ratio);
+}
+
+} // namespace
+
+ResultCache::ResultCache(const std::filesystem::path& directory) : directory_(directory) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        throw std::runtime_error("Failed to create cache directory " + directory_.string() + ": " + ec.message());
+    }
+    std::filesystem::path log_path = directory_ / kLogName;
+
+    // Later lines win, so a row stored again replaces the old one
+    size_t lines = 0;
+    {
+        std::ifstream in(log_path);
+        std::string line;
+        while (std::getline(in, line)) {
+            ++lines;
+            try {
+                json entry = json::parse(line);
+                entries_[entry.at("key").get<std::string>()] = rowFromJson(entry.at("row"));
+            } catch (const json::exception&) {
+                // Torn or foreign line; the row is measured again
+            }
+        }
+    }
+
+    // Rewrite once replaced and unreadable lines outnumber live ones
+    if (lines > 2 * entries_.size() + 64) {
+        std::filesystem::path temp_path = directory_ / (std::string(kLogName) + ".tmp");
+        {
+            std::ofstream out(temp_path, std::ios::trunc);
+            for (const auto& [key, row] : entries_) {
+                out << json{{"key", key}, {"row", rowToJson(row)}}.dump() << "\n";
+            }
+            if (!out) {
+                throw std::runtime_error("Failed to write cache file " + temp_path.string());
+            }
+        }
+        std::filesystem::rename(temp_path, log_path, ec);
+        if (ec) {
+            throw std::runtime_error("Failed to replace cache file " + log_path.string() + ": " + ec.message());
+        }
+    }
+
+    log_.open(log_path, std::ios::app);
+    if (!log_) {
+        throw std::runtime_error("Failed to open cache file " + log_path.string());
+    }
+}
+
+std::filesystem::path ResultCache::defaultDirectory() {
+    const char* name = "data-compression-analyzer";
+    if (const char* cache_home = std::getenv("XDG_CACHE_HOME"); cache_home && *cache_home) {
+        return std::filesystem::path(cache_home) / name;
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return std::filesystem::path(home) / ".cache" / name;
+    }
+    return std::filesystem::temp_directory_path() / name;
+}
+
+std::string ResultCache::key(const Compressor& compressor, const std::filesystem::path& file_path, int level,
+                             const AnalysisOptions& options) {
+    std::string compressor_key = compressor.getCacheKey(level);
+    if (compressor_key.empty()) {
+        return std::string();
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    MappedFile file(file_path);
+    ContentHasher hasher;
+    ByteView data = file.view();
+    for (size_t offset = 0; offset < data.size(); offset += kHashSlice) {
+        hasher.update(data.subview(offset, std::min(kHashSlice, data.size() - offset)));
+    }
+    ContentDigest digest = hasher.finish();
+    hash_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start_time).count(),
+                       std::memory_order_relaxed);
+    hashed_bytes_.fetch_add(data.size(), std::memory_order_relaxed);
+
+    return "v" + std::to_string(kFormatVersion) + " " + digest.hex() + " " + std::to_string(data.size()) + " " +
+           compressor_key + " " + optionsKey(options);
+}
+
+std::optional<AnalysisResult> ResultCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second;
+}
+
+void ResultCache::store(const std::string& key, const AnalysisResult& row) {
+    // Serialized outside the lock; rows with long entropy profiles take a while
+    std::string line = json{{"key", key}, {"row", rowToJson(row)}}.dump();
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = row;
+    log_ << line << "\n";
+    log_.flush();
+    if (!log_) {
+        throw std::runtime_error("Failed to write cache file " + (directory_ / kLogName).string());
+    }
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.hashed_bytes = hashed_bytes_.load(std::memory_order_relaxed);
+    stats.hash_time = std::chrono::nanoseconds(hash_ns_.load(std::memory_order_relaxed));
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.entries = entries_.size();
+    return stats;
+}
+
+void ResultCache::resetStats() {
+    hits_.store(0, std::memory_order_relaxed);
+    misses_.store(0, std::memory_order_relaxed);
+    hashed_bytes_.store(0, std::memory_order_relaxed);
+    hash_ns_.store(0, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "Analyzer.h"
+
+// On-disk store of analysis rows keyed by a file's content and everything
+// that decides its row, so a repeat run only analyzes files that changed.
+// Rows are appended to results.jsonl in the cache directory, one JSON object
+// per line, as soon as they are stored: a run that is stopped keeps the rows
+// it finished. Timings in a reused row are those of the run that measured
+// them. Safe to use from several workers at once.
+class ResultCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t hashed_bytes = 0;                 // Read by key() to fingerprint files
+        std::chrono::nanoseconds hash_time{0};     // Summed over workers
+        size_t entries = 0;
+    };
+
+    // Opens the cache in directory, creating it if needed, and loads its
+    // rows; unreadable lines (e.g. cut short by a crash) are skipped. Throws
+    // std::runtime_error if the directory or its file cannot be written.
+    explicit ResultCache(const std::filesystem::path& directory);
+
+    // $XDG_CACHE_HOME/data-compression-analyzer, else ~/.cache/..., else
+    // under the temp directory
+    static std::filesystem::path defaultDirectory();
+
+    // Key for analyzing file_path with compressor at level under options,
+    // from a ContentHasher digest of the file. Empty if the compressor's
+    // results cannot be cached (see Compressor::getCacheKey).
+    std::string key(const Compressor& compressor, const std::filesystem::path& file_path, int level,
+                    const AnalysisOptions& options);
+
+    // The row stored under key, counting a hit or a miss
+    std::optional<AnalysisResult> find(const std::string& key);
+    // Throws std::runtime_error if the row cannot be written
+    void store(const std::string& key, const AnalysisResult& row);
+
+    Stats stats() const;
+    void resetStats();
+    const std::filesystem::path& directory() const { return directory_; }
+
+private:
+    std::filesystem::path directory_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, AnalysisResult> entries_;
+    std::ofstream log_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> hashed_bytes_{0};
+    std::atomic<int64_t> hash_ns_{0};
+};
\ No newline at end of file
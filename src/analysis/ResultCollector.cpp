@@ -0,0 +1,39 @@
+#include "ResultCollector.h"
+
+ResultCollector::ResultCollector(ResultCallback on_result, ErrorCallback on_error)
+    : on_result_(std::move(on_result)), on_error_(std::move(on_error)) {}
+
+void ResultCollector::add(AnalysisResult result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (on_result_) {
+        on_result_(result);
+    }
+    results_.push_back(std::move(result));
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void ResultCollector::addError(const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (on_error_) {
+        on_error_(message);
+    }
+    errors_.push_back(message);
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void ResultCollector::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.clear();
+    errors_.clear();
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+std::vector<AnalysisResult> ResultCollector::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return results_;
+}
+
+std::vector<std::string> ResultCollector::errors() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return errors_;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Analyzer.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Thread-safe sink for analysis rows produced by pool workers. Optional
+// callbacks run under the collector's lock, so they see rows one at a time.
+class ResultCollector {
+public:
+    using ResultCallback = std::function<void(const AnalysisResult&)>;
+    using ErrorCallback = std::function<void(const std::string&)>;
+
+    ResultCollector() = default;
+    ResultCollector(ResultCallback on_result, ErrorCallback on_error);
+
+    void add(AnalysisResult result);
+    void addError(const std::string& message);
+    void clear();
+
+    // Copy of all rows collected so far
+    std::vector<AnalysisResult> snapshot() const;
+    std::vector<std::string> errors() const;
+
+    // Bumped on every change; lets readers skip copying an unchanged snapshot
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<AnalysisResult> results_;
+    std::vector<std::string> errors_;
+    ResultCallback on_result_;
+    ErrorCallback on_error_;
+    std::atomic<uint64_t> version_{0};
+};
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "Sweep.h"
+#include "ResultCollector.h"
+#include "../compression/GzipCompressor.h"
+#include "../utils/FileHandler.h"
+#include "../utils/ThreadPool.h"
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+// One compressor setting of the grid; levels are varied per job
+struct Variant {
+    std::unique_ptr<Compressor> owned;
+    Compressor* compressor;
+    bool gzip;
+    int window_bits;
+    int mem_level;
+    int strategy;
+};
+
+std::vector<Variant> makeVariants(Compressor& compressor, const SweepSpace& space) {
+    std::vector<Variant> variants;
+    auto* gzip = dynamic_cast<GzipCompressor*>(&compressor);
+    if (!gzip) {
+        GzipCompressor::Options defaults;
+        bool zlib_axes = space.window_bits != std::vector<int>{defaults.window_bits} ||
+                         space.mem_levels != std::vector<int>{defaults.mem_level} ||
+                         space.strategies != std::vector<int>{defaults.strategy};
+        if (zlib_axes) {
+            throw std::invalid_argument("windowBits, memLevel and strategy sweeps need the gzip codec");
+        }
+        variants.push_back({nullptr, &compressor, false, defaults.window_bits, defaults.mem_level, defaults.strategy});
+        return variants;
+    }
+
+    for (int window_bits : space.window_bits) {
+        for (int mem_level : space.mem_levels) {
+            for (int strategy : space.strategies) {
+                GzipCompressor::Options options = gzip->getOptions();
+                options.window_bits = window_bits;
+                options.mem_level = mem_level;
+                options.strategy = strategy;
+                auto variant = std::make_unique<GzipCompressor>();
+                variant->setOptions(options);
+                Compressor* raw = variant.get();
+                variants.push_back({std::move(variant), raw, true, window_bits, mem_level, strategy});
+            }
+        }
+    }
+    return variants;
+}
+
+// Sums for one (file type, configuration) cell
+struct Totals {
+    size_t files = 0;
+    uint64_t original_size = 0;
+    uint64_t compressed_size = 0;
+    long long compression_time_us = 0;
+    long long decompression_time_us = 0;
+
+    void add(const AnalysisResult& row) {
+        ++files;
+        original_size += row.original_size;
+        compressed_size += row.compressed_size;
+        compression_time_us += row.compression_time_us;
+        decompression_time_us += row.decompression_time_us;
+    }
+};
+
+} // namespace
+
+std::vector<SweepPoint> Sweep::run(Compressor& compressor,
+                                   const std::vector<std::filesystem::path>& file_paths,
+                                   const SweepSpace& space,
+                                   ThreadPool& pool,
+                                   ResultCollector& collector,
+                                   const AnalysisOptions& options) {
+    std::vector<int> levels = space.levels;
+    if (levels.empty()) {
+        for (int level = compressor.minLevel(); level <= compressor.maxLevel(); ++level) {
+            levels.push_back(level);
+        }
+    }
+    std::vector<Variant> variants = makeVariants(compressor, space);
+
+    struct Job {
+        const std::filesystem::path* path;
+        size_t variant;
+        size_t level_index;
+        uintmax_t size;
+    };
+    std::vector<Job> jobs;
+    for (const auto& file_path : file_paths) {
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(file_path, ec);
+        for (size_t v = 0; v < variants.size(); ++v) {
+            for (size_t l = 0; l < levels.size(); ++l) {
+                jobs.push_back({&file_path, v, l, ec ? 0 : size});
+            }
+        }
+    }
+    std::stable_sort(jobs.begin(), jobs.end(),
+                     [](const Job& a, const Job& b) { return a.size > b.size; });
+
+    // Rows tagged with their configuration (variant * levels + level index)
+    std::mutex rows_mutex;
+    std::vector<std::pair<size_t, AnalysisResult>> rows;
+    std::vector<std::future<void>> pending;
+    pending.reserve(jobs.size());
+    for (const Job& job : jobs) {
+        pending.push_back(pool.submit([&, job]() {
+            try {
+                AnalysisResult row = Analyzer::analyzeFile(*variants[job.variant].compressor, *job.path,
+                                                           levels[job.level_index], options);
+                {
+                    std::lock_guard<std::mutex> lock(rows_mutex);
+                    rows.emplace_back(job.variant * levels.size() + job.level_index, row);
+                }
+                collector.add(std::move(row));
+            } catch (const std::exception& e) {
+                collector.addError("Error processing file " + job.path->string() + ": " + e.what());
+            }
+        }));
+    }
+    for (auto& future : pending) {
+        future.get();
+    }
+
+    size_t config_count = variants.size() * levels.size();
+    std::map<std::string, std::vector<Totals>> by_type;
+    std::vector<Totals> all(config_count);
+    for (const auto& [config, row] : rows) {
+        auto& cells = by_type[row.file_type];
+        cells.resize(config_count);
+        cells[config].add(row);
+        all[config].add(row);
+    }
+
+    std::vector<SweepPoint> points;
+    auto append_group = [&](const std::string& file_type, const std::vector<Totals>& cells) {
+        size_t group_start = points.size();
+        for (size_t config = 0; config < config_count; ++config) {
+            const Totals& totals = cells[config];
+            if (totals.files == 0) {
+                continue;
+            }
+            const Variant& variant = variants[config / levels.size()];
+            SweepPoint point;
+            point.file_type = file_type;
+            point.level = levels[config % levels.size()];
+            point.algorithm = variant.compressor->getAlgorithmLabel(point.level);
+            point.gzip = variant.gzip;
+            point.window_bits = variant.window_bits;
+            point.mem_level = variant.mem_level;
+            point.strategy = variant.strategy;
+            point.files = totals.files;
+            point.original_size = totals.original_size;
+            point.compressed_size = totals.compressed_size;
+            point.ratio = totals.original_size
+                ? static_cast<double>(totals.compressed_size) / totals.original_size : 0.0;
+            point.compression_throughput =
+                FileHandler::calculateThroughput(totals.original_size, totals.compression_time_us);
+            point.decompression_throughput =
+                FileHandler::calculateThroughput(totals.original_size, totals.decompression_time_us);
+            points.push_back(point);
+        }
+        std::stable_sort(points.begin() + group_start, points.end(),
+                         [](const SweepPoint& a, const SweepPoint& b) { return a.ratio < b.ratio; });
+    };
+    for (const auto& [file_type, cells] : by_type) {
+        append_group(file_type, cells);
+    }
+    if (by_type.size() > 1) {
+        append_group("All", all);
+    }
+
+    markParetoFrontier(points);
+    return points;
+}
+
+void Sweep::markParetoFrontier(std::vector<SweepPoint>& points) {
+    std::map<std::string, std::vector<SweepPoint*>> groups;
+    for (auto& point : points) {
+        groups[point.file_type].push_back(&point);
+    }
+    for (auto& [file_type, group] : groups) {
+        // Best ratio first, the faster of equal ratios first; a point is on
+        // the frontier if it is faster than everything with a better ratio
+        std::sort(group.begin(), group.end(), [](const SweepPoint* a, const SweepPoint* b) {
+            if (a->ratio != b->ratio) return a->ratio < b->ratio;
+            return a->compression_throughput > b->compression_throughput;
+        });
+        double fastest = -std::numeric_limits<double>::infinity();
+        for (SweepPoint* point : group) {
+            point->pareto = point->compression_throughput > fastest;
+            fastest = std::max(fastest, point->compression_throughput);
+        }
+    }
+}
+
+std::vector<std::string> Sweep::reportHeaders() {
+    return {
+        "File Type", "Algorithm", "Level", "Window Bits", "Mem Level", "Strategy", "Files",
+        "Original Size (KB)", "Compressed Size (KB)", "Ratio",
+        "Compression Speed (MB/s)", "Decompression Speed (MB/s)", "Pareto"
+    };
+}
+
+std::vector<std::string> Sweep::reportRow(const SweepPoint& point) {
+    return {
+        point.file_type,
+        point.algorithm,
+        std::to_string(point.level),
+        point.gzip ? std::to_string(point.window_bits) : "",
+        point.gzip ? std::to_string(point.mem_level) : "",
+        point.gzip ? GzipCompressor::strategyName(point.strategy) : "",
+        std::to_string(point.files),
+        std::to_string(point.original_size / 1024.0),
+        std::to_string(point.compressed_size / 1024.0),
+        std::to_string(point.ratio),
+        std::to_string(point.compression_throughput),
+        std::to_string(point.decompression_throughput),
+        point.pareto ? "yes" : "no"
+    };
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "Analyzer.h"
+
+class ResultCollector;
+class ThreadPool;
+
+// Parameter grid for a sweep. Levels apply to every codec; the zlib axes
+// only to gzip, and must be left at their defaults for other codecs.
+struct SweepSpace {
+    std::vector<int> levels;  // Empty = every level the codec accepts
+    std::vector<int> window_bits = {15};
+    std::vector<int> mem_levels = {8};
+    std::vector<int> strategies = {Z_DEFAULT_STRATEGY};
+};
+
+// One configuration's totals over every file of one type
+struct SweepPoint {
+    std::string file_type;  // As detected per file, or "All" for the whole corpus
+    std::string algorithm;  // Label of the configuration, as in AnalysisResult
+    int level = 0;
+    bool gzip = false;      // Whether the zlib parameters below apply
+    int window_bits = 15;
+    int mem_level = 8;
+    int strategy = Z_DEFAULT_STRATEGY;
+    size_t files = 0;
+    uint64_t original_size = 0;
+    uint64_t compressed_size = 0;
+    double ratio = 0.0;                     // Compressed / original, like AnalysisResult::ratio
+    double compression_throughput = 0.0;    // MB/s over the summed per-file (median) times
+    double decompression_throughput = 0.0;
+    bool pareto = false;                    // No other point has both a lower ratio and a higher speed
+};
+
+class Sweep {
+public:
+    // Analyze every file under every configuration on the pool, largest files
+    // first. Configurations use fresh compressors built from compressor's
+    // options, so it is not modified. Per-file rows and errors also go to the
+    // collector. Returns one point per (file type, configuration), grouped by
+    // type with "All" last, sorted by ratio, Pareto frontier marked.
+    // Throws std::invalid_argument if the space does not fit the codec.
+    static std::vector<SweepPoint> run(Compressor& compressor,
+                                       const std::vector<std::filesystem::path>& file_paths,
+                                       const SweepSpace& space,
+                                       ThreadPool& pool,
+                                       ResultCollector& collector,
+                                       const AnalysisOptions& options = {});
+
+    // Within each file type, mark the points not dominated on ratio (lower
+    // is better) and compression throughput (higher is better)
+    static void markParetoFrontier(std::vector<SweepPoint>& points);
+
+    // Column names and string cells for the report
+    static std::vector<std::string> reportHeaders();
+    static std::vector<std::string> reportRow(const SweepPoint& point);
+};
\ No newline at end of file
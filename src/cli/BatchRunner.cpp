@@ -0,0 +1,1041 @@
+#include "BatchRunner.h"
+#include "../analysis/Analyzer.h"
+#include "../analysis/ResultCache.h"
+#include "../analysis/ResultCollector.h"
+#include "../compression/ArchiveCompressor.h"
+#include "../compression/AutoCompressor.h"
+#include "../compression/CompressorFactory.h"
+#include "../compression/GzipCompressor.h"
+#ifdef DCA_HAVE_ZSTD
+#include "../compression/ZstdCompressor.h"
+#endif
+#ifdef DCA_HAVE_LZ4
+#include "../compression/Lz4Compressor.h"
+#endif
+#ifdef DCA_HAVE_XZ
+#include "../compression/XzCompressor.h"
+#endif
+#include "../utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+
+void writeCSVLine(std::ostream& out, const std::vector<std::string>& cells) {
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const std::string& cell = cells[i];
+        if (cell.find_first_of(",\"\n") != std::string::npos) {
+            out << '"';
+            for (char c : cell) {
+                if (c == '"') out << '"';
+                out << c;
+            }
+            out << '"';
+        } else {
+            out << cell;
+        }
+        if (i < cells.size() - 1) {
+            out << ",";
+        }
+    }
+    out << "\n";
+}
+
+// Writes rows as they arrive so long runs can be tailed or piped
+class ResultWriter {
+public:
+    ResultWriter(std::ostream& out, BatchOptions::Format format)
+        : out_(out), format_(format), headers_(Analyzer::resultHeaders()) {}
+
+    void begin() {
+        switch (format_) {
+            case BatchOptions::Format::Text: {
+                char line[256];
+                std::snprintf(line, sizeof(line), "%-40s %-8s %-24s %8s %8s %12s %12s %10s %8s %10s %8s %10s %10s %10s %5s %9s",
+                              "File", "Type", "Algorithm", "Ratio", "Entropy", "Orig (KB)", "Comp (KB)",
+                              "Comp MB/s", "+/-", "Decomp MB/s", "+/-", "Time (ms)", "Setup (us)", "Mem (KB)",
+                              "Runs", "Cost (%)");
+                out_ << line << "\n";
+                break;
+            }
+            case BatchOptions::Format::CSV:
+                writeCSVLine(out_, headers_);
+                break;
+            case BatchOptions::Format::JSON:
+                out_ << "{\"headers\": " << json(headers_).dump() << ", \"data\": [\n";
+                break;
+        }
+        out_.flush();
+    }
+
+    void write(const AnalysisResult& result) {
+        switch (format_) {
+            case BatchOptions::Format::Text: {
+                char line[512];
+                std::snprintf(line, sizeof(line), "%-40s %-8s %-24s %8.3f %8.3f %12.2f %12.2f %10.2f %8.2f %10.2f %8.2f %10.3f %10.1f %10.0f %5u",
+                              result.filename.c_str(), result.file_type.c_str(), result.algorithm.c_str(),
+                              result.ratio, result.entropy,
+                              result.original_size / 1024.0, result.compressed_size / 1024.0,
+                              result.compression_throughput, result.compression_stats.stddev,
+                              result.decompression_throughput, result.decompression_stats.stddev,
+                              (result.compression_time_us + result.decompression_time_us) / 1000.0,
+                              result.compression_setup_us + result.decompression_setup_us,
+                              result.memory_used / 1024.0, result.compression_stats.samples);
+                out_ << line;
+                if (result.reference_ratio > 0.0) {
+                    std::snprintf(line, sizeof(line), " %+9.2f", Analyzer::ratioCost(result));
+                    out_ << line;
+                } else {
+                    out_ << "         -";
+                }
+                if (result.estimated_ratio > 0.0) {
+                    std::snprintf(line, sizeof(line), "  est %.3f [%.3f-%.3f] from %.1f%%", result.estimated_ratio,
+                                  result.estimated_ratio_low, result.estimated_ratio_high, result.sampled_fraction * 100.0);
+                    out_ << line;
+                    if (Analyzer::hasEstimateError(result)) {
+                        std::snprintf(line, sizeof(line), ", error %+.2f%%", Analyzer::estimateError(result));
+                        out_ << line;
+                    }
+                    if (result.skipped) {
+                        out_ << ", skipped";
+                    }
+                }
+                if (result.member_extraction_us > 0.0) {
+                    std::snprintf(line, sizeof(line), "  one member %.3f ms", result.member_extraction_us / 1000.0);
+                    out_ << line;
+                }
+                out_ << "\n";
+                break;
+            }
+            case BatchOptions::Format::CSV:
+                writeCSVLine(out_, Analyzer::resultRow(result));
+                break;
+            case BatchOptions::Format::JSON: {
+                auto row = Analyzer::resultRow(result);
+                json row_obj;
+                for (size_t i = 0; i < headers_.size() && i < row.size(); ++i) {
+                    row_obj[headers_[i]] = row[i];
+                }
+                out_ << (rows_written_ > 0 ? ",\n" : "") << "    " << row_obj.dump();
+                break;
+            }
+        }
+        ++rows_written_;
+        out_.flush();
+    }
+
+    void end() {
+        if (format_ == BatchOptions::Format::JSON) {
+            out_ << "\n]}\n";
+        }
+        out_.flush();
+    }
+
+private:
+    std::ostream& out_;
+    BatchOptions::Format format_;
+    std::vector<std::string> headers_;
+    size_t rows_written_ = 0;
+};
+
+// Estimated totals of the per-file choices next to every fixed setting
+void writePolicyComparison(std::ostream& out, const std::vector<AutoCompressor::SettingTotals>& totals) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-32s %6s %10s %14s %12s %12s", "Setting", "Files", "Ratio",
+                  "Comp (KB)", "Comp (ms)", "In Budget");
+    out << "\nEstimated totals, per-file choice vs. fixed settings:\n" << line << "\n";
+    for (const auto& setting : totals) {
+        double ratio = setting.original_bytes ? setting.compressed_bytes / setting.original_bytes : 0.0;
+        std::snprintf(line, sizeof(line), "%-32s %6zu %10.4f %14.2f %12.2f %12zu", setting.label.c_str(),
+                      setting.inputs, ratio, setting.compressed_bytes / 1024.0, setting.compression_ms,
+                      setting.within_budget);
+        out << line << "\n";
+    }
+}
+
+// Dictionary build cost, then what the held-out records it was used on
+// averaged; the rows' times do not include training
+void writeDictionarySummary(std::ostream& out, const TrainedDictionary& dictionary,
+                            const std::vector<AnalysisResult>& rows) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "Dictionary: %.2f KB (%s) from %zu samples (%.2f MB) in %.2f ms",
+                  dictionary.size() / 1024.0, dictionary.method.c_str(), dictionary.samples,
+                  dictionary.sample_bytes / (1024.0 * 1024.0),
+                  std::chrono::duration<double, std::milli>(dictionary.build_time).count());
+    out << "\n" << line << "\n";
+    if (rows.empty()) {
+        return;
+    }
+    double ratio = 0.0;
+    double compression_us = 0.0;
+    double decompression_us = 0.0;
+    uint64_t original = 0;
+    uint64_t compressed = 0;
+    for (const auto& row : rows) {
+        ratio += row.ratio;
+        compression_us += row.compression_time_us;
+        decompression_us += row.decompression_time_us;
+        original += row.original_size;
+        compressed += row.compressed_size;
+    }
+    std::snprintf(line, sizeof(line),
+                  "Per held-out record (%zu): mean ratio %.4f, overall %.4f, mean compression %.2f us, "
+                  "decompression %.2f us",
+                  rows.size(), ratio / rows.size(), original ? static_cast<double>(compressed) / original : 0.0,
+                  compression_us / rows.size(), decompression_us / rows.size());
+    out << line << "\n";
+}
+
+void writeCacheSummary(std::ostream& out, const ResultCache& cache) {
+    ResultCache::Stats stats = cache.stats();
+    double hash_ms = std::chrono::duration<double, std::milli>(stats.hash_time).count();
+    char line[512];
+    std::snprintf(line, sizeof(line),
+                  "Cache: %llu hits, %llu misses, %zu rows in %s; hashed %.2f MB in %.2f ms (%.0f MB/s)",
+                  static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+                  stats.entries, cache.directory().string().c_str(), stats.hashed_bytes / (1024.0 * 1024.0),
+                  hash_ms, hash_ms > 0.0 ? stats.hashed_bytes / (1024.0 * 1024.0) / (hash_ms / 1000.0) : 0.0);
+    out << "\n" << line << "\n";
+}
+
+// The sweep report is written once at the end; in text form frontier
+// points are starred and file types separated by a blank line
+void writeSweepReport(std::ostream& out, BatchOptions::Format format, const std::vector<SweepPoint>& points,
+                      bool frontier_only) {
+    auto headers = Sweep::reportHeaders();
+    switch (format) {
+        case BatchOptions::Format::Text: {
+            char line[512];
+            std::snprintf(line, sizeof(line), "%-10s %-44s %6s %8s %12s %10s %11s %6s",
+                          "Type", "Algorithm", "Files", "Ratio", "Comp (KB)", "Comp MB/s", "Decomp MB/s", "Pareto");
+            out << line << "\n";
+            const std::string* previous_type = nullptr;
+            for (const auto& point : points) {
+                if (frontier_only && !point.pareto) continue;
+                if (previous_type && *previous_type != point.file_type) {
+                    out << "\n";
+                }
+                previous_type = &point.file_type;
+                std::snprintf(line, sizeof(line), "%-10s %-44s %6zu %8.4f %12.2f %10.2f %11.2f %6s",
+                              point.file_type.c_str(), point.algorithm.c_str(), point.files, point.ratio,
+                              point.compressed_size / 1024.0, point.compression_throughput,
+                              point.decompression_throughput, point.pareto ? "*" : "");
+                out << line << "\n";
+            }
+            break;
+        }
+        case BatchOptions::Format::CSV:
+            writeCSVLine(out, headers);
+            for (const auto& point : points) {
+                if (frontier_only && !point.pareto) continue;
+                writeCSVLine(out, Sweep::reportRow(point));
+            }
+            break;
+        case BatchOptions::Format::JSON: {
+            json data = json::array();
+            for (const auto& point : points) {
+                if (frontier_only && !point.pareto) continue;
+                auto row = Sweep::reportRow(point);
+                json row_obj;
+                for (size_t i = 0; i < headers.size() && i < row.size(); ++i) {
+                    row_obj[headers[i]] = row[i];
+                }
+                data.push_back(row_obj);
+            }
+            out << json{{"headers", headers}, {"data", data}}.dump(4) << "\n";
+            break;
+        }
+    }
+    out.flush();
+}
+
+void writeDedupReport(std::ostream& out, BatchOptions::Format format, const DedupResult& result) {
+    auto headers = Dedup::reportHeaders();
+    auto row = Dedup::reportRow(result);
+    switch (format) {
+        case BatchOptions::Format::Text: {
+            char line[512];
+            double average_chunk = result.chunks ? static_cast<double>(result.total_bytes) / result.chunks : 0.0;
+            std::snprintf(line, sizeof(line),
+                          "Files: %zu, %.2f MB in %llu chunks (avg %.2f KB)\n"
+                          "Unique: %llu chunks, %.2f MB, dedup ratio %.4f\n"
+                          "Dedup + %s: %.2f MB, combined ratio %.4f\n"
+                          "Throughput: %.2f MB/s, fingerprint index %.2f MB",
+                          result.files, result.total_bytes / (1024.0 * 1024.0),
+                          static_cast<unsigned long long>(result.chunks), average_chunk / 1024.0,
+                          static_cast<unsigned long long>(result.unique_chunks),
+                          result.unique_bytes / (1024.0 * 1024.0), result.dedup_ratio, result.algorithm.c_str(),
+                          result.compressed_bytes / (1024.0 * 1024.0), result.combined_ratio, result.throughput,
+                          result.index_memory / (1024.0 * 1024.0));
+            out << line << "\n";
+            if (result.archive_size) {
+                std::snprintf(line, sizeof(line), "Archive: %.2f MB", result.archive_size / (1024.0 * 1024.0));
+                out << line << "\n";
+            }
+            break;
+        }
+        case BatchOptions::Format::CSV:
+            writeCSVLine(out, headers);
+            writeCSVLine(out, row);
+            break;
+        case BatchOptions::Format::JSON: {
+            json row_obj;
+            for (size_t i = 0; i < headers.size() && i < row.size(); ++i) {
+                row_obj[headers[i]] = row[i];
+            }
+            out << json{{"headers", headers}, {"data", json::array({row_obj})}}.dump(4) << "\n";
+            break;
+        }
+    }
+    out.flush();
+}
+
+std::vector<int> parseLevels(const std::string& spec) {
+    std::vector<int> levels;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t comma = spec.find(',', start);
+        std::string token = spec.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        size_t dash = token.find('-', 1);
+        if (dash != std::string::npos) {
+            int first = std::stoi(token.substr(0, dash));
+            int last = std::stoi(token.substr(dash + 1));
+            if (first > last) std::swap(first, last);
+            for (int level = first; level <= last; ++level) levels.push_back(level);
+        } else {
+            levels.push_back(std::stoi(token));
+        }
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return levels;
+}
+
+std::vector<int> parseStrategies(const std::string& spec) {
+    std::vector<int> strategies;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t comma = spec.find(',', start);
+        strategies.push_back(GzipCompressor::parseStrategy(
+            spec.substr(start, comma == std::string::npos ? std::string::npos : comma - start)));
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return strategies;
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(BatchOptions options) : options_(std::move(options)) {}
+
+int BatchRunner::runCommandLine(const std::vector<std::string>& args, const std::string& program) {
+    try {
+        BatchOptions options = parseArguments(args);
+        if (options.show_help) {
+            printUsage(std::cout, program);
+            return 0;
+        }
+        return BatchRunner(std::move(options)).run();
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Error: " << e.what() << "\n\n";
+        printUsage(std::cerr, program);
+        return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+BatchOptions BatchRunner::parseArguments(const std::vector<std::string>& args) {
+    BatchOptions options;
+    auto value_of = [&](size_t& i) -> const std::string& {
+        if (i + 1 >= args.size()) {
+            throw std::invalid_argument("Missing value for " + args[i]);
+        }
+        return args[++i];
+    };
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "-h" || arg == "--help") {
+            options.show_help = true;
+        } else if (arg == "-c" || arg == "--codec") {
+            options.codec = value_of(i);
+        } else if (arg == "-l" || arg == "--level" || arg == "--levels") {
+            try {
+                options.levels = parseLevels(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid level list: " + args[i]);
+            }
+        } else if (arg == "-j" || arg == "--threads") {
+            try {
+                options.threads = static_cast<unsigned>(std::stoul(value_of(i)));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid thread count: " + args[i]);
+            }
+        } else if (arg == "-f" || arg == "--format") {
+            const std::string& format = value_of(i);
+            if (format == "text") options.format = BatchOptions::Format::Text;
+            else if (format == "csv") options.format = BatchOptions::Format::CSV;
+            else if (format == "json") options.format = BatchOptions::Format::JSON;
+            else throw std::invalid_argument("Unknown output format: " + format);
+        } else if (arg == "-o" || arg == "--output") {
+            options.output = value_of(i);
+        } else if (arg == "--cache") {
+            options.cache = value_of(i);
+        } else if (arg == "--stream") {
+            options.analysis.streaming = true;
+        } else if (arg == "--stream-threshold") {
+            try {
+                options.analysis.streaming_threshold = std::stoull(value_of(i)) * 1024 * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid streaming threshold: " + args[i]);
+            }
+        } else if (arg == "--entropy-window") {
+            try {
+                options.analysis.entropy_window = std::stoul(value_of(i)) * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid entropy window: " + args[i]);
+            }
+            if (options.analysis.entropy_window < EntropyProfiler::kMinWindowSize) {
+                throw std::invalid_argument("Entropy window must be at least 1 KB");
+            }
+        } else if (arg == "--parallel-blocks") {
+            options.parallel_blocks = true;
+        } else if (arg == "--block-size") {
+            try {
+                options.block_size = std::stoul(value_of(i)) * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid block size: " + args[i]);
+            }
+        } else if (arg == "--block-threads") {
+            try {
+                options.block_threads = static_cast<unsigned>(std::stoul(value_of(i)));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid block thread count: " + args[i]);
+            }
+        } else if (arg == "--window-bits") {
+            try {
+                options.window_bits = parseLevels(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid windowBits list: " + args[i]);
+            }
+        } else if (arg == "--mem-level" || arg == "--mem-levels") {
+            try {
+                options.mem_levels = parseLevels(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid memLevel list: " + args[i]);
+            }
+        } else if (arg == "--strategy" || arg == "--strategies") {
+            options.strategies = parseStrategies(value_of(i));
+        } else if (arg == "--sweep") {
+            options.sweep = true;
+        } else if (arg == "--frontier-only") {
+            options.frontier_only = true;
+        } else if (arg == "--dedup") {
+            options.dedup = true;
+        } else if (arg == "--chunk-min" || arg == "--chunk-avg" || arg == "--chunk-max") {
+            size_t& size = arg == "--chunk-min" ? options.dedup_options.chunking.min_size
+                         : arg == "--chunk-avg" ? options.dedup_options.chunking.avg_size
+                                                : options.dedup_options.chunking.max_size;
+            try {
+                size = std::stoul(value_of(i)) * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid chunk size: " + args[i]);
+            }
+        } else if (arg == "--dedup-output") {
+            options.dedup_options.archive_path = value_of(i);
+        } else if (arg == "--dictionary") {
+            options.dictionary = true;
+        } else if (arg == "--dict-size") {
+            try {
+                options.dictionary_size = std::stoul(value_of(i)) * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid dictionary size: " + args[i]);
+            }
+        } else if (arg == "--dict-samples") {
+            try {
+                options.dictionary_samples = std::stoul(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid dictionary sample count: " + args[i]);
+            }
+        } else if (arg == "--auto-min-speed") {
+            try {
+                options.auto_min_throughput = std::stod(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid minimum speed: " + args[i]);
+            }
+        } else if (arg == "--auto-max-ms") {
+            try {
+                options.auto_max_time_ms = std::stod(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid time limit: " + args[i]);
+            }
+        } else if (arg == "--auto-trial-blocks") {
+            try {
+                options.auto_trial_blocks = std::stoul(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid trial block count: " + args[i]);
+            }
+        } else if (arg == "--estimate") {
+            options.analysis.estimate = AnalysisOptions::Estimate::Only;
+        } else if (arg == "--estimate-check") {
+            options.analysis.estimate = AnalysisOptions::Estimate::Check;
+        } else if (arg == "--sample-blocks") {
+            try {
+                options.analysis.estimator.blocks = std::stoul(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid sample block count: " + args[i]);
+            }
+            if (options.analysis.estimator.blocks < 2) {
+                throw std::invalid_argument("--sample-blocks must be at least 2");
+            }
+        } else if (arg == "--sample-block-size") {
+            try {
+                options.analysis.estimator.block_size = std::stoul(value_of(i)) * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid sample block size: " + args[i]);
+            }
+            if (options.analysis.estimator.block_size == 0) {
+                throw std::invalid_argument("--sample-block-size must be positive");
+            }
+        } else if (arg == "--skip-above") {
+            try {
+                options.analysis.skip_ratio = std::stod(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid skip ratio: " + args[i]);
+            }
+            if (options.analysis.skip_ratio <= 0.0) {
+                throw std::invalid_argument("--skip-above must be positive");
+            }
+        } else if (arg == "--zstd-long") {
+            try {
+                options.zstd_long_window_log = std::stoi(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid long-distance window: " + args[i]);
+            }
+        } else if (arg == "--zstd-workers") {
+            try {
+                options.zstd_workers = static_cast<unsigned>(std::stoul(value_of(i)));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid zstd worker count: " + args[i]);
+            }
+        } else if (arg == "--lz4-format") {
+            std::string format = value_of(i);
+            if (format == "frame") options.lz4_block_format = false;
+            else if (format == "block") options.lz4_block_format = true;
+            else throw std::invalid_argument("Unknown LZ4 format: " + format);
+        } else if (arg == "--lz4-accel") {
+            try {
+                options.lz4_acceleration = std::stoi(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid LZ4 acceleration: " + args[i]);
+            }
+        } else if (arg == "--lz4-independent") {
+            options.lz4_independent_blocks = true;
+        } else if (arg == "--lz4-block-size") {
+            try {
+                options.lz4_block_size = std::stoul(value_of(i)) * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid LZ4 block size: " + args[i]);
+            }
+        } else if (arg == "--archive-layout") {
+            std::string layout = value_of(i);
+            if (layout == "stream") options.archive_indexed = false;
+            else if (layout == "indexed") options.archive_indexed = true;
+            else throw std::invalid_argument("Unknown archive layout: " + layout);
+        } else if (arg == "--archive-frame-size") {
+            try {
+                options.archive_frame_size = std::stoul(value_of(i)) * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid archive frame size: " + args[i]);
+            }
+        } else if (arg == "--archive-threads") {
+            try {
+                options.archive_threads = parseLevels(value_of(i));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid archive thread list: " + args[i]);
+            }
+        } else if (arg == "--xz-extreme") {
+            options.xz_extreme = true;
+        } else if (arg == "--xz-dict") {
+            try {
+                options.xz_dictionary_size = static_cast<uint32_t>(std::stoul(value_of(i)) * 1024);
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid xz dictionary size: " + args[i]);
+            }
+        } else if (arg == "--xz-threads") {
+            try {
+                options.xz_threads = static_cast<unsigned>(std::stoul(value_of(i)));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid xz thread count: " + args[i]);
+            }
+        } else if (arg == "--xz-block-size") {
+            try {
+                options.xz_block_size = std::stoull(value_of(i)) * 1024;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid xz block size: " + args[i]);
+            }
+        } else if (arg == "--warmup") {
+            try {
+                options.analysis.benchmark.warmup_runs = static_cast<unsigned>(std::stoul(value_of(i)));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid warmup count: " + args[i]);
+            }
+        } else if (arg == "-r" || arg == "--repetitions") {
+            try {
+                options.analysis.benchmark.repetitions = static_cast<unsigned>(std::stoul(value_of(i)));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid repetition count: " + args[i]);
+            }
+        } else if (arg == "--target-ci") {
+            try {
+                options.analysis.benchmark.target_ci = std::stod(value_of(i)) / 100.0;
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid confidence target: " + args[i]);
+            }
+        } else if (arg == "--max-repetitions") {
+            try {
+                options.analysis.benchmark.max_repetitions = static_cast<unsigned>(std::stoul(value_of(i)));
+            } catch (const std::logic_error&) {
+                throw std::invalid_argument("Invalid repetition limit: " + args[i]);
+            }
+        } else if (arg == "--no-recursive") {
+            options.recursive = false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("Unknown option: " + arg);
+        } else {
+            options.inputs.emplace_back(arg);
+        }
+    }
+
+    if (!options.show_help) {
+        if (options.inputs.empty()) {
+            throw std::invalid_argument("No input files or directories given");
+        }
+        auto compressor = CompressorFactory::create(options.codec);
+        if (!compressor) {
+            throw std::invalid_argument("Unknown codec: " + options.codec);
+        }
+        if (options.levels.empty() && options.sweep) {
+            for (int level = compressor->minLevel(); level <= compressor->maxLevel(); ++level) {
+                options.levels.push_back(level);
+            }
+        } else if (options.levels.empty()) {
+            options.levels = {compressor->defaultLevel()};
+        }
+        for (int level : options.levels) {
+            if (level < compressor->minLevel() || level > compressor->maxLevel()) {
+                throw std::invalid_argument("Compression level out of range (" + std::to_string(compressor->minLevel()) +
+                                            " to " + std::to_string(compressor->maxLevel()) + "): " +
+                                            std::to_string(level));
+            }
+        }
+
+        BatchOptions defaults;
+        bool deflate_parameters = options.window_bits != defaults.window_bits ||
+                                  options.mem_levels != defaults.mem_levels ||
+                                  options.strategies != defaults.strategies;
+        if (deflate_parameters && !dynamic_cast<GzipCompressor*>(compressor.get())) {
+            throw std::invalid_argument("--window-bits, --mem-level and --strategy apply to the gzip codec only");
+        }
+        if (!options.sweep && (options.window_bits.size() > 1 || options.mem_levels.size() > 1 ||
+                               options.strategies.size() > 1)) {
+            throw std::invalid_argument("Several --window-bits, --mem-level or --strategy values need --sweep");
+        }
+        if (options.dedup) {
+            if (options.sweep) {
+                throw std::invalid_argument("--dedup and --sweep cannot be combined");
+            }
+            if (dynamic_cast<ArchiveCompressor*>(compressor.get())) {
+                throw std::invalid_argument("--dedup compresses unique chunks with a single-stream codec, not archive");
+            }
+            // Fails early on inconsistent sizes
+            ContentChunker chunker(options.dedup_options.chunking);
+        } else if (options.dedup_options.archive_path != DedupOptions().archive_path) {
+            throw std::invalid_argument("--dedup-output needs --dedup");
+        }
+        if (options.dictionary) {
+            bool takes_dictionary = dynamic_cast<GzipCompressor*>(compressor.get()) != nullptr;
+#ifdef DCA_HAVE_ZSTD
+            takes_dictionary = takes_dictionary || dynamic_cast<ZstdCompressor*>(compressor.get());
+#endif
+            if (!takes_dictionary) {
+                throw std::invalid_argument("--dictionary applies to the gzip and zstd codecs only");
+            }
+            if (options.parallel_blocks) {
+                throw std::invalid_argument("--dictionary and --parallel-blocks cannot be combined");
+            }
+            if (options.dictionary_samples == 0) {
+                throw std::invalid_argument("--dict-samples must be positive");
+            }
+        } else if (options.dictionary_size != defaults.dictionary_size ||
+                   options.dictionary_samples != defaults.dictionary_samples) {
+            throw std::invalid_argument("--dict-size and --dict-samples need --dictionary");
+        }
+        if (options.sweep && dynamic_cast<ArchiveCompressor*>(compressor.get())) {
+            throw std::invalid_argument("--sweep works on individual files, not the archive codec");
+        }
+        if (options.archive_threads != defaults.archive_threads) {
+            if (!dynamic_cast<ArchiveCompressor*>(compressor.get()) || !options.archive_indexed) {
+                throw std::invalid_argument("--archive-threads needs the archive codec with --archive-layout indexed");
+            }
+            for (int threads : options.archive_threads) {
+                if (threads < 0) {
+                    throw std::invalid_argument("Archive thread count must not be negative: " + std::to_string(threads));
+                }
+            }
+        }
+        if (!options.cache.empty()) {
+            if (options.sweep || options.dedup || dynamic_cast<ArchiveCompressor*>(compressor.get())) {
+                throw std::invalid_argument("--cache applies to per-file rows, not --sweep, --dedup or the archive codec");
+            }
+            if (compressor->getCacheKey(compressor->defaultLevel()).empty()) {
+                throw std::invalid_argument("Results of the " + options.codec + " codec cannot be cached");
+            }
+        }
+        bool estimating = options.analysis.estimate != AnalysisOptions::Estimate::Off || options.analysis.skip_ratio > 0.0;
+        if (estimating && dynamic_cast<ArchiveCompressor*>(compressor.get())) {
+            throw std::invalid_argument("--estimate and --skip-above work on individual files, not the archive codec");
+        }
+        if (estimating && dynamic_cast<AutoCompressor*>(compressor.get())) {
+            throw std::invalid_argument("--estimate and --skip-above cannot be combined with the auto codec");
+        }
+    }
+    return options;
+}
+
+void BatchRunner::printUsage(std::ostream& out, const std::string& program) {
+    out << "Usage: " << program << " [options] <file|directory>...\n"
+        << "\n"
+        << "Options:\n"
+        << "  -c, --codec NAME      Compressor to use (";
+    auto names = CompressorFactory::names();
+    for (size_t i = 0; i < names.size(); ++i) {
+        out << names[i] << (i + 1 < names.size() ? ", " : "");
+    }
+    out << "; default gzip)\n"
+        << "  -l, --levels LIST     Levels as N, N-M or N,M,... (default: the codec's default)\n"
+        << "  -j, --threads N       Worker threads (default: hardware concurrency)\n"
+        << "  -f, --format FORMAT   text, csv or json (default text)\n"
+        << "  -o, --output PATH     Write results to PATH instead of stdout\n"
+        << "      --no-recursive    Do not descend into subdirectories\n"
+        << "      --cache DIR       Reuse rows of files analyzed before with the same content\n"
+        << "                        and settings, and store new ones, in the cache in DIR\n"
+        << "      --stream          Compress and verify in constant memory via a temp file\n"
+        << "      --stream-threshold MB  Stream files at least this large (default 1024)\n"
+        << "      --entropy-window KB  Window of the per-region entropy profile (default 64)\n"
+        << "      --parallel-blocks Gzip: deflate independent blocks on several threads\n"
+        << "      --block-size KB   Gzip: input block size for --parallel-blocks (default 128)\n"
+        << "      --block-threads N Gzip: threads for --parallel-blocks (default: all cores)\n"
+        << "      --window-bits LIST  Gzip: deflate window as log2 bytes, 9-15 (default 15)\n"
+        << "      --mem-level LIST  Gzip: deflate memLevel, 1-9 (default 8)\n"
+        << "      --strategy LIST   Gzip: default, filtered, huffman, rle or fixed\n"
+        << "      --sweep           Run every level/parameter combination and report the\n"
+        << "                        ratio vs. throughput Pareto frontier per file type\n"
+        << "                        (levels default to the codec's full range)\n"
+        << "      --frontier-only   Sweep: list only the Pareto-optimal configurations\n"
+        << "      --dedup           Split files into content-defined chunks, deduplicate them\n"
+        << "                        across all files and report dedup and dedup+compress ratios\n"
+        << "      --chunk-min KB    Dedup: minimum chunk size (default 2)\n"
+        << "      --chunk-avg KB    Dedup: target average chunk size, a power of two (default 8)\n"
+        << "      --chunk-max KB    Dedup: maximum chunk size (default 64)\n"
+        << "      --dedup-output PATH  Dedup: also write the deduplicated archive to PATH\n"
+        << "      --dictionary      Gzip, zstd: train a shared dictionary on a sample of the\n"
+        << "                        files and compress the other files with it (gzip output\n"
+        << "                        is then zlib-wrapped)\n"
+        << "      --dict-size KB    Dictionary: maximum size (default 32 gzip, 110 zstd)\n"
+        << "      --dict-samples N  Dictionary: files sampled for training, at most half\n"
+        << "                        (default 1000)\n"
+        << "      --auto-min-speed MBPS  Auto: compression speed each choice must reach (default 100, 0 = any)\n"
+        << "      --auto-max-ms MS  Auto: predicted compression time limit per file (default none)\n"
+        << "      --auto-trial-blocks N  Auto: sampled blocks each setting compresses per file (default 4)\n"
+        << "      --estimate        Extrapolate ratio and speeds from sampled blocks instead\n"
+        << "                        of compressing whole files\n"
+        << "      --estimate-check  Estimate, then run in full and report the estimate's error\n"
+        << "      --sample-blocks N Blocks sampled per file, one per equal stratum (default 32)\n"
+        << "      --sample-block-size KB  Size of each sampled block (default 128)\n"
+        << "      --skip-above RATIO  Estimate first and skip the full run for files whose\n"
+        << "                        ratio is at least RATIO even at the 95% low bound\n"
+        << "      --zstd-long LOG   Zstd: long-distance matching with a 2^LOG byte window\n"
+        << "      --zstd-workers N  Zstd: internal compression threads (default 0)\n"
+        << "      --lz4-format FMT  LZ4: frame or block (default frame)\n"
+        << "      --lz4-accel N     LZ4: acceleration for levels 1-2 (default 1)\n"
+        << "      --lz4-independent LZ4: frame blocks do not reference earlier blocks\n"
+        << "      --lz4-block-size KB  LZ4: frame block size, 64, 256, 1024 or 4096 (default 64)\n"
+        << "      --archive-layout L  Archive: stream (one gzip stream) or indexed (independent\n"
+        << "                        frames and a central directory for single-member extraction)\n"
+        << "      --archive-frame-size KB  Archive: uncompressed bytes per indexed frame, 0 for one\n"
+        << "                        frame per member (default 1024)\n"
+        << "      --archive-threads LIST  Archive: threads deflating and inflating indexed frames,\n"
+        << "                        one run per value, 0 for all cores (default 1); archive\n"
+        << "                        runs go one at a time whatever --threads is\n"
+        << "      --xz-extreme      Xz: the presets' extreme variants (xz -e)\n"
+        << "      --xz-dict KB      Xz: dictionary size (default: the preset's)\n"
+        << "      --xz-threads N    Xz: multithreaded block encoder with N threads (default 0)\n"
+        << "      --xz-block-size KB  Xz: input per block with --xz-threads (default 3x dictionary)\n"
+        << "      --warmup N        Untimed runs before measuring (default 0)\n"
+        << "  -r, --repetitions N   Measured runs per file and level (default 1)\n"
+        << "      --target-ci PCT   Repeat until the 95% CI of mean throughput is within PCT%\n"
+        << "      --max-repetitions N  Upper bound for --target-ci (default 100)\n"
+        << "  -h, --help            Show this message\n";
+}
+
+std::vector<std::filesystem::path> BatchRunner::collectFiles() const {
+    std::vector<std::filesystem::path> files;
+    for (const auto& input : options_.inputs) {
+        if (std::filesystem::is_directory(input)) {
+            std::vector<std::filesystem::path> found;
+            auto add_entry = [&](const std::filesystem::directory_entry& entry) {
+                if (entry.is_regular_file()) found.push_back(entry.path());
+            };
+            auto dir_options = std::filesystem::directory_options::skip_permission_denied;
+            if (options_.recursive) {
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(input, dir_options)) {
+                    add_entry(entry);
+                }
+            } else {
+                for (const auto& entry : std::filesystem::directory_iterator(input, dir_options)) {
+                    add_entry(entry);
+                }
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        } else if (std::filesystem::exists(input)) {
+            files.push_back(input);
+        } else {
+            throw std::runtime_error("Input does not exist: " + input.string());
+        }
+    }
+    return files;
+}
+
+unsigned BatchRunner::resolveThreadCount(size_t job_count) const {
+    unsigned threads = options_.threads;
+    if (threads == 0) {
+        threads = ThreadPool::defaultThreadCount();
+    }
+    return static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(job_count, 1)));
+}
+
+std::unique_ptr<Compressor> BatchRunner::createCompressor() const {
+    auto compressor = CompressorFactory::create(options_.codec);
+    if (auto* gzip = dynamic_cast<GzipCompressor*>(compressor.get())) {
+        GzipCompressor::Options gzip_options;
+        gzip_options.parallel = options_.parallel_blocks;
+        gzip_options.block_size = options_.block_size;
+        gzip_options.threads = options_.block_threads;
+        gzip_options.window_bits = options_.window_bits.front();
+        gzip_options.mem_level = options_.mem_levels.front();
+        gzip_options.strategy = options_.strategies.front();
+        gzip->setOptions(gzip_options);
+    }
+#ifdef DCA_HAVE_ZSTD
+    if (auto* zstd = dynamic_cast<ZstdCompressor*>(compressor.get())) {
+        ZstdCompressor::Options zstd_options;
+        zstd_options.long_window_log = options_.zstd_long_window_log;
+        zstd_options.workers = options_.zstd_workers;
+        zstd->setOptions(zstd_options);
+    }
+#endif
+#ifdef DCA_HAVE_LZ4
+    if (auto* lz4 = dynamic_cast<Lz4Compressor*>(compressor.get())) {
+        Lz4Compressor::Options lz4_options;
+        lz4_options.format = options_.lz4_block_format ? Lz4Compressor::Format::Block : Lz4Compressor::Format::Frame;
+        lz4_options.acceleration = options_.lz4_acceleration;
+        lz4_options.independent_blocks = options_.lz4_independent_blocks;
+        lz4_options.block_size = options_.lz4_block_size;
+        lz4->setOptions(lz4_options);
+    }
+#endif
+#ifdef DCA_HAVE_XZ
+    if (auto* xz = dynamic_cast<XzCompressor*>(compressor.get())) {
+        XzCompressor::Options xz_options;
+        xz_options.extreme = options_.xz_extreme;
+        xz_options.dictionary_size = options_.xz_dictionary_size;
+        xz_options.threads = options_.xz_threads;
+        xz_options.block_size = options_.xz_block_size;
+        xz->setOptions(xz_options);
+    }
+#endif
+    if (auto* archive = dynamic_cast<ArchiveCompressor*>(compressor.get())) {
+        ArchiveCompressor::Options archive_options;
+        archive_options.layout = options_.archive_indexed ? ArchiveCompressor::Layout::Indexed
+                                                          : ArchiveCompressor::Layout::Stream;
+        archive_options.frame_size = options_.archive_frame_size;
+        archive_options.threads = static_cast<unsigned>(options_.archive_threads.front());
+        archive->setOptions(archive_options);
+    }
+    if (auto* selector = dynamic_cast<AutoCompressor*>(compressor.get())) {
+        AutoCompressor::Options auto_options;
+        auto_options.min_throughput = options_.auto_min_throughput;
+        auto_options.max_time_ms = options_.auto_max_time_ms;
+        auto_options.trial.blocks = options_.auto_trial_blocks;
+        selector->setOptions(auto_options);
+    }
+    return compressor;
+}
+
+TrainedDictionary BatchRunner::applyDictionary(Compressor& compressor,
+                                               const std::vector<std::filesystem::path>& files) const {
+    DictionaryTrainer::Options trainer_options;
+    trainer_options.max_samples = options_.dictionary_samples;
+    if (auto* gzip = dynamic_cast<GzipCompressor*>(&compressor)) {
+        if (options_.dictionary_size) {
+            trainer_options.max_size = options_.dictionary_size;
+        }
+        TrainedDictionary dictionary = DictionaryTrainer::trainFromFiles(files, trainer_options);
+        GzipCompressor::Options gzip_options = gzip->getOptions();
+        gzip_options.dictionary = dictionary.data;
+        gzip->setOptions(gzip_options);
+        return dictionary;
+    }
+#ifdef DCA_HAVE_ZSTD
+    if (auto* zstd = dynamic_cast<ZstdCompressor*>(&compressor)) {
+        // zstd's own default; it indexes all of it, unlike deflate's 32 KB window
+        trainer_options.max_size = options_.dictionary_size ? options_.dictionary_size : 110 * 1024;
+        trainer_options.zstd_format = true;
+        TrainedDictionary dictionary = DictionaryTrainer::trainFromFiles(files, trainer_options);
+        ZstdCompressor::Options zstd_options = zstd->getOptions();
+        zstd_options.dictionary = dictionary.data;
+        zstd->setOptions(zstd_options);
+        return dictionary;
+    }
+#endif
+    throw std::invalid_argument("The " + compressor.getName() + " codec cannot use a dictionary");
+}
+
+int BatchRunner::run() {
+    auto files = collectFiles();
+    if (files.empty()) {
+        std::cerr << "Error: no files found" << std::endl;
+        return 1;
+    }
+
+    // Codec options are validated here, before any output is written
+    auto compressor = createCompressor();
+    auto* archive = dynamic_cast<ArchiveCompressor*>(compressor.get());
+    TrainedDictionary dictionary;
+    if (options_.dictionary) {
+        // Only the held-out files are measured
+        auto split = DictionaryTrainer::splitFiles(files, options_.dictionary_samples);
+        dictionary = applyDictionary(*compressor, split.training);
+        files = std::move(split.measured);
+    }
+
+    std::unique_ptr<ResultCache> cache;
+    AnalysisOptions analysis = options_.analysis;
+    if (!options_.cache.empty()) {
+        cache = std::make_unique<ResultCache>(options_.cache);
+        analysis.cache = cache.get();
+    }
+
+    std::ofstream file_out;
+    if (!options_.output.empty()) {
+        file_out.open(options_.output);
+        if (!file_out) {
+            throw std::runtime_error("Failed to create output file: " + options_.output.string());
+        }
+    }
+    std::ostream& out = options_.output.empty() ? std::cout : file_out;
+    // Summaries outside the table; CSV and JSON output stays machine-readable
+    std::ostream& notes = options_.format == BatchOptions::Format::Text ? out : std::cerr;
+
+    if (options_.sweep) {
+        SweepSpace space;
+        space.levels = options_.levels;
+        space.window_bits = options_.window_bits;
+        space.mem_levels = options_.mem_levels;
+        space.strategies = options_.strategies;
+        size_t configurations = options_.levels.size() * options_.window_bits.size() *
+                                options_.mem_levels.size() * options_.strategies.size();
+        ThreadPool pool(resolveThreadCount(files.size() * configurations));
+        // Per-file rows are only aggregated; errors still go to stderr
+        ResultCollector collector(
+            nullptr, [](const std::string& message) { std::cerr << "Error: " << message << std::endl; });
+        auto points = Sweep::run(*compressor, files, space, pool, collector, options_.analysis);
+        writeSweepReport(out, options_.format, points, options_.frontier_only);
+        if (options_.dictionary) {
+            writeDictionarySummary(notes, dictionary, {});
+        }
+        return collector.errors().empty() ? 0 : 1;
+    }
+
+    if (options_.dedup) {
+        ThreadPool pool(resolveThreadCount(files.size()));
+        ResultCollector collector(
+            nullptr, [](const std::string& message) { std::cerr << "Error: " << message << std::endl; });
+        DedupOptions dedup_options = options_.dedup_options;
+        dedup_options.level = options_.levels.front();
+        auto result = Dedup::run(*compressor, files, dedup_options, pool, collector);
+        writeDedupReport(out, options_.format, result);
+        if (options_.dictionary) {
+            writeDictionarySummary(notes, dictionary, {});
+        }
+        return collector.errors().empty() ? 0 : 1;
+    }
+
+    ResultWriter writer(out, options_.format);
+    writer.begin();
+
+    ResultCollector collector(
+        [&writer](const AnalysisResult& row) { writer.write(row); },
+        [](const std::string& message) { std::cerr << "Error: " << message << std::endl; });
+
+    // One archive compressor per --archive-threads value; the first is compressor
+    std::vector<std::unique_ptr<Compressor>> archive_variants;
+    std::vector<ArchiveCompressor*> archives;
+    if (archive) {
+        archives.push_back(archive);
+        for (size_t i = 1; i < options_.archive_threads.size(); ++i) {
+            archive_variants.push_back(CompressorFactory::create(options_.codec));
+            auto* variant = static_cast<ArchiveCompressor*>(archive_variants.back().get());
+            ArchiveCompressor::Options archive_options = archive->getOptions();
+            archive_options.threads = static_cast<unsigned>(options_.archive_threads[i]);
+            variant->setOptions(archive_options);
+            archives.push_back(variant);
+        }
+    }
+
+    size_t job_count = archive ? options_.levels.size() * archives.size() : files.size() * options_.levels.size();
+    // Archive runs (one per level and thread count) go one at a time so the
+    // timings they are compared on do not include contention with each other
+    ThreadPool pool(archive ? 1 : resolveThreadCount(job_count));
+
+    if (archive) {
+        // One archive per level and thread count; the archive itself is a single job
+        for (ArchiveCompressor* variant : archives) {
+            for (int level : options_.levels) {
+                pool.submit([this, variant, &files, &collector, level]() {
+                    try {
+                        collector.add(Analyzer::analyzeArchive(*variant, files, level, options_.analysis));
+                    } catch (const std::exception& e) {
+                        collector.addError("Error processing archive: " + std::string(e.what()));
+                    }
+                });
+            }
+        }
+        pool.wait();
+    } else {
+        Analyzer::analyzeFiles(*compressor, files, options_.levels, pool, collector, analysis);
+    }
+
+    writer.end();
+    if (auto* selector = dynamic_cast<AutoCompressor*>(compressor.get())) {
+        writePolicyComparison(notes, selector->comparison());
+    }
+    if (options_.dictionary) {
+        writeDictionarySummary(notes, dictionary, collector.snapshot());
+    }
+    if (cache) {
+        writeCacheSummary(notes, *cache);
+    }
+    return collector.errors().empty() ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../analysis/Analyzer.h"
+#include "../analysis/Dedup.h"
+#include "../analysis/Sweep.h"
+#include "../compression/DictionaryTrainer.h"
+
+// Command-line options for a headless analysis run
+struct BatchOptions {
+    enum class Format { Text, CSV, JSON };
+
+    std::vector<std::filesystem::path> inputs;  // Files and/or directories
+    std::string codec = "gzip";
+    std::vector<int> levels;                     // Empty = the codec's default level
+    unsigned threads = 0;                        // 0 = hardware concurrency
+    Format format = Format::Text;
+    std::filesystem::path output;                // Empty = stdout
+    bool recursive = true;
+    // Reuse rows of unchanged files from a result cache here (see ResultCache)
+    std::filesystem::path cache;
+
+    AnalysisOptions analysis;
+
+    // Block-parallel gzip
+    bool parallel_blocks = false;
+    size_t block_size = 128 * 1024;
+    unsigned block_threads = 0;                  // 0 = hardware concurrency
+
+    // Gzip deflate parameters; more than one value each needs sweep
+    std::vector<int> window_bits = {15};
+    std::vector<int> mem_levels = {8};
+    std::vector<int> strategies = {Z_DEFAULT_STRATEGY};
+
+    // Run every combination of levels and deflate parameters and report the
+    // ratio/throughput Pareto frontier per file type instead of file rows
+    bool sweep = false;
+    bool frontier_only = false;                  // Leave dominated configurations out of the report
+
+    // Chunk every file, deduplicate across the corpus and report dedup and
+    // dedup+compress ratios instead of file rows (level: the first of levels)
+    bool dedup = false;
+    DedupOptions dedup_options;
+
+    // Shared dictionary trained on a sample of the inputs before the run
+    // (gzip and zstd); its build time is reported apart from the rows
+    bool dictionary = false;
+    size_t dictionary_size = 0;                  // 0 = 32 KB for gzip, 110 KB for zstd
+    size_t dictionary_samples = 1000;            // Files sampled, evenly spread
+
+    // Zstandard
+    int zstd_long_window_log = 0;                // 0 = no long-distance matching
+    unsigned zstd_workers = 0;
+
+    // LZ4
+    bool lz4_block_format = false;               // Raw block instead of the frame format
+    int lz4_acceleration = 1;
+    bool lz4_independent_blocks = false;
+    size_t lz4_block_size = 64 * 1024;
+
+    // xz
+    bool xz_extreme = false;
+    uint32_t xz_dictionary_size = 0;             // 0 = the preset's
+    unsigned xz_threads = 0;                     // 0 = single-threaded encoder
+    uint64_t xz_block_size = 0;                  // 0 = liblzma's default
+
+    // Archive layout (see ArchiveCompressor::Options)
+    bool archive_indexed = false;                // Independent frames plus a central directory
+    size_t archive_frame_size = 1024 * 1024;     // 0 = one frame per member
+    // Indexed frame threads, one archive run per value; 0 = all cores
+    std::vector<int> archive_threads = {1};
+
+    // Auto selection budget (see AutoCompressor::Options)
+    double auto_min_throughput = 100.0;          // MB/s; 0 = no floor
+    double auto_max_time_ms = 0.0;               // Per file; 0 = no limit
+    size_t auto_trial_blocks = 4;
+    bool show_help = false;
+};
+
+// Drives the same compressors and FileHandler helpers as the GUI, without
+// creating a window, and streams one result row per (file, level) as soon as
+// it is ready.
+class BatchRunner {
+public:
+    explicit BatchRunner(BatchOptions options);
+
+    // Returns a process exit code: 0 on success, 1 if any file failed
+    int run();
+
+    // Parse, run and report errors; shared by both executables' main()
+    static int runCommandLine(const std::vector<std::string>& args, const std::string& program);
+
+    // Parse argv (excluding any leading "--batch"); throws std::invalid_argument
+    static BatchOptions parseArguments(const std::vector<std::string>& args);
+    static void printUsage(std::ostream& out, const std::string& program);
+
+private:
+    BatchOptions options_;
+
+    std::vector<std::filesystem::path> collectFiles() const;
+    unsigned resolveThreadCount(size_t job_count) const;
+
+    // The selected codec with its codec-specific options applied
+    std::unique_ptr<Compressor> createCompressor() const;
+    // Trains the --dictionary dictionary on files and sets it on compressor
+    TrainedDictionary applyDictionary(Compressor& compressor, const std::vector<std::filesystem::path>& files) const;
+};
\ No newline at end of file
@@ -0,0 +1,5 @@
+#include "BatchRunner.h"
+
+int main(int argc, char* argv[]) {
+    return BatchRunner::runCommandLine(std::vector<std::string>(argv + 1, argv + argc), argv[0]);
+}
\ No newline at end of file
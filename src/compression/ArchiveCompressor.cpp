@@ -1,8 +1,595 @@
 #include "ArchiveCompressor.h"
+#include "../compression/ZlibContextPool.h"
+#include "../utils/ScratchArena.h"
+#include "../utils/ThreadPool.h"
 #include <zlib.h>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <unordered_set>
+
+namespace {
+
+constexpr char kIndexMagic[4] = {'D', 'C', 'A', 'X'};
+constexpr uint32_t kIndexVersion = 1;
+constexpr size_t kIndexHeaderSize = 8;
+constexpr size_t kIndexTrailerSize = 24;
+
+// Longest member name accepted when parsing; anything longer is corruption
+constexpr uint32_t kMaxNameLength = 64 * 1024;
+// Deflate's best case is about 1032:1 (a 258-byte match in a 2-bit code)
+constexpr uint64_t kMaxDeflateRatio = 1032;
+
+// Members timed individually for the single-member extraction latency
+constexpr size_t kLatencySamples = 16;
+
+template <typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// Reads a T at pos and advances it; throws instead of reading past the end
+template <typename T>
+T get(ByteView data, size_t& pos) {
+    if (pos > data.size() || data.size() - pos < sizeof(T)) {
+        throw std::runtime_error("Corrupt archive: unexpected end of data");
+    }
+    T value;
+    std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+struct Trailer {
+    uint64_t directory_offset;
+    uint64_t entry_count;
+    uint32_t directory_crc;
+};
+
+Trailer parseTrailer(ByteView trailer) {
+    size_t pos = 0;
+    Trailer result;
+    result.directory_offset = get<uint64_t>(trailer, pos);
+    result.entry_count = get<uint64_t>(trailer, pos);
+    result.directory_crc = get<uint32_t>(trailer, pos);
+    if (std::memcmp(trailer.data() + pos, kIndexMagic, sizeof(kIndexMagic)) != 0) {
+        throw std::runtime_error("Corrupt archive: bad trailer");
+    }
+    return result;
+}
+
+std::vector<ArchiveCompressor::MemberEntry> parseDirectory(ByteView directory, const Trailer& trailer) {
+    if (crc32(0, directory.data(), static_cast<uInt>(directory.size())) != trailer.directory_crc) {
+        throw std::runtime_error("Corrupt archive: directory checksum mismatch");
+    }
+    // Every entry takes at least 40 bytes, which bounds a corrupt count
+    if (trailer.entry_count > directory.size() / 40) {
+        throw std::runtime_error("Corrupt archive: bad entry count");
+    }
+    std::vector<ArchiveCompressor::MemberEntry> entries(trailer.entry_count);
+    size_t pos = 0;
+    for (auto& entry : entries) {
+        uint32_t name_len = get<uint32_t>(directory, pos);
+        if (name_len > kMaxNameLength || directory.size() - pos < name_len) {
+            throw std::runtime_error("Corrupt archive: bad member name");
+        }
+        entry.name.assign(reinterpret_cast<const char*>(directory.data() + pos), name_len);
+        pos += name_len;
+        entry.frame_offset = get<uint64_t>(directory, pos);
+        entry.frame_size = get<uint64_t>(directory, pos);
+        entry.offset = get<uint64_t>(directory, pos);
+        entry.size = get<uint64_t>(directory, pos);
+        entry.crc = get<uint32_t>(directory, pos);
+        if (entry.frame_offset < kIndexHeaderSize || entry.frame_offset > trailer.directory_offset ||
+            trailer.directory_offset - entry.frame_offset < entry.frame_size ||
+            entry.offset + entry.size < entry.offset) {
+            throw std::runtime_error("Corrupt archive: member outside the archive: " + entry.name);
+        }
+        // The frame must be able to inflate to the member's end, so a corrupt
+        // entry cannot ask for an allocation the archive could never fill
+        if ((entry.offset + entry.size) / kMaxDeflateRatio > entry.frame_size) {
+            throw std::runtime_error("Corrupt archive: member larger than its frame can hold: " + entry.name);
+        }
+    }
+    return entries;
+}
+
+// Uncompressed size of the frame holding entries[index]: it ends where the
+// last member sharing its frame ends. Entries of one frame are adjacent.
+uint64_t frameDataSize(const std::vector<ArchiveCompressor::MemberEntry>& entries, size_t index) {
+    uint64_t size = 0;
+    for (size_t i = index; i < entries.size() && entries[i].frame_offset == entries[index].frame_offset; ++i) {
+        size = std::max(size, entries[i].offset + entries[i].size);
+    }
+    return size;
+}
+
+using Members = std::vector<std::pair<std::string, std::vector<uint8_t>>>;
+using TrackedBuffer = std::vector<uint8_t, TrackingAllocator<uint8_t>>;
+
+// Pieces handed to zlib, whose lengths are 32-bit
+constexpr size_t kMaxPiece = size_t(1) << 30;
+
+uint32_t updateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+    for (size_t done = 0; done < size;) {
+        uInt piece = static_cast<uInt>(std::min(size - done, kMaxPiece));
+        crc = crc32(crc, data + done, piece);
+        done += piece;
+    }
+    return crc;
+}
+
+// A member joins the open frame unless it would take it past frame_size;
+// an empty frame takes any member, so large members get a frame of their own
+bool closesFrame(uint64_t frame_data, uint64_t member_size, size_t frame_size) {
+    return frame_data > 0 && frame_data + member_size > frame_size;
+}
+
+// [first, last) entry ranges sharing a frame; entries of one frame are adjacent
+std::vector<std::pair<size_t, size_t>> groupFrames(const std::vector<ArchiveCompressor::MemberEntry>& entries) {
+    std::vector<std::pair<size_t, size_t>> frames;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (frames.empty() || entries[i].frame_offset != entries[frames.back().first].frame_offset) {
+            frames.emplace_back(i, i);
+        }
+        frames.back().second = i + 1;
+    }
+    return frames;
+}
+
+void checkMemberCrc(const ArchiveCompressor::MemberEntry& entry, const uint8_t* data) {
+    uint32_t crc = updateCrc(0, data, static_cast<size_t>(entry.size));
+    if (crc != entry.crc) {
+        throw std::runtime_error("Corrupt archive: checksum mismatch in " + entry.name);
+    }
+}
+
+// The last entry with the name, matching ExtractedArchive's index
+const ArchiveCompressor::MemberEntry* findLast(const std::vector<ArchiveCompressor::MemberEntry>& entries,
+                                               const std::string& name) {
+    auto it = std::find_if(entries.rbegin(), entries.rend(),
+                           [&](const ArchiveCompressor::MemberEntry& e) { return e.name == name; });
+    if (it == entries.rend()) {
+        throw std::out_of_range("No such archive member: " + name);
+    }
+    return &*it;
+}
+
+// One frame compressed on its own, with the directory entries of its
+// members (frame_offset and frame_size are filled in when it is placed)
+struct CompressedFrame {
+    TrackedBuffer data;
+    std::vector<ArchiveCompressor::MemberEntry> members;
+    std::chrono::nanoseconds setup_time{0};
+};
+
+// Deflates files[first, last) as one gzip frame. Runs on a pool worker in
+// parallel mode, so it leases from that worker's own context pool; the
+// trackers are atomic and shared by all frames of the call.
+CompressedFrame deflateFrame(const Members& files, size_t first, size_t last, int level,
+                             Compressor::CallStats* stats) {
+    auto strm = ZlibContextPool::local().acquireDeflate(level);
+    if (stats) {
+        strm.attachTracker(&stats->codec_memory);
+    }
+    CompressedFrame frame{TrackedBuffer(TrackingAllocator<uint8_t>(stats ? &stats->buffer_memory : nullptr))};
+    frame.setup_time = strm.setupTime();
+
+    uint64_t frame_data = 0;
+    for (size_t i = first; i < last; ++i) {
+        frame_data += files[i].second.size();
+    }
+    frame.data.resize(deflateBound(strm.get(), static_cast<uLong>(frame_data)));
+
+    size_t out_pos = 0;
+    auto feed = [&](const uint8_t* data, size_t size, int flush) {
+        size_t in_pos = 0;
+        int ret;
+        do {
+            if (out_pos == frame.data.size()) {
+                frame.data.resize(frame.data.size() * 2);
+            }
+            uInt in_piece = static_cast<uInt>(std::min(size - in_pos, kMaxPiece));
+            uInt out_piece = static_cast<uInt>(std::min(frame.data.size() - out_pos, kMaxPiece));
+            strm->next_in = const_cast<Bytef*>(data + in_pos);
+            strm->avail_in = in_piece;
+            strm->next_out = frame.data.data() + out_pos;
+            strm->avail_out = out_piece;
+            int mode = in_pos + in_piece == size ? flush : Z_NO_FLUSH;
+            ret = deflate(strm.get(), mode);
+            if (ret == Z_STREAM_ERROR) {
+                throw std::runtime_error(std::string("zlib error during deflate: ") + zError(ret));
+            }
+            in_pos += in_piece - strm->avail_in;
+            out_pos += out_piece - strm->avail_out;
+        } while (in_pos < size || (flush == Z_FINISH ? ret != Z_STREAM_END : strm->avail_out == 0));
+    };
+
+    uint64_t offset = 0;
+    for (size_t i = first; i < last; ++i) {
+        const auto& [name, data] = files[i];
+        ArchiveCompressor::MemberEntry entry;
+        entry.name = name;
+        entry.offset = offset;
+        entry.size = data.size();
+        entry.crc = updateCrc(0, data.data(), data.size());
+        frame.members.push_back(std::move(entry));
+        feed(data.data(), data.size(), Z_NO_FLUSH);
+        offset += data.size();
+    }
+    feed(nullptr, 0, Z_FINISH);
+    frame.data.resize(out_pos);
+    return frame;
+}
+
+// Size of the stream layout for the same members: one deflate over every
+// header and member, output counted and discarded. This is what the
+// indexed layout would be if frames could share history.
+uint64_t singleStreamSize(const Members& files, int level) {
+    auto strm = ZlibContextPool::local().acquireDeflate(level);
+    std::vector<uint8_t> out(Compressor::kStreamChunkSize);
+    uint64_t produced = 0;
+    auto feed = [&](const uint8_t* data, size_t size, int flush) {
+        size_t in_pos = 0;
+        int ret;
+        do {
+            uInt in_piece = static_cast<uInt>(std::min(size - in_pos, kMaxPiece));
+            strm->next_in = const_cast<Bytef*>(data + in_pos);
+            strm->avail_in = in_piece;
+            strm->next_out = out.data();
+            strm->avail_out = static_cast<uInt>(out.size());
+            ret = deflate(strm.get(), in_pos + in_piece == size ? flush : Z_NO_FLUSH);
+            if (ret == Z_STREAM_ERROR) {
+                throw std::runtime_error(std::string("zlib error during deflate: ") + zError(ret));
+            }
+            in_pos += in_piece - strm->avail_in;
+            produced += out.size() - strm->avail_out;
+        } while (in_pos < size || (flush == Z_FINISH ? ret != Z_STREAM_END : strm->avail_out == 0));
+    };
+    for (const auto& [name, data] : files) {
+        std::vector<uint8_t> header;
+        put(header, static_cast<uint32_t>(name.size()));
+        header.insert(header.end(), name.begin(), name.end());
+        put(header, static_cast<uint64_t>(data.size()));
+        feed(header.data(), header.size(), Z_NO_FLUSH);
+        feed(data.data(), data.size(), Z_NO_FLUSH);
+    }
+    feed(nullptr, 0, Z_FINISH);
+    return produced;
+}
+
+// Writes the indexed layout one member at a time. A frame's deflate stream
+// stays open across members until the next member would overfill it, and
+// compressed output goes to the sink in kStreamChunkSize pieces.
+class IndexedWriter {
+public:
+    IndexedWriter(ByteSink& sink, int level, size_t frame_size, Compressor::CallStats& stats)
+        : sink_(sink), level_(level), frame_size_(frame_size), stats_(stats) {
+        std::vector<uint8_t> header(kIndexMagic, kIndexMagic + sizeof(kIndexMagic));
+        put(header, kIndexVersion);
+        emit(header.data(), header.size());
+    }
+
+    void beginMember(const std::string& name, uint64_t size) {
+        if (frame_ && closesFrame(frame_data_, size, frame_size_)) {
+            closeFrame();
+        }
+        if (out_.empty()) {
+            out_.resize(Compressor::kStreamChunkSize);
+            stats_.buffer_memory.allocate(out_.size());
+        }
+        if (!frame_) {
+            frame_.emplace(ZlibContextPool::local().acquireDeflate(level_));
+            frame_->attachTracker(&stats_.codec_memory);
+            stats_.setup_time += frame_->setupTime();
+            frame_start_ = written_;
+            frame_first_ = entries_.size();
+            frame_data_ = 0;
+        }
+        ArchiveCompressor::MemberEntry entry;
+        entry.name = name;
+        entry.frame_offset = frame_start_;
+        entry.offset = frame_data_;
+        entries_.push_back(std::move(entry));
+        crc_ = 0;
+    }
+
+    void write(const uint8_t* data, size_t size) {
+        crc_ = updateCrc(crc_, data, size);
+        deflateChunk(data, size, Z_NO_FLUSH);
+        frame_data_ += size;
+        entries_.back().size += size;
+    }
+
+    void endMember() { entries_.back().crc = crc_; }
+
+    // Appends a frame compressed elsewhere, after closing the open one
+    void addFrame(const CompressedFrame& frame) {
+        if (frame_) {
+            closeFrame();
+        }
+        uint64_t frame_offset = written_;
+        emit(frame.data.data(), frame.data.size());
+        for (auto entry : frame.members) {
+            entry.frame_offset = frame_offset;
+            entry.frame_size = frame.data.size();
+            entries_.push_back(std::move(entry));
+        }
+    }
+
+    // Closes the last frame and writes the directory and trailer
+    void finish() {
+        if (frame_) {
+            closeFrame();
+        }
+        std::vector<uint8_t> directory;
+        for (const auto& entry : entries_) {
+            put(directory, static_cast<uint32_t>(entry.name.size()));
+            directory.insert(directory.end(), entry.name.begin(), entry.name.end());
+            put(directory, entry.frame_offset);
+            put(directory, entry.frame_size);
+            put(directory, entry.offset);
+            put(directory, entry.size);
+            put(directory, entry.crc);
+        }
+        uint64_t directory_offset = written_;
+        uint32_t directory_crc = crc32(0, directory.data(), static_cast<uInt>(directory.size()));
+        put(directory, directory_offset);
+        put(directory, static_cast<uint64_t>(entries_.size()));
+        put(directory, directory_crc);
+        directory.insert(directory.end(), kIndexMagic, kIndexMagic + sizeof(kIndexMagic));
+        emit(directory.data(), directory.size());
+        sink_.flush();
+    }
+
+    uint64_t bytesWritten() const { return written_; }
+
+private:
+    ByteSink& sink_;
+    int level_;
+    size_t frame_size_;
+    Compressor::CallStats& stats_;
+    std::vector<uint8_t> out_;
+    std::optional<ZlibContextPool::Lease> frame_;
+    std::vector<ArchiveCompressor::MemberEntry> entries_;
+    size_t frame_first_ = 0;    // First entry in the open frame
+    uint64_t frame_start_ = 0;  // Archive offset of the open frame
+    uint64_t frame_data_ = 0;   // Uncompressed bytes in the open frame
+    uint64_t written_ = 0;
+    uint32_t crc_ = 0;
+
+    void emit(const uint8_t* data, size_t size) {
+        sink_.write(data, size);
+        written_ += size;
+    }
+
+    void deflateChunk(const uint8_t* data, size_t size, int flush) {
+        z_stream* strm = frame_->get();
+        size_t pos = 0;
+        int ret;
+        do {
+            uInt piece = static_cast<uInt>(std::min(size - pos, kMaxPiece));
+            strm->next_in = const_cast<Bytef*>(data + pos);
+            strm->avail_in = piece;
+            int mode = pos + piece == size ? flush : Z_NO_FLUSH;
+            do {
+                strm->next_out = out_.data();
+                strm->avail_out = static_cast<uInt>(out_.size());
+                ret = deflate(strm, mode);
+                if (ret == Z_STREAM_ERROR) {
+                    throw std::runtime_error(std::string("zlib error during deflate: ") + zError(ret));
+                }
+                emit(out_.data(), out_.size() - strm->avail_out);
+            } while (strm->avail_out == 0);
+            pos += piece;
+        } while (pos < size);
+    }
+
+    void closeFrame() {
+        deflateChunk(nullptr, 0, Z_FINISH);
+        frame_.reset();
+        for (size_t i = frame_first_; i < entries_.size(); ++i) {
+            entries_[i].frame_size = written_ - frame_start_;
+        }
+    }
+};
+
+// Splits an inflated stream-layout archive back into member data, checking
+// each header against what is left of the stream
+class MemberDataSink : public ByteSink {
+public:
+    explicit MemberDataSink(ByteSink& inner) : inner_(inner) {}
+
+    void write(const uint8_t* data, size_t size) override {
+        while (size > 0) {
+            if (data_remaining_ > 0) {
+                size_t take = static_cast<size_t>(std::min<uint64_t>(size, data_remaining_));
+                inner_.write(data, take);
+                data_remaining_ -= take;
+                payload_bytes_ += take;
+                data += take;
+                size -= take;
+                continue;
+            }
+            size_t want = headerWant();
+            size_t take = std::min(size, want - header_.size());
+            header_.insert(header_.end(), data, data + take);
+            data += take;
+            size -= take;
+            if (header_.size() == want) {
+                advanceHeader();
+            }
+        }
+    }
+
+    void flush() override { inner_.flush(); }
+    uint64_t payloadBytes() const { return payload_bytes_; }
+
+    // Throws unless the stream ended on a member boundary
+    void finish() const {
+        if (data_remaining_ > 0 || !header_.empty() || stage_ != Stage::NameLength) {
+            throw std::runtime_error("Corrupt archive: truncated member");
+        }
+    }
+
+private:
+    enum class Stage { NameLength, Name, DataLength };
+
+    ByteSink& inner_;
+    Stage stage_ = Stage::NameLength;
+    std::vector<uint8_t> header_;  // Bytes of the header field being assembled
+    uint32_t name_len_ = 0;
+    uint64_t data_remaining_ = 0;
+    uint64_t payload_bytes_ = 0;
+
+    size_t headerWant() const {
+        switch (stage_) {
+            case Stage::NameLength: return sizeof(uint32_t);
+            case Stage::Name: return name_len_;
+            case Stage::DataLength: return sizeof(uint64_t);
+        }
+        return 0;
+    }
+
+    void advanceHeader() {
+        switch (stage_) {
+            case Stage::NameLength:
+                std::memcpy(&name_len_, header_.data(), sizeof(name_len_));
+                if (name_len_ > kMaxNameLength) {
+                    throw std::runtime_error("Corrupt archive: bad member name");
+                }
+                stage_ = name_len_ ? Stage::Name : Stage::DataLength;
+                break;
+            case Stage::Name:
+                stage_ = Stage::DataLength;
+                break;
+            case Stage::DataLength:
+                std::memcpy(&data_remaining_, header_.data(), sizeof(data_remaining_));
+                stage_ = Stage::NameLength;
+                break;
+        }
+        header_.clear();
+    }
+};
+
+// Forwards an indexed frame's inflated data and checks each member's CRC-32
+// as its last byte goes by; entries are those of the frame, in order
+class FrameCheckSink : public ByteSink {
+public:
+    FrameCheckSink(ByteSink& inner, const ArchiveCompressor::MemberEntry* entries, size_t count)
+        : inner_(inner), entries_(entries), count_(count) {}
+
+    void write(const uint8_t* data, size_t size) override {
+        inner_.write(data, size);
+        settle();
+        while (size > 0 && current_ < count_) {
+            const auto& entry = entries_[current_];
+            size_t take;
+            if (pos_ < entry.offset) {
+                // Bytes before the member belong to no entry; the writer leaves none
+                take = static_cast<size_t>(std::min<uint64_t>(entry.offset - pos_, size));
+            } else {
+                take = static_cast<size_t>(std::min<uint64_t>(entry.offset + entry.size - pos_, size));
+                crc_ = crc32(crc_, data, static_cast<uInt>(take));
+            }
+            pos_ += take;
+            data += take;
+            size -= take;
+            settle();
+        }
+        pos_ += size;
+    }
+
+    void finish() {
+        settle();
+        if (current_ < count_) {
+            throw std::runtime_error("Corrupt archive: truncated frame");
+        }
+    }
+
+private:
+    ByteSink& inner_;
+    const ArchiveCompressor::MemberEntry* entries_;
+    size_t count_;
+    size_t current_ = 0;
+    uint64_t pos_ = 0;
+    uint32_t crc_ = 0;
+
+    // Checks and moves past every member that has ended, empty ones included
+    void settle() {
+        while (current_ < count_ && pos_ >= entries_[current_].offset + entries_[current_].size) {
+            if (crc_ != entries_[current_].crc) {
+                throw std::runtime_error("Corrupt archive: checksum mismatch in " + entries_[current_].name);
+            }
+            crc_ = 0;
+            ++current_;
+        }
+    }
+};
+
+} // namespace
+
+ArchiveSource::ArchiveSource(std::vector<std::filesystem::path> paths, ByteSink* payload)
+    : paths_(std::move(paths)), names_(ArchiveCompressor::memberNames(paths_)), payload_(payload) {}
+
+bool ArchiveSource::openNext() {
+    if (next_ >= paths_.size()) {
+        return false;
+    }
+    const std::filesystem::path& path = paths_[next_];
+    // The header records the length before the data, so members must be
+    // regular files whose size is known up front
+    member_remaining_ = std::filesystem::file_size(path);
+    member_ = std::make_unique<FileSource>(path);
+    member_name_ = names_[next_++];
+
+    uint32_t name_len = member_name_.length();
+    uint64_t data_len = member_remaining_;
+    header_.resize(sizeof(name_len) + name_len + sizeof(data_len));
+    std::memcpy(header_.data(), &name_len, sizeof(name_len));
+    std::memcpy(header_.data() + sizeof(name_len), member_name_.data(), name_len);
+    std::memcpy(header_.data() + sizeof(name_len) + name_len, &data_len, sizeof(data_len));
+    header_pos_ = 0;
+    return true;
+}
+
+size_t ArchiveSource::read(uint8_t* buffer, size_t capacity) {
+    size_t filled = 0;
+    while (filled < capacity) {
+        if (header_pos_ < header_.size()) {
+            size_t take = std::min(capacity - filled, header_.size() - header_pos_);
+            std::memcpy(buffer + filled, header_.data() + header_pos_, take);
+            header_pos_ += take;
+            filled += take;
+        } else if (member_remaining_ > 0) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(capacity - filled, member_remaining_));
+            size_t got = member_->read(buffer + filled, want);
+            if (got == 0) {
+                throw std::runtime_error("Archive member shrank while being read: " + member_name_);
+            }
+            if (payload_) {
+                payload_->write(buffer + filled, got);
+            }
+            member_remaining_ -= got;
+            payload_bytes_ += got;
+            filled += got;
+        } else {
+            // Bytes appended after the size was taken are left out, keeping
+            // the header consistent with the data that follows it
+            member_.reset();
+            if (!openNext()) {
+                break;
+            }
+        }
+    }
+    return filled;
+}
 
 void ArchiveCompressor::checkZlibError(int ret, const char* operation) {
     if (ret != Z_OK) {
@@ -10,14 +597,70 @@ void ArchiveCompressor::checkZlibError(int ret, const char* operation) {
     }
 }
 
+const ExtractedArchive::Entry* ExtractedArchive::find(std::string_view name) const {
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), name,
+                               [](const Entry& entry, std::string_view key) { return entry.name < key; });
+    return it != entries_.end() && it->name == name ? &*it : nullptr;
+}
+
+ByteView ExtractedArchive::member(std::string_view name) const {
+    const Entry* entry = find(name);
+    if (!entry) {
+        throw std::out_of_range("No such archive member: " + std::string(name));
+    }
+    return data(*entry);
+}
+
+size_t ExtractedArchive::memoryUsage() const {
+    return buffer_.capacity() + names_.capacity() + entries_.capacity() * sizeof(Entry);
+}
+
+void ExtractedArchive::sortIndex() {
+    // Stable, so among equal names the last in archive order stays last
+    std::stable_sort(entries_.begin(), entries_.end(),
+                     [](const Entry& a, const Entry& b) { return a.name < b.name; });
+    auto last_of_each = [this](size_t i) { return i + 1 == entries_.size() || entries_[i + 1].name != entries_[i].name; };
+    size_t kept = 0;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (last_of_each(i)) {
+            entries_[kept++] = entries_[i];
+        }
+    }
+    entries_.resize(kept);
+}
+
+std::vector<std::string> ArchiveCompressor::memberNames(const std::vector<std::filesystem::path>& files) {
+    std::vector<std::string> names;
+    names.reserve(files.size());
+    std::unordered_set<std::string> taken;
+    for (const auto& path : files) {
+        std::string name = path.filename().string();
+        for (unsigned copy = 2; !taken.insert(name).second; ++copy) {
+            name = path.stem().string() + " (" + std::to_string(copy) + ")" + path.extension().string();
+        }
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
 Compressor::CompressionResult ArchiveCompressor::compress(
     const std::vector<std::pair<std::string, std::vector<uint8_t>>>& files, int level) {
+    if (options_.layout == Layout::Indexed) {
+        return compressIndexed(files, level);
+    }
     
     CompressionResult result;
     auto start_time = std::chrono::high_resolution_clock::now();
     
+    // Size the staging buffer once instead of growing it member by member
+    size_t archive_size = 0;
+    for (const auto& [filename, data] : files) {
+        archive_size += sizeof(uint32_t) + filename.length() + sizeof(uint64_t) + data.size();
+    }
+    
     // Create a tar-like header for each file
     std::vector<uint8_t> archive_data;
+    archive_data.reserve(archive_size);
     size_t total_original_size = 0;
     
     for (const auto& [filename, data] : files) {
@@ -44,107 +687,485 @@ Compressor::CompressionResult ArchiveCompressor::compress(
         archive_data.insert(archive_data.end(), data.begin(), data.end());
     }
     
-    // Compress the archive using zlib
-    z_stream strm;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    
-    int ret = deflateInit2(&strm, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
-    checkZlibError(ret, "deflateInit2");
-    
-    strm.avail_in = archive_data.size();
-    strm.next_in = archive_data.data();
-    
-    size_t max_output_size = deflateBound(&strm, archive_data.size());
-    std::vector<uint8_t> compressed_data(max_output_size);
-    
-    strm.avail_out = max_output_size;
-    strm.next_out = compressed_data.data();
-    
-    ret = deflate(&strm, Z_FINISH);
-    if (ret != Z_STREAM_END) {
-        deflateEnd(&strm);
-        checkZlibError(ret, "deflate");
-    }
-    
-    compressed_data.resize(max_output_size - strm.avail_out);
-    deflateEnd(&strm);
+    // Compress the archive as one gzip stream into a reusable scratch buffer
+    CallStats compression;
+    compression.buffer_memory.allocate(archive_data.capacity());
+    MutableByteView output = ScratchArena::local().buffer(ScratchArena::Compressed,
+                                                          gzip_.compressBound(archive_data.size(), level));
+    compression.buffer_memory.allocate(output.size());
+    ByteView compressed_data = output.subview(0, gzip_.deflateInto(archive_data, output, level, &compression));
     
     auto end_time = std::chrono::high_resolution_clock::now();
-    result.compression_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+    result.compression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
     
     // Measure decompression time
+    CallStats decompression;
     start_time = std::chrono::high_resolution_clock::now();
-    auto decompressed = decompressArchive(compressed_data);
+    auto decompressed = extract(compressed_data, &decompression);
     end_time = std::chrono::high_resolution_clock::now();
-    result.decompression_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+    result.decompression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    recordStats(result, compression, decompression);
+    result.member_extraction_time = timeMemberExtraction(compressed_data, files);
     
     // Calculate compression ratio
-    result.compression_ratio = static_cast<double>(compressed_data.size()) / total_original_size;
+    result.compressed_size = compressed_data.size();
+    result.compression_ratio = total_original_size ? static_cast<double>(compressed_data.size()) / total_original_size : 0.0;
     
     return result;
 }
 
-std::map<std::string, std::vector<uint8_t>> ArchiveCompressor::decompressArchive(
-    const std::vector<uint8_t>& compressed_data) {
-    
-    // First decompress the data
-    z_stream strm;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    
-    int ret = inflateInit2(&strm, 15 + 16);
-    checkZlibError(ret, "inflateInit2");
-    
-    strm.avail_in = compressed_data.size();
-    strm.next_in = const_cast<Bytef*>(compressed_data.data());
-    
-    std::vector<uint8_t> decompressed_data;
-    uint8_t buffer[4096];
-    
-    do {
-        strm.avail_out = sizeof(buffer);
-        strm.next_out = buffer;
-        
-        ret = inflate(&strm, Z_NO_FLUSH);
-        if (ret != Z_STREAM_END && ret != Z_OK) {
-            inflateEnd(&strm);
-            checkZlibError(ret, "inflate");
+Compressor::CompressionResult ArchiveCompressor::compressIndexed(
+    const std::vector<std::pair<std::string, std::vector<uint8_t>>>& files, int level) {
+    CompressionResult result;
+    CallStats compression;
+    MemorySink sink;
+    size_t total_original_size = 0;
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    // Frames are planned up front so they can be deflated independently
+    std::vector<std::pair<size_t, size_t>> frames;
+    uint64_t frame_data = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint64_t size = files[i].second.size();
+        total_original_size += size;
+        if (frames.empty() || closesFrame(frame_data, size, options_.frame_size)) {
+            frames.emplace_back(i, i);
+            frame_data = 0;
         }
-        
-        size_t bytes_decompressed = sizeof(buffer) - strm.avail_out;
-        decompressed_data.insert(decompressed_data.end(), buffer, buffer + bytes_decompressed);
-    } while (ret != Z_STREAM_END);
-    
-    inflateEnd(&strm);
-    
-    // Now extract the files from the decompressed data
+        frames.back().second = i + 1;
+        frame_data += size;
+    }
+
+    std::vector<std::future<CompressedFrame>> pending;
+    if (frame_pool_) {
+        pending.reserve(frames.size());
+        for (const auto& [first, last] : frames) {
+            pending.push_back(frame_pool_->submit([&files, &compression, first = first, last = last, level]() {
+                return deflateFrame(files, first, last, level, &compression);
+            }));
+        }
+        // Workers charge compression's trackers, so none may outlive this call
+        for (auto& frame : pending) {
+            frame.wait();
+        }
+    }
+    {
+        // Frames go out in archive order whichever finished first, so the
+        // output does not depend on the thread count
+        IndexedWriter writer(sink, level, options_.frame_size, compression);
+        for (size_t i = 0; i < frames.size(); ++i) {
+            CompressedFrame frame = frame_pool_ ? pending[i].get()
+                                                : deflateFrame(files, frames[i].first, frames[i].second, level,
+                                                               &compression);
+            compression.setup_time += frame.setup_time;
+            writer.addFrame(frame);
+        }
+        writer.finish();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.compression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    compression.buffer_memory.allocate(sink.data().capacity());
+    ByteView compressed_data = sink.data();
+
+    CallStats decompression;
+    start_time = std::chrono::high_resolution_clock::now();
+    auto decompressed = extract(compressed_data, &decompression);
+    end_time = std::chrono::high_resolution_clock::now();
+    result.decompression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    recordStats(result, compression, decompression);
+    result.member_extraction_time = timeMemberExtraction(compressed_data, files);
+
+    result.compressed_size = compressed_data.size();
+    result.compression_ratio = total_original_size ? static_cast<double>(compressed_data.size()) / total_original_size : 0.0;
+
+    // Untimed single-stream run so the cost of independent frames is visible
+    if (options_.compare_single_stream) {
+        result.reference_ratio = total_original_size ? static_cast<double>(singleStreamSize(files, level)) / total_original_size : 0.0;
+    }
+    return result;
+}
+
+std::chrono::nanoseconds ArchiveCompressor::timeMemberExtraction(
+    ByteView compressed_data, const std::vector<std::pair<std::string, std::vector<uint8_t>>>& files) {
+    if (files.empty()) {
+        return std::chrono::nanoseconds(0);
+    }
+    // Every stream-layout extraction inflates the whole archive, so one is enough
+    size_t samples = isIndexed(compressed_data) ? std::min(files.size(), kLatencySamples) : 1;
+    std::vector<std::chrono::nanoseconds> times;
+    for (size_t i = 0; i < samples; ++i) {
+        const std::string& name = files[(2 * i + 1) * files.size() / (2 * samples)].first;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        auto member = extractMember(compressed_data, name);
+        auto end_time = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time));
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+Compressor::StreamResult ArchiveCompressor::compressStream(ByteSource& source, ByteSink& sink, int level) {
+    return gzip_.compressStream(source, sink, level);
+}
+
+Compressor::StreamResult ArchiveCompressor::decompressStream(ByteSource& source, ByteSink& sink) {
+    return gzip_.decompressStream(source, sink);
+}
+
+ExtractedArchive ArchiveCompressor::extractArchive(ByteView compressed_data) {
+    return extract(compressed_data, nullptr);
+}
+
+std::map<std::string, std::vector<uint8_t>> ArchiveCompressor::decompressArchive(
+    ByteView compressed_data) {
+    ExtractedArchive archive = extract(compressed_data, nullptr);
     std::map<std::string, std::vector<uint8_t>> files;
+    for (const auto& entry : archive.entries()) {
+        ByteView data = archive.data(entry);
+        // The index is sorted, so every insert goes at the end
+        files.emplace_hint(files.end(), std::string(entry.name), std::vector<uint8_t>(data.begin(), data.end()));
+    }
+    return files;
+}
+
+ExtractedArchive ArchiveCompressor::extract(ByteView compressed_data, CallStats* stats) {
+    if (isIndexed(compressed_data)) {
+        return extractIndexed(compressed_data, stats);
+    }
+
+    // The gzip trailer gives the exact size up front
+    ExtractedArchive archive;
+    archive.buffer_ = gzip_.inflateToVector(compressed_data, stats);
+
+    // Index the members in place; lengths are checked against what is left
+    ByteView data(archive.buffer_);
     size_t pos = 0;
-    
-    while (pos < decompressed_data.size()) {
-        // Read filename length
-        uint32_t name_len;
-        std::memcpy(&name_len, &decompressed_data[pos], sizeof(name_len));
-        pos += sizeof(name_len);
-        
-        // Read filename
-        std::string filename(reinterpret_cast<char*>(&decompressed_data[pos]), name_len);
+    while (pos < data.size()) {
+        uint32_t name_len = get<uint32_t>(data, pos);
+        if (name_len > data.size() - pos) {
+            throw std::runtime_error("Corrupt archive: member name runs past the end");
+        }
+        std::string_view name(reinterpret_cast<const char*>(data.data() + pos), name_len);
         pos += name_len;
-        
-        // Read data length
-        uint64_t data_len;
-        std::memcpy(&data_len, &decompressed_data[pos], sizeof(data_len));
-        pos += sizeof(data_len);
-        
-        // Read file data
-        std::vector<uint8_t> file_data(&decompressed_data[pos], &decompressed_data[pos] + data_len);
+        uint64_t data_len = get<uint64_t>(data, pos);
+        if (data_len > data.size() - pos) {
+            throw std::runtime_error("Corrupt archive: member data runs past the end");
+        }
+        archive.entries_.push_back({name, pos, data_len});
         pos += data_len;
-        
-        files[filename] = std::move(file_data);
     }
-    
-    return files;
-} 
\ No newline at end of file
+    archive.sortIndex();
+    if (stats) {
+        stats->buffer_memory.allocate(archive.entries_.capacity() * sizeof(ExtractedArchive::Entry));
+    }
+    return archive;
+}
+
+ExtractedArchive ArchiveCompressor::extractIndexed(ByteView compressed_data, CallStats* stats) {
+    auto entries = readDirectory(compressed_data);
+    auto frames = groupFrames(entries);
+
+    // Frames are inflated back to back into one buffer
+    ExtractedArchive archive;
+    std::vector<uint64_t> frame_base(frames.size());
+    uint64_t total_size = 0;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        frame_base[f] = total_size;
+        total_size += frameDataSize(entries, frames[f].first);
+    }
+    archive.buffer_.resize(total_size);
+
+    // Runs on a pool worker in parallel mode; each frame has its own slice
+    // of the buffer and the trackers are atomic
+    auto inflate_frame = [&](size_t f) {
+        auto [first, last] = frames[f];
+        MutableByteView output(archive.buffer_.data() + frame_base[f], frameDataSize(entries, first));
+        auto setup_time = inflatePrefix(compressed_data.subview(entries[first].frame_offset, entries[first].frame_size),
+                                        output, stats ? &stats->codec_memory : nullptr);
+        for (size_t i = first; i < last; ++i) {
+            checkMemberCrc(entries[i], output.data() + entries[i].offset);
+        }
+        return setup_time;
+    };
+
+    std::vector<std::future<std::chrono::nanoseconds>> pending;
+    if (frame_pool_) {
+        pending.reserve(frames.size());
+        for (size_t f = 0; f < frames.size(); ++f) {
+            pending.push_back(frame_pool_->submit([&inflate_frame, f]() { return inflate_frame(f); }));
+        }
+        // Workers write into archive, so none may outlive this call
+        for (auto& frame : pending) {
+            frame.wait();
+        }
+    }
+    std::chrono::nanoseconds setup_time{0};
+    for (size_t f = 0; f < frames.size(); ++f) {
+        setup_time += frame_pool_ ? pending[f].get() : inflate_frame(f);
+    }
+
+    // Names are packed into one block so the index can point at them
+    size_t names_size = 0;
+    for (const auto& entry : entries) {
+        names_size += entry.name.size();
+    }
+    archive.names_.resize(names_size);
+    archive.entries_.reserve(entries.size());
+    size_t name_pos = 0;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        for (size_t i = frames[f].first; i < frames[f].second; ++i) {
+            const MemberEntry& entry = entries[i];
+            std::copy(entry.name.begin(), entry.name.end(), archive.names_.begin() + name_pos);
+            archive.entries_.push_back({std::string_view(archive.names_.data() + name_pos, entry.name.size()),
+                                        frame_base[f] + entry.offset, entry.size});
+            name_pos += entry.name.size();
+        }
+    }
+    archive.sortIndex();
+    if (stats) {
+        stats->setup_time += setup_time;
+        stats->buffer_memory.allocate(archive.memoryUsage());
+    }
+    return archive;
+}
+
+std::vector<uint8_t> ArchiveCompressor::extractMember(ByteView compressed_data, const std::string& name) {
+    if (!isIndexed(compressed_data)) {
+        ExtractedArchive archive = extract(compressed_data, nullptr);
+        ByteView member = archive.member(name);
+        return std::vector<uint8_t>(member.begin(), member.end());
+    }
+
+    auto entries = readDirectory(compressed_data);
+    const MemberEntry* entry = findLast(entries, name);
+    // Members are not known to start at 0, so inflate through the member's end
+    std::vector<uint8_t> prefix(entry->offset + entry->size);
+    inflatePrefix(compressed_data.subview(entry->frame_offset, entry->frame_size), prefix);
+    checkMemberCrc(*entry, prefix.data() + entry->offset);
+    if (entry->offset == 0) {
+        return prefix;
+    }
+    return std::vector<uint8_t>(prefix.begin() + entry->offset, prefix.end());
+}
+
+std::vector<uint8_t> ArchiveCompressor::extractMember(const std::filesystem::path& archive_path,
+                                                      const std::string& name) {
+    auto entries = readDirectory(archive_path);
+    const MemberEntry* entry = findLast(entries, name);
+    std::vector<uint8_t> frame(entry->frame_size);
+    std::ifstream file(archive_path, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(entry->frame_offset));
+    if (!file.read(reinterpret_cast<char*>(frame.data()), static_cast<std::streamsize>(frame.size()))) {
+        throw std::runtime_error("Failed to read archive frame: " + archive_path.string());
+    }
+    std::vector<uint8_t> prefix(entry->offset + entry->size);
+    inflatePrefix(frame, prefix);
+    checkMemberCrc(*entry, prefix.data() + entry->offset);
+    if (entry->offset == 0) {
+        return prefix;
+    }
+    return std::vector<uint8_t>(prefix.begin() + entry->offset, prefix.end());
+}
+
+bool ArchiveCompressor::isIndexed(ByteView compressed_data) {
+    return compressed_data.size() >= kIndexHeaderSize + kIndexTrailerSize &&
+           std::memcmp(compressed_data.data(), kIndexMagic, sizeof(kIndexMagic)) == 0;
+}
+
+std::vector<ArchiveCompressor::MemberEntry> ArchiveCompressor::readDirectory(ByteView compressed_data) {
+    if (!isIndexed(compressed_data)) {
+        throw std::runtime_error("Not an indexed archive");
+    }
+    size_t pos = sizeof(kIndexMagic);
+    if (get<uint32_t>(compressed_data, pos) != kIndexVersion) {
+        throw std::runtime_error("Unsupported indexed archive version");
+    }
+    size_t trailer_offset = compressed_data.size() - kIndexTrailerSize;
+    Trailer trailer = parseTrailer(compressed_data.subview(trailer_offset, kIndexTrailerSize));
+    if (trailer.directory_offset < kIndexHeaderSize || trailer.directory_offset > trailer_offset) {
+        throw std::runtime_error("Corrupt archive: bad directory offset");
+    }
+    return parseDirectory(compressed_data.subview(trailer.directory_offset, trailer_offset - trailer.directory_offset),
+                          trailer);
+}
+
+std::vector<ArchiveCompressor::MemberEntry> ArchiveCompressor::readDirectory(
+    const std::filesystem::path& archive_path) {
+    std::ifstream file(archive_path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + archive_path.string());
+    }
+    uint64_t file_size = std::filesystem::file_size(archive_path);
+    uint8_t header[kIndexHeaderSize];
+    uint8_t trailer_bytes[kIndexTrailerSize];
+    if (file_size < kIndexHeaderSize + kIndexTrailerSize ||
+        !file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        std::memcmp(header, kIndexMagic, sizeof(kIndexMagic)) != 0) {
+        throw std::runtime_error("Not an indexed archive: " + archive_path.string());
+    }
+    uint32_t version;
+    std::memcpy(&version, header + sizeof(kIndexMagic), sizeof(version));
+    if (version != kIndexVersion) {
+        throw std::runtime_error("Unsupported indexed archive version: " + archive_path.string());
+    }
+    uint64_t trailer_offset = file_size - kIndexTrailerSize;
+    file.seekg(static_cast<std::streamoff>(trailer_offset));
+    if (!file.read(reinterpret_cast<char*>(trailer_bytes), sizeof(trailer_bytes))) {
+        throw std::runtime_error("Failed to read archive trailer: " + archive_path.string());
+    }
+    Trailer trailer = parseTrailer(ByteView(trailer_bytes, sizeof(trailer_bytes)));
+    if (trailer.directory_offset < kIndexHeaderSize || trailer.directory_offset > trailer_offset) {
+        throw std::runtime_error("Corrupt archive: bad directory offset");
+    }
+    std::vector<uint8_t> directory(trailer_offset - trailer.directory_offset);
+    file.seekg(static_cast<std::streamoff>(trailer.directory_offset));
+    if (!file.read(reinterpret_cast<char*>(directory.data()), static_cast<std::streamsize>(directory.size()))) {
+        throw std::runtime_error("Failed to read archive directory: " + archive_path.string());
+    }
+    return parseDirectory(directory, trailer);
+}
+
+std::chrono::nanoseconds ArchiveCompressor::inflatePrefix(ByteView frame, MutableByteView output,
+                                                         MemoryTracker* codec_memory) {
+    auto strm = ZlibContextPool::local().acquireInflate();
+    if (codec_memory) {
+        strm.attachTracker(codec_memory);
+    }
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    while (out_pos < output.size()) {
+        uInt in_piece = static_cast<uInt>(std::min(frame.size() - in_pos, kMaxPiece));
+        uInt out_piece = static_cast<uInt>(std::min(output.size() - out_pos, kMaxPiece));
+        strm->next_in = const_cast<Bytef*>(frame.data() + in_pos);
+        strm->avail_in = in_piece;
+        strm->next_out = output.data() + out_pos;
+        strm->avail_out = out_piece;
+        int ret = inflate(strm.get(), Z_NO_FLUSH);
+        in_pos += in_piece - strm->avail_in;
+        out_pos += out_piece - strm->avail_out;
+        if (ret == Z_STREAM_END) {
+            break;
+        }
+        if (ret == Z_BUF_ERROR && in_pos == frame.size()) {
+            throw std::runtime_error("Corrupt archive: truncated frame");
+        }
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            checkZlibError(ret, "inflate");
+        }
+    }
+    if (out_pos < output.size()) {
+        throw std::runtime_error("Corrupt archive: frame shorter than its members");
+    }
+    return strm.setupTime();
+}
+
+Compressor::StreamResult ArchiveCompressor::compressFiles(
+    const std::vector<std::filesystem::path>& files, ByteSink& sink, int level, ByteSink* payload) {
+    if (options_.layout == Layout::Stream) {
+        ArchiveSource source(files, payload);
+        return compressStream(source, sink, level);
+    }
+
+    CallStats stats;
+    StreamResult result;
+    std::vector<uint8_t> chunk(kStreamChunkSize);
+    stats.buffer_memory.allocate(chunk.size());
+    IndexedWriter writer(sink, level, options_.frame_size, stats);
+    std::vector<std::string> names = memberNames(files);
+    for (size_t i = 0; i < files.size(); ++i) {
+        const auto& path = files[i];
+        uint64_t remaining = std::filesystem::file_size(path);
+        FileSource source(path);
+        const std::string& name = names[i];
+        writer.beginMember(name, remaining);
+        while (remaining > 0) {
+            size_t got = source.read(chunk.data(), static_cast<size_t>(std::min<uint64_t>(chunk.size(), remaining)));
+            if (got == 0) {
+                throw std::runtime_error("Archive member shrank while being read: " + name);
+            }
+            if (payload) {
+                payload->write(chunk.data(), got);
+            }
+            writer.write(chunk.data(), got);
+            remaining -= got;
+            result.bytes_in += got;
+        }
+        writer.endMember();
+    }
+    writer.finish();
+    result.bytes_out = writer.bytesWritten();
+    result.setup_time = stats.setup_time;
+    result.codec_memory = stats.codec_memory.peak();
+    result.buffer_memory = stats.buffer_memory.peak();
+    return result;
+}
+
+Compressor::StreamResult ArchiveCompressor::extractAll(const std::filesystem::path& archive_path, ByteSink& sink) {
+    uint8_t magic[sizeof(kIndexMagic)] = {};
+    {
+        std::ifstream file(archive_path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open file: " + archive_path.string());
+        }
+        file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    }
+
+    if (std::memcmp(magic, kIndexMagic, sizeof(magic)) != 0) {
+        FileSource source(archive_path);
+        MemberDataSink members(sink);
+        StreamResult result = gzip_.decompressStream(source, members);
+        members.finish();
+        result.bytes_out = members.payloadBytes();
+        return result;
+    }
+
+    // Frames are inflated one at a time, each from its own slice of the file
+    auto entries = readDirectory(archive_path);
+    StreamResult result;
+    for (const auto& [first, last] : groupFrames(entries)) {
+        for (size_t i = first; i < last; ++i) {
+            result.bytes_out += entries[i].size;
+        }
+        FileSource frame(archive_path, entries[first].frame_offset, entries[first].frame_size);
+        FrameCheckSink check(sink, &entries[first], last - first);
+        StreamResult frame_stats = gzip_.decompressStream(frame, check);
+        check.finish();
+        result.bytes_in += frame_stats.bytes_in;
+        result.setup_time += frame_stats.setup_time;
+        result.codec_memory = std::max(result.codec_memory, frame_stats.codec_memory);
+        result.buffer_memory = std::max(result.buffer_memory, frame_stats.buffer_memory);
+    }
+    return result;
+}
+
+std::string ArchiveCompressor::getAlgorithmLabel(int level) const {
+    std::string label = getName() + " (Level " + std::to_string(level);
+    if (options_.layout == Layout::Indexed) {
+        if (options_.frame_size == 0) {
+            label += ", indexed, frame per member";
+        } else if (options_.frame_size % (1024 * 1024) == 0) {
+            label += ", indexed " + std::to_string(options_.frame_size / (1024 * 1024)) + " MB frames";
+        } else {
+            label += ", indexed " + std::to_string(options_.frame_size / 1024) + " KB frames";
+        }
+        if (frame_pool_) {
+            label += ", " + std::to_string(frame_pool_->size()) + " threads";
+        }
+    }
+    return label + ")";
+}
+
+void ArchiveCompressor::setOptions(const Options& options) {
+    if (options.layout == Layout::Stream && options.threads != 1) {
+        throw std::invalid_argument("Parallel archive compression needs the indexed layout");
+    }
+    options_ = options;
+    unsigned threads = options_.threads ? options_.threads : ThreadPool::defaultThreadCount();
+    if (threads > 1) {
+        if (!frame_pool_ || frame_pool_->size() != threads) {
+            frame_pool_ = std::make_shared<ThreadPool>(threads);
+        }
+    } else {
+        frame_pool_.reset();
+    }
+}
\ No newline at end of file
@@ -1,33 +1,213 @@
 #pragma once
 
 #include "Compressor.h"
+#include "GzipCompressor.h"
+#include <filesystem>
 #include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
+class ThreadPool;
+
+// Produces the uncompressed archive stream (per member: 4-byte name length,
+// name, 8-byte data length, data) on demand, reading each member from disk
+// as the reader asks for bytes. Nothing beyond the current member header is
+// buffered, so memory does not grow with member count or size.
+class ArchiveSource : public ByteSource {
+public:
+    // payload, if set, sees every member's data (not the headers) as it passes
+    explicit ArchiveSource(std::vector<std::filesystem::path> paths, ByteSink* payload = nullptr);
+    size_t read(uint8_t* buffer, size_t capacity) override;
+
+    // Member data bytes read so far, excluding headers
+    uint64_t payloadBytes() const { return payload_bytes_; }
+    size_t memberCount() const { return paths_.size(); }
+
+private:
+    std::vector<std::filesystem::path> paths_;
+    std::vector<std::string> names_;      // ArchiveCompressor::memberNames(paths_)
+    ByteSink* payload_;
+    size_t next_ = 0;                     // Index of the next member to open
+    std::unique_ptr<FileSource> member_;  // Member being read, if any
+    std::string member_name_;
+    uint64_t member_remaining_ = 0;
+    std::vector<uint8_t> header_;
+    size_t header_pos_ = 0;
+    uint64_t payload_bytes_ = 0;
+
+    // Opens the next member and queues its header; false when all are done
+    bool openNext();
+};
+
+// Every member of an archive inflated into one owned buffer, with a flat
+// index of (name, offset, size) sorted by name. Member data are views into
+// the buffer, valid as long as this object; lookups are binary searches.
+// Move-only, since the index points into its own storage.
+class ExtractedArchive {
+public:
+    struct Entry {
+        std::string_view name;
+        uint64_t offset = 0;  // Into the buffer
+        uint64_t size = 0;
+    };
+
+    ExtractedArchive() = default;
+    ExtractedArchive(ExtractedArchive&&) = default;
+    ExtractedArchive& operator=(ExtractedArchive&&) = default;
+
+    // Sorted by name; a name repeated in the archive keeps its last member,
+    // as in every other lookup by name
+    const std::vector<Entry>& entries() const { return entries_; }
+    size_t size() const { return entries_.size(); }
+    // nullptr if no member has that name
+    const Entry* find(std::string_view name) const;
+    // Member data, or std::out_of_range if no member has that name
+    ByteView member(std::string_view name) const;
+    ByteView data(const Entry& entry) const { return ByteView(buffer_.data() + entry.offset, entry.size); }
+    // Bytes held by the buffer, names and index
+    size_t memoryUsage() const;
+
+private:
+    friend class ArchiveCompressor;
+
+    std::vector<uint8_t> buffer_;
+    std::vector<char> names_;  // Indexed layout; stream-layout names point into buffer_
+    std::vector<Entry> entries_;
+
+    // Sorts entries_ by name, keeping only the last of each repeated name
+    void sortIndex();
+};
+
+// Two layouts share the member framing above:
+//  - Stream: the whole archive stream is one gzip stream. Best ratio, but
+//    getting any member back means inflating everything before it.
+//  - Indexed: members are packed into frames of about Options::frame_size
+//    uncompressed bytes, each frame an independent gzip stream. A central
+//    directory of frame offsets, sizes and CRC-32s at the end lets a single
+//    member be extracted by inflating only its frame.
+// Indexed file layout, all integers little-endian:
+//   "DCAX" u32 version | frames | directory | trailer
+//   directory entry: u32 name_len, name, u64 frame_offset, u64 frame_size,
+//                    u64 offset (within the frame's data), u64 size, u32 crc
+//   trailer (24 bytes): u64 directory_offset, u64 entry_count,
+//                       u32 directory_crc, "DCAX"
 class ArchiveCompressor : public Compressor {
 public:
+    enum class Layout { Stream, Indexed };
+
+    struct Options {
+        Layout layout = Layout::Stream;
+        // Indexed: a frame is closed before a member would take it past this
+        // many uncompressed bytes; 0 gives every member its own frame
+        size_t frame_size = 1024 * 1024;
+        // Indexed: threads that deflate frames, and inflate them on full
+        // extraction, concurrently; 0 = hardware concurrency. The archive
+        // bytes do not depend on it. The streaming path stays single-threaded.
+        unsigned threads = 1;
+        // Indexed: also deflate everything as one stream (untimed) to report
+        // the ratio lost by not sharing history across frames
+        bool compare_single_stream = true;
+    };
+
+    // One member as recorded in an indexed archive's central directory
+    struct MemberEntry {
+        std::string name;
+        uint64_t frame_offset = 0;  // Position of the member's gzip frame in the archive
+        uint64_t frame_size = 0;    // Compressed size of that frame
+        uint64_t offset = 0;        // Member data's offset in the frame's uncompressed data
+        uint64_t size = 0;
+        uint32_t crc = 0;           // CRC-32 of the member data
+    };
+
     ArchiveCompressor() : Compressor("Archive+Gzip") {}
     
-    // Compress multiple files into a single archive
+    // Compress multiple files into a single archive. With the indexed layout
+    // the result also carries member_extraction_time.
     CompressionResult compress(const std::vector<std::pair<std::string, std::vector<uint8_t>>>& files, int level = 6);
     
     // Override single file compression to throw an error
-    CompressionResult compress(const std::vector<uint8_t>& data, int level = 6) override {
+    CompressionResult compress(ByteView data, int level = 6) override {
         throw std::runtime_error("ArchiveCompressor does not support single file compression");
     }
     
-    // Decompress the archive and return a map of filenames to their contents
-    std::map<std::string, std::vector<uint8_t>> decompressArchive(const std::vector<uint8_t>& compressed_data);
+    // Inflate the archive (either layout) into one buffer indexed by name,
+    // without copying members out. Throws std::runtime_error on malformed
+    // member headers or directory entries instead of reading past the end.
+    ExtractedArchive extractArchive(ByteView compressed_data);
+    // Same, copied into a map of filenames to their contents
+    std::map<std::string, std::vector<uint8_t>> decompressArchive(ByteView compressed_data);
+
+    // One member's data, or std::out_of_range if no member has that name;
+    // the last member of a repeated name, as in extractArchive.
+    // Indexed archives inflate only the member's frame, up to the member's
+    // end, and check its CRC-32; stream archives inflate everything.
+    std::vector<uint8_t> extractMember(ByteView compressed_data, const std::string& name);
+    // Same for an archive on disk: reads the trailer and directory, then
+    // seeks to and reads just the member's frame (indexed layout only)
+    std::vector<uint8_t> extractMember(const std::filesystem::path& archive_path, const std::string& name);
+
+    // Member names for files archived in this order: each file's filename,
+    // with " (2)", " (3)", ... before the extension of later files whose
+    // name is taken, so a/x.txt and b/x.txt stay apart
+    static std::vector<std::string> memberNames(const std::vector<std::filesystem::path>& files);
+
+    // Central directory of an indexed archive, in archive order. Throws
+    // std::runtime_error if the data is not a well-formed indexed archive.
+    static std::vector<MemberEntry> readDirectory(ByteView compressed_data);
+    static std::vector<MemberEntry> readDirectory(const std::filesystem::path& archive_path);
+    static bool isIndexed(ByteView compressed_data);
     
     // Override single file decompression to throw an error
-    std::vector<uint8_t> decompress(const std::vector<uint8_t>& compressed_data) override {
+    std::vector<uint8_t> decompress(ByteView compressed_data) override {
         throw std::runtime_error("ArchiveCompressor does not support single file decompression");
     }
-    
+
+    // The streaming path compresses an archive stream (see ArchiveSource) as
+    // one gzip stream in fixed-size chunks, and inflates it back the same way
+    StreamResult compressStream(ByteSource& source, ByteSink& sink, int level = 6) override;
+    StreamResult decompressStream(ByteSource& source, ByteSink& sink) override;
+    bool supportsStreaming() const override { return true; }
+
+    // Archive the files straight from disk into sink, in the configured
+    // layout, without loading them; payload, if set, sees all member data
+    StreamResult compressFiles(const std::vector<std::filesystem::path>& files, ByteSink& sink, int level = 6,
+                               ByteSink* payload = nullptr);
+    // Inflate an archive file of either layout and write the member data,
+    // without headers, to sink in archive order; memory stays bounded
+    StreamResult extractAll(const std::filesystem::path& archive_path, ByteSink& sink);
+
     std::string getName() const override { return "Archive+Gzip"; }
     std::string getFileExtension() const override { return ".tar.gz"; }
+    std::string getAlgorithmLabel(int level) const override;
+
+    // Not thread-safe with respect to compress(); call before starting a run.
+    // Throws std::invalid_argument for threads other than 1 with the stream layout.
+    void setOptions(const Options& options);
+    const Options& getOptions() const { return options_; }
 
 private:
+    // Single-stream gzip engine for the concatenated archive
+    GzipCompressor gzip_;
+    Options options_;
+    std::shared_ptr<ThreadPool> frame_pool_;  // Set when options_.threads resolves to more than one
+    
+    // extractArchive, charging codec and buffer memory to stats if set
+    ExtractedArchive extract(ByteView compressed_data, CallStats* stats);
+    ExtractedArchive extractIndexed(ByteView compressed_data, CallStats* stats);
+    CompressionResult compressIndexed(const std::vector<std::pair<std::string, std::vector<uint8_t>>>& files,
+                                      int level);
+
+    // Median time for extractMember over up to 16 members spread across the archive
+    std::chrono::nanoseconds timeMemberExtraction(
+        ByteView compressed_data, const std::vector<std::pair<std::string, std::vector<uint8_t>>>& files);
+
+    // Inflates the start of one gzip frame until output is full; returns the
+    // context setup time
+    static std::chrono::nanoseconds inflatePrefix(ByteView frame, MutableByteView output,
+                                                  MemoryTracker* codec_memory = nullptr);
+    
     // Helper functions for zlib error handling
     static void checkZlibError(int ret, const char* operation);
-}; 
\ No newline at end of file
+};
\ No newline at end of file
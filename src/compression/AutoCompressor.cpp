@@ -0,0 +1,297 @@
+#include "AutoCompressor.h"
+#include "CompressorFactory.h"
+#include "../utils/FileHandler.h"
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+// Settings tried on every input, per codec; codecs that were not built are skipped
+const std::pair<const char*, std::vector<int>> kPlans[] = {
+    {"lz4", {1, 9}},
+    {"zstd", {1, 3, 9, 19}},
+    {"gzip", {1, 6, 9}},
+    {"xz", {0, 6}},
+};
+
+// Every setting above, cheapest first. Picks the fallback when nothing meets
+// the budget, and stands in for trial timings on inputs too small to time.
+const std::pair<const char*, int> kCostOrder[] = {
+    {"lz4", 1}, {"zstd", 1}, {"gzip", 1}, {"zstd", 3}, {"lz4", 9}, {"gzip", 6},
+    {"zstd", 9}, {"gzip", 9}, {"xz", 0}, {"zstd", 19}, {"xz", 6},
+};
+
+// Settings whose cost rank is below this are the only ones tried on small inputs
+constexpr size_t kCheapSettings = 7;
+
+// Inputs smaller than this finish a trial in microseconds, mostly codec
+// setup, so their measured throughput is noise
+constexpr size_t kMinTimedBytes = 32 * 1024;
+
+size_t costRank(const std::string& codec, int level) {
+    for (size_t i = 0; i < std::size(kCostOrder); ++i) {
+        if (codec == kCostOrder[i].first && level == kCostOrder[i].second) return i;
+    }
+    return std::size(kCostOrder);
+}
+
+// Sampled order-0 entropy above which an input is treated as compressed already
+constexpr double kCompressedEntropy = 7.9;
+
+bool isCompressedType(const std::string& type) {
+    return type == "PNG" || type == "JPEG" || type == "ZIP" || type == "GZIP" ||
+           type == "7ZIP" || type == "BZIP2" || type == "ZSTD";
+}
+
+std::atomic<uint64_t> next_generation{1};
+
+// Cheap identity check for the per-thread choice cache
+uint32_t fingerprint(ByteView data) {
+    constexpr size_t kEdge = 4096;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    size_t head = std::min(data.size(), kEdge);
+    crc = crc32(crc, data.data(), static_cast<uInt>(head));
+    if (data.size() > head) {
+        size_t tail = std::min(data.size() - head, kEdge);
+        crc = crc32(crc, data.data() + data.size() - tail, static_cast<uInt>(tail));
+    }
+    return static_cast<uint32_t>(crc);
+}
+
+std::string formatNumber(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%g", value);
+    return text;
+}
+
+} // namespace
+
+AutoCompressor::AutoCompressor() : Compressor("Auto"), generation_(next_generation++) {
+    for (const auto& [name, levels] : kPlans) {
+        auto codec = CompressorFactory::create(name);
+        if (!codec) continue;
+        for (int level : levels) {
+            settings_.push_back({codecs_.size(), level, codec->getAlgorithmLabel(level), costRank(name, level)});
+        }
+        codecs_.push_back(std::move(codec));
+    }
+    resetComparison();
+}
+
+void AutoCompressor::setOptions(const Options& options) {
+    if (options.min_throughput < 0.0 || options.max_time_ms < 0.0 || options.size_tolerance < 0.0) {
+        throw std::invalid_argument("Auto budget values must not be negative");
+    }
+    if (options.trial.blocks < 2 || options.trial.block_size == 0) {
+        throw std::invalid_argument("Auto trials need at least 2 blocks of a positive size");
+    }
+    options_ = options;
+    generation_ = next_generation++;
+}
+
+std::string AutoCompressor::getAlgorithmLabel(int) const {
+    std::string budget;
+    if (options_.min_throughput > 0.0) {
+        budget = ">= " + formatNumber(options_.min_throughput) + " MB/s";
+    }
+    if (options_.max_time_ms > 0.0) {
+        budget += (budget.empty() ? "" : ", ") + std::string("<= ") + formatNumber(options_.max_time_ms) + " ms";
+    }
+    return "Auto (" + (budget.empty() ? std::string("smallest") : budget) + ")";
+}
+
+AutoCompressor::Choice AutoCompressor::choose(ByteView data) {
+    struct Cache {
+        uint64_t generation = 0;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        uint32_t fingerprint = 0;
+        Choice choice;
+    };
+    thread_local Cache cache;
+    uint32_t print = fingerprint(data);
+    if (cache.generation == generation_ && cache.data == data.data() && cache.size == data.size() &&
+        cache.fingerprint == print) {
+        return cache.choice;
+    }
+    Choice choice = evaluate(data);
+    cache = {generation_, data.data(), data.size(), print, choice};
+    return choice;
+}
+
+AutoCompressor::Choice AutoCompressor::evaluate(ByteView data) {
+    if (settings_.empty()) {
+        throw std::runtime_error("No codecs available for automatic selection");
+    }
+    if (data.empty()) {
+        return {0, settings_[0].label + ": empty input"};
+    }
+
+    // Small inputs skip the expensive settings and are judged by cost rank:
+    // every cheap setting finishes them well inside any budget
+    bool timed = data.size() >= kMinTimedBytes;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<CompressibilityEstimate> trials(settings_.size());
+    std::vector<bool> tried(settings_.size());
+    size_t first = settings_.size();
+    for (size_t i = 0; i < settings_.size(); ++i) {
+        const Setting& setting = settings_[i];
+        if (!timed && setting.cost >= kCheapSettings) continue;
+        trials[i] = Estimator::estimate(*codecs_[setting.codec], data, setting.level, options_.trial);
+        tried[i] = true;
+        if (first == settings_.size()) first = i;
+    }
+    double trial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (first == settings_.size()) {
+        throw std::runtime_error("No codecs cheap enough for automatic selection of small inputs");
+    }
+
+    // Every trial samples the same blocks, so any histogram will do
+    double entropy = FileHandler::calculateEntropy(trials[first].histogram);
+    std::string type = FileHandler::detectFileType(data);
+    bool precompressed = entropy >= kCompressedEntropy || isCompressedType(type);
+
+    double megabytes = data.size() / (1024.0 * 1024.0);
+    auto predictedMs = [megabytes](const CompressibilityEstimate& trial) {
+        return trial.compression_throughput > 0.0 ? megabytes / trial.compression_throughput * 1000.0 : 0.0;
+    };
+    std::vector<bool> within(trials.size());
+    for (size_t i = 0; i < trials.size(); ++i) {
+        within[i] = tried[i] && (!timed ||
+                                 ((options_.min_throughput <= 0.0 ||
+                                   trials[i].compression_throughput >= options_.min_throughput) &&
+                                  (options_.max_time_ms <= 0.0 || predictedMs(trials[i]) <= options_.max_time_ms)));
+    }
+    auto faster = [&](size_t a, size_t b) {
+        if (!timed) return settings_[a].cost < settings_[b].cost;
+        return trials[a].compression_throughput > trials[b].compression_throughput;
+    };
+
+    size_t smallest = trials.size();
+    for (size_t i = 0; i < trials.size(); ++i) {
+        if (within[i] && (smallest == trials.size() || trials[i].ratio < trials[smallest].ratio)) {
+            smallest = i;
+        }
+    }
+
+    size_t chosen = first;
+    std::string reason;
+    if (smallest == trials.size()) {
+        for (size_t i = 0; i < trials.size(); ++i) {
+            if (tried[i] && settings_[i].cost < settings_[chosen].cost) chosen = i;
+        }
+        reason = "nothing meets the budget, cheapest";
+    } else if (precompressed) {
+        chosen = smallest;
+        for (size_t i = 0; i < trials.size(); ++i) {
+            if (within[i] && faster(i, chosen)) chosen = i;
+        }
+        reason = timed ? "looks compressed already, fastest within budget" : "looks compressed already, cheapest";
+    } else {
+        chosen = smallest;
+        double limit = trials[smallest].ratio * (1.0 + options_.size_tolerance);
+        for (size_t i = 0; i < trials.size(); ++i) {
+            if (within[i] && trials[i].ratio <= limit && faster(i, chosen)) chosen = i;
+        }
+        if (!timed) {
+            reason = chosen == smallest ? "small input, smallest cheap setting" : "small input, near-smallest and cheaper";
+        } else {
+            reason = chosen == smallest ? "smallest within budget" : "near-smallest and faster";
+        }
+    }
+
+    char detail[160];
+    std::snprintf(detail, sizeof(detail), " (%s, entropy %.2f; est. ratio %.3f at %.0f MB/s; trials %.1f ms)",
+                  type.c_str(), entropy, trials[chosen].ratio, trials[chosen].compression_throughput, trial_ms);
+    Choice choice{chosen, settings_[chosen].label + ": " + reason + detail};
+
+    std::lock_guard<std::mutex> lock(totals_mutex_);
+    auto add = [&](SettingTotals& totals, size_t i) {
+        totals.inputs++;
+        totals.original_bytes += data.size();
+        totals.compressed_bytes += trials[i].ratio * data.size();
+        totals.compression_ms += predictedMs(trials[i]);
+        totals.within_budget += within[i] ? 1 : 0;
+    };
+    add(auto_totals_, chosen);
+    for (size_t i = 0; i < trials.size(); ++i) {
+        if (tried[i]) add(setting_totals_[i], i);
+    }
+    return choice;
+}
+
+std::vector<AutoCompressor::SettingTotals> AutoCompressor::comparison() const {
+    std::lock_guard<std::mutex> lock(totals_mutex_);
+    std::vector<SettingTotals> totals;
+    totals.push_back(auto_totals_);
+    totals.insert(totals.end(), setting_totals_.begin(), setting_totals_.end());
+    return totals;
+}
+
+void AutoCompressor::resetComparison() {
+    std::lock_guard<std::mutex> lock(totals_mutex_);
+    auto_totals_ = SettingTotals{};
+    auto_totals_.label = "Auto";
+    setting_totals_.assign(settings_.size(), SettingTotals{});
+    for (size_t i = 0; i < settings_.size(); ++i) {
+        setting_totals_[i].label = settings_[i].label;
+    }
+}
+
+Compressor::CompressionResult AutoCompressor::compress(ByteView data, int) {
+    // Choose first: the trials and the chosen codec share the scratch buffers
+    Choice choice = choose(data);
+    const Setting& setting = settings_[choice.setting];
+    CompressionResult result = codecs_[setting.codec]->compress(data, setting.level);
+    result.compressed_size += 1;  // Codec tag
+    result.compression_ratio = data.size() ? static_cast<double>(result.compressed_size) / data.size() : 0.0;
+    result.chosen_algorithm = setting.label;
+    result.policy = choice.policy;
+    return result;
+}
+
+size_t AutoCompressor::compressBound(size_t input_size, int) const {
+    size_t bound = 0;
+    for (const Setting& setting : settings_) {
+        bound = std::max(bound, codecs_[setting.codec]->compressBound(input_size, setting.level));
+    }
+    return bound + 1;
+}
+
+size_t AutoCompressor::compressInto(ByteView data, MutableByteView output, int) {
+    if (output.size() == 0) {
+        throw std::runtime_error("Output buffer too small for auto-compressed data");
+    }
+    const Setting& setting = settings_[choose(data).setting];
+    output.data()[0] = static_cast<uint8_t>(setting.codec);
+    return 1 + codecs_[setting.codec]->compressInto(data, output.subview(1, output.size() - 1), setting.level);
+}
+
+Compressor& AutoCompressor::codecFor(ByteView compressed_data) const {
+    if (compressed_data.empty() || compressed_data[0] >= codecs_.size()) {
+        throw std::runtime_error("Missing or unknown codec tag in auto-compressed data");
+    }
+    return *codecs_[compressed_data[0]];
+}
+
+size_t AutoCompressor::decompressedSizeHint(ByteView compressed_data) const {
+    if (compressed_data.empty() || compressed_data[0] >= codecs_.size()) {
+        return 0;
+    }
+    return codecs_[compressed_data[0]]->decompressedSizeHint(compressed_data.subview(1, compressed_data.size() - 1));
+}
+
+size_t AutoCompressor::decompressInto(ByteView compressed_data, MutableByteView output) {
+    Compressor& codec = codecFor(compressed_data);
+    return codec.decompressInto(compressed_data.subview(1, compressed_data.size() - 1), output);
+}
+
+std::vector<uint8_t> AutoCompressor::decompress(ByteView compressed_data) {
+    Compressor& codec = codecFor(compressed_data);
+    return codec.decompress(compressed_data.subview(1, compressed_data.size() - 1));
+}
\ No newline at end of file
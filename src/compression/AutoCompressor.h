@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Compressor.h"
+#include "../analysis/Estimator.h"
+#include <mutex>
+
+// Picks a codec and level per input. Every candidate setting compresses a
+// small stratified sample (see Estimator), and the smallest output that fits
+// the budget wins. Inputs that look compressed already, by file type or
+// sampled entropy, go to the fastest setting within budget. When nothing
+// fits, the cheapest setting by a fixed cost order wins. Inputs under 32 KB
+// are too small to time, so they only try the cheap settings and rank them
+// by that order instead of measured speed. The output is a one-byte codec
+// tag followed by that codec's own format.
+class AutoCompressor : public Compressor {
+public:
+    struct Options {
+        double min_throughput = 100.0;  // Compression MB/s the choice must reach; 0 = no floor
+        double max_time_ms = 0.0;       // Predicted compression time per input; 0 = no limit
+        double size_tolerance = 0.005;  // A faster setting within this fraction of the smallest wins
+        EstimateOptions trial{64 * 1024, 4};
+    };
+
+    // Estimated totals of one setting over every input chosen for so far
+    struct SettingTotals {
+        std::string label;  // e.g. "Zstd (Level 3)", or "Auto" for the per-input choices
+        size_t inputs = 0;  // Lower for expensive settings, which small inputs skip
+        uint64_t original_bytes = 0;
+        double compressed_bytes = 0.0;
+        double compression_ms = 0.0;
+        size_t within_budget = 0;  // Inputs on which this setting met the budget
+    };
+
+    AutoCompressor();
+    // level is ignored; each input gets the level of its chosen setting
+    CompressionResult compress(ByteView data, int level = 1) override;
+    std::vector<uint8_t> decompress(ByteView compressed_data) override;
+    size_t compressBound(size_t input_size, int level = 1) const override;
+    size_t decompressedSizeHint(ByteView compressed_data) const override;
+    // Selection trials use the calling thread's ScratchArena, so output must
+    // not be one of its buffers
+    size_t compressInto(ByteView data, MutableByteView output, int level = 1) override;
+    size_t decompressInto(ByteView compressed_data, MutableByteView output) override;
+    std::string getName() const override { return "Auto"; }
+    std::string getFileExtension() const override { return ".auto"; }
+    std::string getAlgorithmLabel(int level) const override;
+    // Never cached: a cached row would leave its input out of comparison()
+    std::string getCacheKey(int) const override { return std::string(); }
+
+    int minLevel() const override { return 1; }
+    int maxLevel() const override { return 1; }
+    int defaultLevel() const override { return 1; }
+
+    // Not thread-safe with respect to compress(); call before starting a run.
+    // Throws std::invalid_argument for a negative budget or bad trial options.
+    void setOptions(const Options& options);
+    const Options& getOptions() const { return options_; }
+
+    // The per-input choices first, then every fixed setting, over the inputs
+    // seen since construction or the last resetComparison()
+    std::vector<SettingTotals> comparison() const;
+    void resetComparison();
+
+private:
+    struct Setting {
+        size_t codec;  // Index into codecs_, also the output tag
+        int level;
+        std::string label;
+        size_t cost;  // Rank in a fixed cheapest-first order
+    };
+    struct Choice {
+        size_t setting = 0;
+        std::string policy;
+    };
+
+    Options options_;
+    uint64_t generation_;  // Changes with the options, invalidating cached choices
+    std::vector<std::unique_ptr<Compressor>> codecs_;
+    std::vector<Setting> settings_;  // Roughly fastest first
+
+    mutable std::mutex totals_mutex_;
+    SettingTotals auto_totals_;
+    std::vector<SettingTotals> setting_totals_;
+
+    // Cached per thread for the last input, so benchmark repetitions do not
+    // repeat the trials
+    Choice choose(ByteView data);
+    Choice evaluate(ByteView data);
+    Compressor& codecFor(ByteView compressed_data) const;
+};
\ No newline at end of file
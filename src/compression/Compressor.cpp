@@ -1,8 +1,46 @@
 #include "Compressor.h"
+#include <algorithm>
+#include <stdexcept>
 #include <sys/resource.h>
 
 size_t Compressor::getCurrentMemoryUsage() {
     struct rusage usage;
     getrusage(RUSAGE_SELF, &usage);
-    return usage.ru_maxrss; // Return in bytes
-} 
\ No newline at end of file
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);  // Already bytes
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;  // Linux reports KB
+#endif
+}
+
+void Compressor::recordStats(CompressionResult& result, const CallStats& compression, const CallStats& decompression) {
+    result.compression_setup_time = compression.setup_time;
+    result.decompression_setup_time = decompression.setup_time;
+    result.compression_codec_memory = compression.codec_memory.peak();
+    result.compression_buffer_memory = compression.buffer_memory.peak();
+    result.decompression_codec_memory = decompression.codec_memory.peak();
+    result.decompression_buffer_memory = decompression.buffer_memory.peak();
+    // Peaks of the two trackers need not coincide, so their sum bounds the phase
+    result.memory_used = std::max(result.compression_codec_memory + result.compression_buffer_memory,
+                                  result.decompression_codec_memory + result.decompression_buffer_memory);
+}
+
+Compressor::StreamResult Compressor::compressStream(ByteSource&, ByteSink&, int) {
+    throw std::runtime_error(getName() + " does not support streaming compression");
+}
+
+Compressor::StreamResult Compressor::decompressStream(ByteSource&, ByteSink&) {
+    throw std::runtime_error(getName() + " does not support streaming decompression");
+}
+
+size_t Compressor::compressBound(size_t, int) const {
+    throw std::runtime_error(getName() + " does not support caller-owned buffers");
+}
+
+size_t Compressor::compressInto(ByteView, MutableByteView, int) {
+    throw std::runtime_error(getName() + " does not support caller-owned buffers");
+}
+
+size_t Compressor::decompressInto(ByteView, MutableByteView) {
+    throw std::runtime_error(getName() + " does not support caller-owned buffers");
+}
\ No newline at end of file
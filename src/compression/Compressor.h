@@ -4,25 +4,120 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include "Stream.h"
+#include "../utils/ByteView.h"
+#include "../utils/MemoryTracker.h"
 
+// Distribution of MB/s over benchmark repetitions. p95 is the throughput
+// that 95% of runs reached (95th-percentile run time), so p95 <= median.
+struct ThroughputStats {
+    unsigned samples = 0;
+    double min = 0.0;
+    double median = 0.0;
+    double mean = 0.0;
+    double p95 = 0.0;
+    double stddev = 0.0;
+};
+
+// compress()/decompress() may be called concurrently from several pool
+// workers, so implementations must not keep per-call state in members.
 class Compressor {
 public:
     struct CompressionResult {
         double compression_ratio;
-        std::chrono::microseconds compression_time;
-        std::chrono::microseconds decompression_time;
-        size_t memory_used;
+        std::chrono::nanoseconds compression_time;
+        std::chrono::nanoseconds decompression_time;
+        size_t memory_used = 0;  // Larger of the two phases' codec + buffer peaks, in bytes
+        size_t compressed_size = 0;
+        double reference_ratio = 0.0;  // Single-stream ratio when a parallel mode ran; 0 if not measured
+        // Portion of the times above spent creating or resetting codec contexts
+        std::chrono::nanoseconds compression_setup_time{0};
+        std::chrono::nanoseconds decompression_setup_time{0};
+        // Peak bytes held by the codec's own state (via its allocator hooks)
+        // and by input/output buffers, per phase
+        size_t compression_codec_memory = 0;
+        size_t compression_buffer_memory = 0;
+        size_t decompression_codec_memory = 0;
+        size_t decompression_buffer_memory = 0;
+        // Filled in by Benchmark::run; a single call leaves these empty
+        ThroughputStats compression_stats;
+        ThroughputStats decompression_stats;
+        // Set by compressors that pick a setting per input (AutoCompressor):
+        // the label of the setting used and why it was chosen
+        std::string chosen_algorithm;
+        std::string policy;
+        // Archives: median time to get a single member back; 0 if not measured
+        std::chrono::nanoseconds member_extraction_time{0};
+    };
+
+    // Byte counts, context setup time and peak memory from a streaming call
+    struct StreamResult {
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        std::chrono::nanoseconds setup_time{0};
+        size_t codec_memory = 0;
+        size_t buffer_memory = 0;
     };
 
+    // Measurements for one compression or decompression pass, filled in by
+    // implementations' internal paths when the caller asks for them
+    struct CallStats {
+        std::chrono::nanoseconds setup_time{0};
+        MemoryTracker codec_memory;
+        MemoryTracker buffer_memory;
+    };
+
+    // Input/output chunk size for the streaming path; peak memory stays a
+    // small multiple of this regardless of input size
+    static constexpr size_t kStreamChunkSize = 256 * 1024;
+
     explicit Compressor(const std::string& name) : name_(name) {}
     virtual ~Compressor() = default;
 
-    virtual CompressionResult compress(const std::vector<uint8_t>& data, int level = 6) = 0;
-    virtual std::vector<uint8_t> decompress(const std::vector<uint8_t>& compressed_data) = 0;
+    // Inputs are views so memory-mapped files can be passed without a copy;
+    // std::vector arguments convert implicitly
+    virtual CompressionResult compress(ByteView data, int level = 6) = 0;
+    virtual std::vector<uint8_t> decompress(ByteView compressed_data) = 0;
+    // Allocation-free variants working on caller-owned buffers. compressInto
+    // needs output.size() >= compressBound(); decompressInto throws if the
+    // output is too small. decompressedSizeHint returns the size recorded in
+    // the compressed data (e.g. gzip ISIZE), or 0 if unknown. The defaults throw.
+    virtual size_t compressBound(size_t input_size, int level = 6) const;
+    virtual size_t decompressedSizeHint(ByteView compressed_data) const { return 0; }
+    virtual size_t compressInto(ByteView data, MutableByteView output, int level = 6);
+    virtual size_t decompressInto(ByteView compressed_data, MutableByteView output);
+
+    // Constant-memory variants: pull input from source in chunks and push
+    // output to sink as it is produced. The default implementations throw.
+    virtual StreamResult compressStream(ByteSource& source, ByteSink& sink, int level = 6);
+    virtual StreamResult decompressStream(ByteSource& source, ByteSink& sink);
+    virtual bool supportsStreaming() const { return false; }
+
     virtual std::string getName() const { return name_; }
     virtual std::string getFileExtension() const = 0;
 
+    // Accepted compression levels, for the GUI slider and CLI validation
+    virtual int minLevel() const { return 1; }
+    virtual int maxLevel() const { return 9; }
+    virtual int defaultLevel() const { return 6; }
+
+    // Label shown in the Algorithm column, e.g. "Gzip (Level 6)"
+    virtual std::string getAlgorithmLabel(int level) const {
+        return getName() + " (Level " + std::to_string(level) + ")";
+    }
+
+    // Everything that decides this compressor's results at level, for
+    // ResultCache keys: the label, unless the label leaves something out.
+    // Empty if results depend on more than one input; they are not cached.
+    virtual std::string getCacheKey(int level) const { return getAlgorithmLabel(level); }
+
 protected:
     std::string name_;
+
+    // Copies both passes' setup time and memory peaks into result
+    static void recordStats(CompressionResult& result, const CallStats& compression, const CallStats& decompression);
+
+    // Peak resident set size of the whole process in bytes. It covers the
+    // process lifetime and every thread, so it is no per-operation measure.
     size_t getCurrentMemoryUsage();
 }; 
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "CompressorFactory.h"
+#include "GzipCompressor.h"
+#include "ArchiveCompressor.h"
+#include "AutoCompressor.h"
+#ifdef DCA_HAVE_ZSTD
+#include "ZstdCompressor.h"
+#endif
+#ifdef DCA_HAVE_LZ4
+#include "Lz4Compressor.h"
+#endif
+#ifdef DCA_HAVE_XZ
+#include "XzCompressor.h"
+#endif
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+std::string toLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+} // namespace
+
+std::vector<std::unique_ptr<Compressor>> CompressorFactory::createAll() {
+    std::vector<std::unique_ptr<Compressor>> compressors;
+    compressors.push_back(std::make_unique<GzipCompressor>());
+    compressors.push_back(std::make_unique<ArchiveCompressor>());
+#ifdef DCA_HAVE_ZSTD
+    compressors.push_back(std::make_unique<ZstdCompressor>());
+#endif
+#ifdef DCA_HAVE_LZ4
+    compressors.push_back(std::make_unique<Lz4Compressor>());
+#endif
+#ifdef DCA_HAVE_XZ
+    compressors.push_back(std::make_unique<XzCompressor>());
+#endif
+    compressors.push_back(std::make_unique<AutoCompressor>());
+    return compressors;
+}
+
+std::unique_ptr<Compressor> CompressorFactory::create(const std::string& name) {
+    std::string key = toLower(name);
+    if (key == "gzip" || key == "gz") {
+        return std::make_unique<GzipCompressor>();
+    }
+    if (key == "archive" || key == "archive+gzip" || key == "tar.gz") {
+        return std::make_unique<ArchiveCompressor>();
+    }
+#ifdef DCA_HAVE_ZSTD
+    if (key == "zstd" || key == "zst") {
+        return std::make_unique<ZstdCompressor>();
+    }
+#endif
+#ifdef DCA_HAVE_LZ4
+    if (key == "lz4" || key == "lz4hc") {
+        return std::make_unique<Lz4Compressor>();
+    }
+#endif
+#ifdef DCA_HAVE_XZ
+    if (key == "xz" || key == "lzma") {
+        return std::make_unique<XzCompressor>();
+    }
+#endif
+    if (key == "auto") {
+        return std::make_unique<AutoCompressor>();
+    }
+    return nullptr;
+}
+
+std::vector<std::string> CompressorFactory::names() {
+    std::vector<std::string> names = {"gzip", "archive"};
+#ifdef DCA_HAVE_ZSTD
+    names.push_back("zstd");
+#endif
+#ifdef DCA_HAVE_LZ4
+    names.push_back("lz4");
+#endif
+#ifdef DCA_HAVE_XZ
+    names.push_back("xz");
+#endif
+    names.push_back("auto");
+    return names;
+}
\ No newline at end of file
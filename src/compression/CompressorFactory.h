@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Compressor.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class CompressorFactory {
+public:
+    // Every available compressor, in the order shown by the GUI combo box
+    static std::vector<std::unique_ptr<Compressor>> createAll();
+
+    // Look up a compressor by display name or short alias ("gzip", "archive").
+    // Returns nullptr if the name is unknown.
+    static std::unique_ptr<Compressor> create(const std::string& name);
+
+    // Short aliases accepted by create(), for usage messages
+    static std::vector<std::string> names();
+};
\ No newline at end of file
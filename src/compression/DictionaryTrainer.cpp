@@ -0,0 +1,222 @@
+#include "DictionaryTrainer.h"
+#include "Stream.h"
+#ifdef DCA_HAVE_ZSTD
+#include <zdict.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Bytes hashed per sequence when scoring segments, and the hash table size
+constexpr size_t kDmerSize = 8;
+constexpr unsigned kHashBits = 20;
+
+// Segment length: long enough to hold a typical shared field or header,
+// short enough that a few hundred of them fit
+constexpr size_t kSegmentSize = 256;
+
+uint32_t hashDmer(const uint8_t* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return static_cast<uint32_t>((value * 0x9E3779B97F4A7C15ULL) >> (64 - kHashBits));
+}
+
+struct Segment {
+    size_t begin;
+    size_t length;
+    uint64_t score;
+};
+
+} // namespace
+
+TrainedDictionary DictionaryTrainer::trainRaw(const std::vector<ByteView>& samples, size_t max_size,
+                                              const std::function<void()>& checkpoint) {
+    auto start_time = std::chrono::steady_clock::now();
+    TrainedDictionary dictionary;
+    dictionary.method = "raw";
+    dictionary.samples = samples.size();
+
+    // One buffer of all samples; a segment never crosses from one to the next
+    std::vector<uint8_t> all;
+    std::vector<size_t> ends;
+    for (ByteView sample : samples) {
+        all.insert(all.end(), sample.begin(), sample.end());
+        ends.push_back(all.size());
+    }
+    dictionary.sample_bytes = all.size();
+
+    std::vector<uint8_t> content;
+    if (all.size() <= max_size) {
+        content = all;
+    } else {
+        // Frequency of each sequence = the number of samples containing it,
+        // so content shared across records outranks repeats within one
+        std::vector<uint32_t> frequency(size_t(1) << kHashBits, 0);
+        std::vector<uint32_t> last_sample(size_t(1) << kHashBits, UINT32_MAX);
+        size_t sample_begin = 0;
+        for (size_t s = 0; s < ends.size(); ++s) {
+            for (size_t i = sample_begin; i + kDmerSize <= ends[s]; ++i) {
+                uint32_t hash = hashDmer(all.data() + i);
+                if (last_sample[hash] != s) {
+                    last_sample[hash] = static_cast<uint32_t>(s);
+                    ++frequency[hash];
+                }
+            }
+            sample_begin = ends[s];
+        }
+
+        // COVER's epochs: split the input into as many ranges as segments
+        // fit, take the best-scoring segment of each, and zero the sequences
+        // it covers so later picks add something new
+        size_t epochs = std::max<size_t>(1, max_size / kSegmentSize);
+        size_t epoch_size = std::max<size_t>(kSegmentSize, all.size() / epochs);
+        std::vector<Segment> picked;
+        size_t picked_bytes = 0;
+        for (size_t epoch_begin = 0; epoch_begin < all.size() && picked_bytes < max_size;
+             epoch_begin += epoch_size) {
+            if (checkpoint) {
+                checkpoint();
+            }
+            size_t epoch_end = std::min(all.size(), epoch_begin + epoch_size);
+            Segment best{0, 0, 0};
+            size_t s = std::upper_bound(ends.begin(), ends.end(), epoch_begin) - ends.begin();
+            for (size_t begin = epoch_begin; begin < epoch_end && s < ends.size(); ++s) {
+                size_t end = std::min(ends[s], epoch_end);
+                size_t length = std::min(kSegmentSize, end - begin);
+                // Window sum over the sequences starting inside [first, first + length)
+                uint64_t score = 0;
+                auto dmer_score = [&](size_t i) -> uint64_t {
+                    return i + kDmerSize <= ends[s] ? frequency[hashDmer(all.data() + i)] : 0;
+                };
+                for (size_t i = begin; i < begin + length; ++i) {
+                    score += dmer_score(i);
+                }
+                for (size_t first = begin;; ++first) {
+                    if (score > best.score) {
+                        best = {first, length, score};
+                    }
+                    if (first + length >= end) {
+                        break;
+                    }
+                    score += dmer_score(first + length);
+                    score -= dmer_score(first);
+                }
+                begin = end;
+            }
+            if (best.score == 0) {
+                continue;
+            }
+            for (size_t i = best.begin; i + kDmerSize <= best.begin + best.length; ++i) {
+                frequency[hashDmer(all.data() + i)] = 0;
+            }
+            best.length = std::min(best.length, max_size - picked_bytes);
+            picked_bytes += best.length;
+            picked.push_back(best);
+        }
+
+        // Lowest scores first: matches near the end of the dictionary are
+        // closest to the data and cost the fewest distance bits
+        std::stable_sort(picked.begin(), picked.end(),
+                         [](const Segment& a, const Segment& b) { return a.score < b.score; });
+        for (const Segment& segment : picked) {
+            content.insert(content.end(), all.begin() + segment.begin, all.begin() + segment.begin + segment.length);
+        }
+    }
+
+    dictionary.data = std::make_shared<const std::vector<uint8_t>>(std::move(content));
+    dictionary.build_time = std::chrono::steady_clock::now() - start_time;
+    return dictionary;
+}
+
+TrainedDictionary DictionaryTrainer::trainZstd(const std::vector<ByteView>& samples, size_t max_size,
+                                               const std::function<void()>& checkpoint) {
+#ifdef DCA_HAVE_ZSTD
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<uint8_t> all;
+    std::vector<size_t> sizes;
+    for (ByteView sample : samples) {
+        all.insert(all.end(), sample.begin(), sample.end());
+        sizes.push_back(sample.size());
+    }
+    std::vector<uint8_t> content(max_size);
+    size_t size = ZDICT_trainFromBuffer(content.data(), content.size(), all.data(), sizes.data(),
+                                        static_cast<unsigned>(sizes.size()));
+    if (!ZDICT_isError(size)) {
+        content.resize(size);
+        TrainedDictionary dictionary;
+        dictionary.method = "zstd";
+        dictionary.samples = samples.size();
+        dictionary.sample_bytes = all.size();
+        dictionary.data = std::make_shared<const std::vector<uint8_t>>(std::move(content));
+        dictionary.build_time = std::chrono::steady_clock::now() - start_time;
+        return dictionary;
+    }
+    // Typically too few or too small samples; zstd takes raw content too.
+    // The failed attempt still counts towards the build time.
+    auto failed_time = std::chrono::steady_clock::now() - start_time;
+    TrainedDictionary dictionary = trainRaw(samples, max_size, checkpoint);
+    dictionary.build_time += std::chrono::duration_cast<std::chrono::nanoseconds>(failed_time);
+    return dictionary;
+#else
+    return trainRaw(samples, max_size, checkpoint);
+#endif
+}
+
+DictionaryTrainer::Split DictionaryTrainer::splitFiles(const std::vector<std::filesystem::path>& files,
+                                                      size_t max_samples) {
+    if (files.size() < 2) {
+        throw std::invalid_argument("A dictionary needs at least two files: one to train on, one to measure");
+    }
+    size_t samples = std::max<size_t>(1, std::min(max_samples, files.size() / 2));
+    // Evenly spread, so a directory listing sorted by name is not sampled from one end
+    Split split;
+    size_t next = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (split.training.size() < samples && i == next * files.size() / samples) {
+            split.training.push_back(files[i]);
+            ++next;
+        } else {
+            split.measured.push_back(files[i]);
+        }
+    }
+    return split;
+}
+
+TrainedDictionary DictionaryTrainer::trainFromFiles(const std::vector<std::filesystem::path>& files,
+                                                    const Options& options) {
+    // Evenly spread, so a directory listing sorted by name is not sampled from one end
+    size_t stride = std::max<size_t>(1, (files.size() + options.max_samples - 1) / std::max<size_t>(1, options.max_samples));
+    std::vector<std::vector<uint8_t>> buffers;
+    for (size_t i = 0; i < files.size() && buffers.size() < options.max_samples; i += stride) {
+        if (options.checkpoint) {
+            options.checkpoint();
+        }
+        try {
+            FileSource source(files[i]);
+            std::vector<uint8_t> buffer(options.max_sample_size);
+            size_t filled = 0;
+            while (filled < buffer.size()) {
+                size_t count = source.read(buffer.data() + filled, buffer.size() - filled);
+                if (count == 0) {
+                    break;
+                }
+                filled += count;
+            }
+            buffer.resize(filled);
+            if (!buffer.empty()) {
+                buffers.push_back(std::move(buffer));
+            }
+        } catch (const std::exception&) {
+            // The file is reported when it is analyzed
+        }
+    }
+    if (buffers.empty()) {
+        throw std::runtime_error("No readable samples to train a dictionary on");
+    }
+
+    std::vector<ByteView> samples(buffers.begin(), buffers.end());
+    return options.zstd_format ? trainZstd(samples, options.max_size, options.checkpoint)
+                               : trainRaw(samples, options.max_size, options.checkpoint);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../utils/ByteView.h"
+
+// A shared dictionary and how it was built. Codecs that take one (the
+// dictionary field of GzipCompressor::Options and ZstdCompressor::Options)
+// share the bytes, so copies of the options stay cheap.
+struct TrainedDictionary {
+    std::shared_ptr<const std::vector<uint8_t>> data;
+    std::string method;                         // "raw" (selected content) or "zstd" (ZDICT)
+    size_t samples = 0;
+    uint64_t sample_bytes = 0;
+    std::chrono::nanoseconds build_time{0};     // Reading samples not included
+
+    size_t size() const { return data ? data->size() : 0; }
+};
+
+// Builds dictionaries from samples of the data they will be used on. Small
+// records compress poorly on their own because every one starts with an
+// empty history; a dictionary of the content they share gives each record
+// that history up front.
+class DictionaryTrainer {
+public:
+    // Files to train on and the held-out rest to measure with the dictionary
+    struct Split {
+        std::vector<std::filesystem::path> training;
+        std::vector<std::filesystem::path> measured;
+    };
+
+    struct Options {
+        size_t max_size = 32 * 1024;               // Deflate only looks back 32 KB
+        size_t max_samples = 1000;                 // Files sampled, evenly spread over the list
+        size_t max_sample_size = 128 * 1024;       // Bytes read from the start of each sample file
+        bool zstd_format = false;                  // ZDICT dictionary with entropy tables, if available
+        // Called before each sample file and each selection epoch; may throw to stop
+        std::function<void()> checkpoint;
+    };
+
+    // Raw content dictionary: segments covering the most byte sequences that
+    // recur across samples (the COVER selection, in one pass per epoch),
+    // ordered so the most useful ones end up closest to the data
+    static TrainedDictionary trainRaw(const std::vector<ByteView>& samples, size_t max_size,
+                                      const std::function<void()>& checkpoint = {});
+
+    // zstd's trainer when built with zstd, falling back to trainRaw when it
+    // has too little to work with; trainRaw otherwise
+    static TrainedDictionary trainZstd(const std::vector<ByteView>& samples, size_t max_size,
+                                       const std::function<void()>& checkpoint = {});
+
+    // Up to max_samples files, evenly spread over the list and never more than
+    // half of it, for training; the rest are measured. Measuring records the
+    // dictionary was trained on would report in-sample ratios. Throws
+    // std::invalid_argument for fewer than two files.
+    static Split splitFiles(const std::vector<std::filesystem::path>& files, size_t max_samples);
+
+    // Reads samples from up to max_samples of files and trains on them.
+    // Unreadable files are skipped; throws std::runtime_error if none is left.
+    static TrainedDictionary trainFromFiles(const std::vector<std::filesystem::path>& files, const Options& options);
+};
\ No newline at end of file
@@ -1,93 +1,529 @@
 #include "GzipCompressor.h"
+#include "ZlibContextPool.h"
+#include "../utils/ContentHash.h"
+#include "../utils/ScratchArena.h"
+#include "../utils/ThreadPool.h"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <chrono>
 
-Compressor::CompressionResult GzipCompressor::compress(const std::vector<uint8_t>& data, int level) {
+namespace {
+
+// Deflate's largest window (windowBits 15); parallel blocks are never shorter
+constexpr size_t kDeflateWindow = 32 * 1024;
+
+// Largest avail_in/avail_out handed to zlib in one call (its counters are uInt)
+constexpr size_t kMaxPiece = size_t(1) << 30;
+
+// Deflate's best case is about 1032:1 (a 258-byte match in a 2-bit code)
+constexpr size_t kMaxDeflateRatio = 1032;
+
+// Block and chunk buffers whose size is charged to CallStats::buffer_memory
+using TrackedBuffer = std::vector<uint8_t, TrackingAllocator<uint8_t>>;
+
+struct CompressedBlock {
+    TrackedBuffer data;
+    uLong crc;
+    std::chrono::nanoseconds setup_time;
+};
+
+// Raw-deflate one block of a block-parallel stream. Every block but the last
+// ends with a sync flush so it is byte-aligned and has no final-block bit.
+CompressedBlock deflateBlock(const uint8_t* block, size_t length,
+                             const uint8_t* dictionary, size_t dictionary_length,
+                             int level, const GzipCompressor::Options& options, bool last,
+                             Compressor::CallStats* stats) {
+    // Runs on a pool worker, so this leases from that worker's own pool;
+    // the trackers are atomic and shared by all blocks of the call
+    auto strm = ZlibContextPool::local().acquireDeflate(level, -options.window_bits, options.mem_level,
+                                                        options.strategy);
+    if (stats) {
+        strm.attachTracker(&stats->codec_memory);
+    }
+
+    int ret;
+    if (dictionary_length > 0) {
+        ret = deflateSetDictionary(strm.get(), dictionary, static_cast<uInt>(dictionary_length));
+        if (ret != Z_OK) {
+            throw std::runtime_error(std::string("zlib error during deflateSetDictionary: ") + zError(ret));
+        }
+    }
+
+    MemoryTracker* buffer_tracker = stats ? &stats->buffer_memory : nullptr;
+    CompressedBlock result{TrackedBuffer(TrackingAllocator<uint8_t>(buffer_tracker))};
+    result.setup_time = strm.setupTime();
+    result.crc = crc32(0L, block, static_cast<uInt>(length));
+    // Sync flush adds an empty stored block on top of deflateBound
+    result.data.resize(deflateBound(strm.get(), length) + 16);
+
+    strm->avail_in = static_cast<uInt>(length);
+    strm->next_in = const_cast<Bytef*>(block);
+    strm->avail_out = static_cast<uInt>(result.data.size());
+    strm->next_out = result.data.data();
+
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    ret = deflate(strm.get(), flush);
+    if ((last && ret != Z_STREAM_END) || (!last && (ret != Z_OK || strm->avail_in != 0))) {
+        throw std::runtime_error(std::string("zlib error during deflate: ") + zError(ret));
+    }
+
+    result.data.resize(result.data.size() - strm->avail_out);
+    return result;
+}
+
+void storeLittleEndian32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+} // namespace
+
+void GzipCompressor::setOptions(const Options& options) {
+    // zlib silently turns a gzip-wrapped windowBits of 8 into 9
+    if (options.window_bits < 9 || options.window_bits > 15) {
+        throw std::invalid_argument("Gzip windowBits out of range (9-15): " + std::to_string(options.window_bits));
+    }
+    if (options.mem_level < 1 || options.mem_level > MAX_MEM_LEVEL) {
+        throw std::invalid_argument("Gzip memLevel out of range (1-" + std::to_string(MAX_MEM_LEVEL) + "): " +
+                                    std::to_string(options.mem_level));
+    }
+    if (options.strategy < Z_DEFAULT_STRATEGY || options.strategy > Z_FIXED) {
+        throw std::invalid_argument("Unknown gzip strategy: " + std::to_string(options.strategy));
+    }
+    if (options.parallel && options.dictionary) {
+        throw std::invalid_argument("Block-parallel gzip cannot use a preset dictionary");
+    }
+    options_ = options;
+    options_.block_size = std::clamp<size_t>(options_.block_size, kDeflateWindow, size_t(1) << 30);
+    if (options_.parallel) {
+        unsigned threads = options_.threads ? options_.threads : ThreadPool::defaultThreadCount();
+        if (!block_pool_ || block_pool_->size() != threads) {
+            block_pool_ = std::make_shared<ThreadPool>(threads);
+        }
+    } else {
+        block_pool_.reset();
+    }
+    dictionary_digest_ = options_.dictionary ? ContentHasher::of(*options_.dictionary).hex() : std::string();
+}
+
+std::string GzipCompressor::getAlgorithmLabel(int level) const {
+    std::string label = getName() + " (Level " + std::to_string(level);
+    if (options_.window_bits != 15) {
+        label += ", window " + std::to_string(options_.window_bits);
+    }
+    if (options_.mem_level != 8) {
+        label += ", mem " + std::to_string(options_.mem_level);
+    }
+    if (options_.strategy != Z_DEFAULT_STRATEGY) {
+        label += std::string(", ") + strategyName(options_.strategy);
+    }
+    if (options_.parallel) {
+        label += ", parallel " + std::to_string(block_pool_->size()) + "x" +
+                 std::to_string(options_.block_size / 1024) + "KB";
+    }
+    if (options_.dictionary) {
+        label += ", dict " + std::to_string((options_.dictionary->size() + 1023) / 1024) + " KB";
+    }
+    return label + ")";
+}
+
+std::string GzipCompressor::getCacheKey(int level) const {
+    std::string key = getAlgorithmLabel(level);
+    return dictionary_digest_.empty() ? key : key + " " + dictionary_digest_;
+}
+
+int GzipCompressor::deflateWindowBits() const {
+    return options_.dictionary ? options_.window_bits : options_.window_bits + 16;
+}
+
+void GzipCompressor::setDeflateDictionary(z_stream* strm) const {
+    if (options_.dictionary && !options_.dictionary->empty()) {
+        checkZlibError(deflateSetDictionary(strm, options_.dictionary->data(),
+                                            static_cast<uInt>(options_.dictionary->size())),
+                       "deflateSetDictionary");
+    }
+}
+
+void GzipCompressor::setInflateDictionary(z_stream* strm) const {
+    if (!options_.dictionary) {
+        throw std::runtime_error("Compressed data needs a preset dictionary");
+    }
+    int ret = inflateSetDictionary(strm, options_.dictionary->data(), static_cast<uInt>(options_.dictionary->size()));
+    if (ret == Z_DATA_ERROR) {
+        throw std::runtime_error("Compressed data was made with a different dictionary");
+    }
+    checkZlibError(ret, "inflateSetDictionary");
+}
+
+const char* GzipCompressor::strategyName(int strategy) {
+    switch (strategy) {
+        case Z_FILTERED: return "filtered";
+        case Z_HUFFMAN_ONLY: return "huffman";
+        case Z_RLE: return "rle";
+        case Z_FIXED: return "fixed";
+        default: return "default";
+    }
+}
+
+int GzipCompressor::parseStrategy(const std::string& name) {
+    for (int strategy : {Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED}) {
+        if (name == strategyName(strategy)) {
+            return strategy;
+        }
+    }
+    throw std::invalid_argument("Unknown gzip strategy: " + name);
+}
+
+Compressor::CompressionResult GzipCompressor::compress(ByteView data, int level) {
     Compressor::CompressionResult result;
-    auto start_time = std::chrono::high_resolution_clock::now();
+    ScratchArena& arena = ScratchArena::local();
+    MutableByteView compressed = arena.buffer(ScratchArena::Compressed, compressBound(data.size(), level));
+    MutableByteView decompressed = arena.buffer(ScratchArena::Decompressed, data.size());
     
-    // Initialize zlib stream
-    z_stream strm;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
+    // Times include context setup, which is also reported on its own. The
+    // arena buffers are charged at their requested size for the phase that
+    // writes them.
+    CallStats compression;
+    compression.buffer_memory.allocate(compressed.size());
+    auto start_time = std::chrono::high_resolution_clock::now();
+    size_t compressed_size = options_.parallel
+        ? compressParallel(data, compressed, level, &compression)
+        : deflateInto(data, compressed, level, &compression);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.compression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
     
-    // Initialize deflate with the specified compression level
-    int ret = deflateInit2(&strm, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
-    checkZlibError(ret, "deflateInit2");
+    // Measure decompression time
+    CallStats decompression;
+    decompression.buffer_memory.allocate(decompressed.size());
+    ByteView compressed_view = compressed.subview(0, compressed_size);
+    start_time = std::chrono::high_resolution_clock::now();
+    size_t decompressed_size = inflateInto(compressed_view, decompressed, nullptr, &decompression);
+    end_time = std::chrono::high_resolution_clock::now();
+    result.decompression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    recordStats(result, compression, decompression);
     
-    // Set up input and output buffers
-    strm.avail_in = data.size();
-    strm.next_in = const_cast<Bytef*>(data.data());
+    if (decompressed_size != data.size() ||
+        (data.size() > 0 && std::memcmp(decompressed.data(), data.data(), data.size()) != 0)) {
+        throw std::runtime_error("Round-trip mismatch after decompression");
+    }
     
-    // Calculate maximum output size
-    size_t max_output_size = deflateBound(&strm, data.size());
-    std::vector<uint8_t> compressed_data(max_output_size);
+    // Calculate compression ratio
+    result.compressed_size = compressed_size;
+    result.compression_ratio = data.size() ? static_cast<double>(compressed_size) / data.size() : 0.0;
     
-    // Compress the data
-    strm.avail_out = max_output_size;
-    strm.next_out = compressed_data.data();
+    // Untimed single-stream run so the cost of independent blocks is visible
+    if (options_.parallel && options_.compare_single_stream) {
+        MutableByteView reference = arena.buffer(ScratchArena::Reference, singleStreamBound(data.size()));
+        result.reference_ratio = data.size() ? static_cast<double>(deflateInto(data, reference, level)) / data.size() : 0.0;
+    }
     
-    ret = deflate(&strm, Z_FINISH);
-    if (ret != Z_STREAM_END) {
-        deflateEnd(&strm);
-        checkZlibError(ret, "deflate");
+    return result;
+}
+
+size_t GzipCompressor::compressBound(size_t input_size, int level) const {
+    if (!options_.parallel) {
+        return singleStreamBound(input_size);
     }
+    // Every block carries its own deflate overhead plus a sync-flush marker
+    size_t block_count = std::max<size_t>(1, (input_size + options_.block_size - 1) / options_.block_size);
+    return singleStreamBound(input_size) + block_count * (rawDeflateBound(options_.block_size) - options_.block_size + 16);
+}
+
+size_t GzipCompressor::rawDeflateBound(size_t input_size) const {
+    if (options_.window_bits == 15 && options_.mem_level == 8 && options_.strategy != Z_FIXED) {
+        // zlib's bound covers a 6-byte zlib wrapper
+        return ::compressBound(static_cast<uLong>(input_size)) - 6;
+    }
+    // Other parameters can leave deflate emitting fixed-Huffman blocks where
+    // stored ones would be smaller; deflateBound's conservative bound for them
+    return input_size + (input_size >> 3) + (input_size >> 8) + (input_size >> 9) + 4;
+}
+
+size_t GzipCompressor::singleStreamBound(size_t input_size) const {
+    // gzip's header and trailer take 18 bytes
+    return rawDeflateBound(input_size) + 18;
+}
+
+size_t GzipCompressor::decompressedSizeHint(ByteView compressed_data) const {
+    // ISIZE trailer: uncompressed length mod 2^32 of the last member
+    if (compressed_data.size() < 18 || compressed_data[0] != 0x1f || compressed_data[1] != 0x8b) {
+        return 0;
+    }
+    const uint8_t* trailer = compressed_data.end() - 4;
+    size_t isize = static_cast<size_t>(trailer[0]) | static_cast<size_t>(trailer[1]) << 8 |
+                   static_cast<size_t>(trailer[2]) << 16 | static_cast<size_t>(trailer[3]) << 24;
+    // The trailer is untrusted, so a claim past what the stream could hold is
+    // capped; inflateToVector grows the buffer if the output is really larger
+    return std::min(isize, compressed_data.size() * kMaxDeflateRatio);
+}
+
+size_t GzipCompressor::compressInto(ByteView data, MutableByteView output, int level) {
+    return options_.parallel ? compressParallel(data, output, level) : deflateInto(data, output, level);
+}
+
+size_t GzipCompressor::decompressInto(ByteView compressed_data, MutableByteView output) {
+    return inflateInto(compressed_data, output, nullptr);
+}
+
+std::vector<uint8_t> GzipCompressor::decompress(ByteView compressed_data) {
+    return inflateToVector(compressed_data, nullptr);
+}
+
+std::vector<uint8_t> GzipCompressor::inflateToVector(ByteView compressed_data, CallStats* stats) {
+    // Size from the trailer so the common case needs a single allocation
+    size_t hint = decompressedSizeHint(compressed_data);
+    std::vector<uint8_t> decompressed_data(hint ? hint : compressed_data.size() * 4 + 4096);
+    size_t size = inflateInto(compressed_data, decompressed_data, &decompressed_data, stats);
+    decompressed_data.resize(size);
+    if (stats) {
+        stats->buffer_memory.allocate(decompressed_data.capacity());
+    }
+    return decompressed_data;
+}
+
+size_t GzipCompressor::deflateInto(ByteView data, MutableByteView output, int level, CallStats* stats) {
+    // Reuses a reset context from this thread's pool when one is idle
+    auto strm = ZlibContextPool::local().acquireDeflate(level, deflateWindowBits(), options_.mem_level,
+                                                        options_.strategy);
+    if (stats) {
+        stats->setup_time += strm.setupTime();
+        strm.attachTracker(&stats->codec_memory);
+    }
+    // Hashing the dictionary is per-call work, so it is timed with the data
+    setDeflateDictionary(strm.get());
     
-    // Resize the output buffer to the actual compressed size
-    compressed_data.resize(max_output_size - strm.avail_out);
+    // zlib counts in uInt, so inputs over 4 GB are fed in pieces
+    int ret;
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    do {
+        uInt in_piece = static_cast<uInt>(std::min(data.size() - in_pos, kMaxPiece));
+        uInt out_piece = static_cast<uInt>(std::min(output.size() - out_pos, kMaxPiece));
+        strm->next_in = const_cast<Bytef*>(data.data() + in_pos);
+        strm->avail_in = in_piece;
+        strm->next_out = output.data() + out_pos;
+        strm->avail_out = out_piece;
+        
+        int flush = (in_pos + in_piece == data.size()) ? Z_FINISH : Z_NO_FLUSH;
+        ret = deflate(strm.get(), flush);
+        in_pos += in_piece - strm->avail_in;
+        out_pos += out_piece - strm->avail_out;
+        
+        if (ret == Z_STREAM_ERROR || (ret != Z_STREAM_END && out_pos == output.size())) {
+            throw std::runtime_error(ret == Z_STREAM_ERROR ? "zlib error during deflate: stream error"
+                                                           : "Output buffer too small for compressed data");
+        }
+    } while (ret != Z_STREAM_END);
     
-    // Clean up
-    deflateEnd(&strm);
+    return out_pos;
+}
+
+size_t GzipCompressor::inflateInto(ByteView compressed_data, MutableByteView output,
+                                   std::vector<uint8_t>* growable, CallStats* stats) {
+    auto strm = ZlibContextPool::local().acquireInflate(options_.dictionary ? 15 : 15 + 16);
+    if (stats) {
+        stats->setup_time += strm.setupTime();
+        strm.attachTracker(&stats->codec_memory);
+    }
     
-    auto end_time = std::chrono::high_resolution_clock::now();
-    result.compression_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+    int ret;
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    while (true) {
+        if (growable && out_pos == output.size()) {
+            growable->resize(std::max<size_t>(growable->size() * 2, 4096));
+            output = MutableByteView(*growable);
+        }
+        
+        uInt in_piece = static_cast<uInt>(std::min(compressed_data.size() - in_pos, kMaxPiece));
+        uInt out_piece = static_cast<uInt>(std::min(output.size() - out_pos, kMaxPiece));
+        strm->next_in = const_cast<Bytef*>(compressed_data.data() + in_pos);
+        strm->avail_in = in_piece;
+        strm->next_out = output.data() + out_pos;
+        strm->avail_out = out_piece;
+        
+        ret = inflate(strm.get(), Z_NO_FLUSH);
+        in_pos += in_piece - strm->avail_in;
+        out_pos += out_piece - strm->avail_out;
+        
+        if (ret == Z_NEED_DICT) {
+            setInflateDictionary(strm.get());
+        } else if (ret == Z_STREAM_END) {
+            // Continue into a concatenated member; ignore any other trailing bytes
+            bool next_member = compressed_data.size() - in_pos >= 2 &&
+                               compressed_data[in_pos] == 0x1f && compressed_data[in_pos + 1] == 0x8b;
+            if (!next_member) {
+                break;
+            }
+            checkZlibError(inflateReset(strm.get()), "inflateReset");
+        } else if (ret == Z_BUF_ERROR) {
+            if (out_pos == output.size() && !growable) {
+                throw std::runtime_error("Output buffer too small for decompressed data");
+            }
+            if (in_pos == compressed_data.size()) {
+                throw std::runtime_error("Truncated gzip stream");
+            }
+        } else if (ret != Z_OK) {
+            checkZlibError(ret, "inflate");
+        }
+    }
     
-    // Measure decompression time
-    start_time = std::chrono::high_resolution_clock::now();
-    auto decompressed = decompress(compressed_data);
-    end_time = std::chrono::high_resolution_clock::now();
-    result.decompression_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+    return out_pos;
+}
+
+size_t GzipCompressor::compressParallel(ByteView data, MutableByteView output, int level, CallStats* stats) {
+    const Options options = options_;
+    const size_t block_size = options.block_size;
+    const size_t window = size_t(1) << options.window_bits;
+    const size_t block_count = std::max<size_t>(1, (data.size() + block_size - 1) / block_size);
+
+    std::vector<std::future<CompressedBlock>> blocks;
+    blocks.reserve(block_count);
+    for (size_t i = 0; i < block_count; ++i) {
+        size_t offset = i * block_size;
+        size_t length = std::min(block_size, data.size() - offset);
+        size_t dictionary_length = std::min(offset, window);
+        const uint8_t* base = data.data();
+        bool last = (i + 1 == block_count);
+        blocks.push_back(block_pool_->submit([=]() {
+            return deflateBlock(base + offset, length, base + offset - dictionary_length,
+                                dictionary_length, level, options, last, stats);
+        }));
+    }
+
+    // Blocks point into data, so none may outlive this call even if one fails
+    for (auto& block : blocks) {
+        block.wait();
+    }
+
+    size_t out_pos = 0;
+    auto append = [&](const uint8_t* bytes, size_t size) {
+        if (output.size() - out_pos < size) {
+            throw std::runtime_error("Output buffer too small for compressed data");
+        }
+        std::memcpy(output.data() + out_pos, bytes, size);
+        out_pos += size;
+    };
+
+    // gzip header: magic, deflate, no flags, no mtime, no extra flags, Unix
+    static const uint8_t header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+    append(header, sizeof(header));
+    uLong crc = crc32(0L, Z_NULL, 0);
+    for (size_t i = 0; i < block_count; ++i) {
+        CompressedBlock block = blocks[i].get();
+        if (stats) {
+            stats->setup_time += block.setup_time;
+        }
+        size_t length = std::min(block_size, data.size() - i * block_size);
+        crc = crc32_combine(crc, block.crc, static_cast<z_off_t>(length));
+        append(block.data.data(), block.data.size());
+    }
+
+    uint8_t trailer[8];
+    storeLittleEndian32(trailer, static_cast<uint32_t>(crc));
+    storeLittleEndian32(trailer + 4, static_cast<uint32_t>(data.size()));
+    append(trailer, sizeof(trailer));
+    return out_pos;
+}
+
+Compressor::StreamResult GzipCompressor::compressStream(ByteSource& source, ByteSink& sink, int level) {
+    CallStats stats;
+    auto strm = ZlibContextPool::local().acquireDeflate(level, deflateWindowBits(), options_.mem_level,
+                                                        options_.strategy);
+    strm.attachTracker(&stats.codec_memory);
+    setDeflateDictionary(strm.get());
     
-    // Calculate compression ratio
-    result.compression_ratio = static_cast<double>(compressed_data.size()) / data.size();
+    TrackedBuffer in(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    TrackedBuffer out(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    StreamResult result;
     
-    // Get memory usage
-    result.memory_used = getCurrentMemoryUsage();
+    int ret;
+    int flush;
+    do {
+        size_t bytes_read = source.read(in.data(), in.size());
+        result.bytes_in += bytes_read;
+        flush = bytes_read == 0 ? Z_FINISH : Z_NO_FLUSH;
+        strm->avail_in = static_cast<uInt>(bytes_read);
+        strm->next_in = in.data();
+        
+        // Drain everything deflate produces for this chunk
+        do {
+            strm->avail_out = static_cast<uInt>(out.size());
+            strm->next_out = out.data();
+            ret = deflate(strm.get(), flush);
+            if (ret == Z_STREAM_ERROR) {
+                throw std::runtime_error(std::string("zlib error during deflate: ") + zError(ret));
+            }
+            size_t produced = out.size() - strm->avail_out;
+            sink.write(out.data(), produced);
+            result.bytes_out += produced;
+        } while (strm->avail_out == 0);
+    } while (flush != Z_FINISH);
     
+    sink.flush();
+    result.setup_time = strm.setupTime();
+    result.codec_memory = stats.codec_memory.peak();
+    result.buffer_memory = stats.buffer_memory.peak();
     return result;
 }
 
-std::vector<uint8_t> GzipCompressor::decompress(const std::vector<uint8_t>& compressed_data) {
-    z_stream strm;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    strm.avail_in = compressed_data.size();
-    strm.next_in = const_cast<Bytef*>(compressed_data.data());
-    
-    int ret = inflateInit2(&strm, 15 + 16);
-    checkZlibError(ret, "inflateInit2");
+Compressor::StreamResult GzipCompressor::decompressStream(ByteSource& source, ByteSink& sink) {
+    CallStats stats;
+    auto strm = ZlibContextPool::local().acquireInflate(options_.dictionary ? 15 : 15 + 16);
+    strm.attachTracker(&stats.codec_memory);
     
-    std::vector<uint8_t> decompressed_data;
-    uint8_t buffer[4096];
+    TrackedBuffer in(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    TrackedBuffer out(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    StreamResult result;
+    bool in_member = false;
+    bool output_full = false;
     
-    do {
-        strm.avail_out = sizeof(buffer);
-        strm.next_out = buffer;
+    int ret;
+    while (true) {
+        // A full output buffer may mean inflate still holds data, so drain before reading
+        if (strm->avail_in == 0 && !output_full) {
+            size_t bytes_read = source.read(in.data(), in.size());
+            if (bytes_read == 0) {
+                break;
+            }
+            result.bytes_in += bytes_read;
+            strm->avail_in = static_cast<uInt>(bytes_read);
+            strm->next_in = in.data();
+        }
         
-        ret = inflate(&strm, Z_NO_FLUSH);
-        if (ret != Z_STREAM_END && ret != Z_OK) {
-            inflateEnd(&strm);
-            checkZlibError(ret, "inflate");
+        in_member = true;
+        strm->avail_out = static_cast<uInt>(out.size());
+        strm->next_out = out.data();
+        ret = inflate(strm.get(), Z_NO_FLUSH);
+        if (ret == Z_NEED_DICT) {
+            setInflateDictionary(strm.get());
+            ret = Z_OK;
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            throw std::runtime_error(std::string("zlib error during inflate: ") + zError(ret));
         }
+        size_t produced = out.size() - strm->avail_out;
+        sink.write(out.data(), produced);
+        result.bytes_out += produced;
+        output_full = (strm->avail_out == 0);
         
-        size_t bytes_decompressed = sizeof(buffer) - strm.avail_out;
-        decompressed_data.insert(decompressed_data.end(), buffer, buffer + bytes_decompressed);
-    } while (ret != Z_STREAM_END);
+        // Concatenated gzip members (e.g. from pigz --independent) form one file
+        if (ret == Z_STREAM_END) {
+            in_member = false;
+            checkZlibError(inflateReset(strm.get()), "inflateReset");
+        }
+    }
+    if (in_member) {
+        throw std::runtime_error("Truncated gzip stream");
+    }
     
-    inflateEnd(&strm);
-    return decompressed_data;
+    sink.flush();
+    result.setup_time = strm.setupTime();
+    result.codec_memory = stats.codec_memory.peak();
+    result.buffer_memory = stats.buffer_memory.peak();
+    return result;
 }
 
 void GzipCompressor::checkZlibError(int ret, const char* operation) {
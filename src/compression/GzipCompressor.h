@@ -3,16 +3,86 @@
 #include "Compressor.h"
 #include <zlib.h>
 
+class ThreadPool;
+
 class GzipCompressor : public Compressor {
 public:
+    struct Options {
+        // Block-parallel (pigz-style) settings
+        bool parallel = false;
+        size_t block_size = 128 * 1024;     // Input bytes per independently deflated block
+        unsigned threads = 0;               // 0 = hardware concurrency
+        bool compare_single_stream = true;  // Also run one single-stream deflate for the ratio cost
+
+        // deflateInit2 parameters; the gzip wrapper is added to window_bits internally
+        int window_bits = 15;               // 9-15: a 2^window_bits byte LZ77 window
+        int mem_level = 8;                  // 1-9: hash table and buffer size
+        int strategy = Z_DEFAULT_STRATEGY;  // Or Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED
+
+        // Preset dictionary (see DictionaryTrainer). The gzip format cannot
+        // carry one, so with a dictionary the output is a zlib stream whose
+        // header names the dictionary by its Adler-32. Not with parallel.
+        std::shared_ptr<const std::vector<uint8_t>> dictionary;
+    };
+
     GzipCompressor() : Compressor("Gzip") {}
-    CompressionResult compress(const std::vector<uint8_t>& data, int level = 6) override;
-    std::vector<uint8_t> decompress(const std::vector<uint8_t>& compressed_data) override;
+    CompressionResult compress(ByteView data, int level = 6) override;
+    std::vector<uint8_t> decompress(ByteView compressed_data) override;
+    size_t compressBound(size_t input_size, int level = 6) const override;
+    size_t decompressedSizeHint(ByteView compressed_data) const override;
+    size_t compressInto(ByteView data, MutableByteView output, int level = 6) override;
+    size_t decompressInto(ByteView compressed_data, MutableByteView output) override;
+    StreamResult compressStream(ByteSource& source, ByteSink& sink, int level = 6) override;
+    StreamResult decompressStream(ByteSource& source, ByteSink& sink) override;
+    bool supportsStreaming() const override { return true; }
     std::string getName() const override { return "Gzip"; }
     std::string getFileExtension() const override { return ".gz"; }
+    std::string getAlgorithmLabel(int level) const override;
+    // The label plus the dictionary's digest; the label only gives its size
+    std::string getCacheKey(int level) const override;
+
+    // Not thread-safe with respect to compress(); call before starting a run.
+    // Throws std::invalid_argument for deflate parameters zlib would reject.
+    void setOptions(const Options& options);
+    const Options& getOptions() const { return options_; }
+
+    // "default", "filtered", "huffman", "rle" or "fixed"; parseStrategy
+    // throws std::invalid_argument for anything else
+    static const char* strategyName(int strategy);
+    static int parseStrategy(const std::string& name);
 
 private:
+    // Drives deflateInto/inflateInto directly to get per-pass stats
+    friend class ArchiveCompressor;
+
+    Options options_;
+    std::shared_ptr<ThreadPool> block_pool_;
+    std::string dictionary_digest_;  // Hex ContentDigest of options_.dictionary, empty if none
+
+    // Upper bounds on raw deflate output, and with the gzip wrapper, for the configured parameters
+    size_t rawDeflateBound(size_t input_size) const;
+    size_t singleStreamBound(size_t input_size) const;
+
+    // stats, if set, receives context setup time (summed over blocks in
+    // parallel mode) and zlib's allocations; output buffers are the caller's
+    size_t deflateInto(ByteView data, MutableByteView output, int level, CallStats* stats = nullptr);
+    size_t compressParallel(ByteView data, MutableByteView output, int level, CallStats* stats = nullptr);
+
+    // Inflates all gzip members; if growable is set, output is that vector
+    // and it is doubled whenever it fills up
+    size_t inflateInto(ByteView compressed_data, MutableByteView output, std::vector<uint8_t>* growable,
+                       CallStats* stats = nullptr);
+
+    // decompress() with stats; the returned vector's capacity is charged to buffer_memory
+    std::vector<uint8_t> inflateToVector(ByteView compressed_data, CallStats* stats);
+
+    // windowBits for deflateInit2: gzip-wrapped, or zlib-wrapped with a dictionary
+    int deflateWindowBits() const;
+    // Loads the dictionary into a freshly reset stream, if there is one
+    void setDeflateDictionary(z_stream* strm) const;
+    void setInflateDictionary(z_stream* strm) const;
+
     // Helper functions for zlib error handling
     static void checkZlibError(int ret, const char* operation);
     static std::string getZlibErrorMessage(int ret);
-}; 
\ No newline at end of file
+};
\ No newline at end of file
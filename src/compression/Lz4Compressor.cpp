@@ -0,0 +1,465 @@
+#include "Lz4Compressor.h"
+#include "../utils/ScratchArena.h"
+#include <lz4.h>
+#include <lz4hc.h>
+#include <lz4frame.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kBlockPrefixSize = 4;
+
+size_t checkLz4f(size_t ret, const char* operation) {
+    if (LZ4F_isError(ret)) {
+        throw std::runtime_error(std::string("LZ4 error during ") + operation + ": " + LZ4F_getErrorName(ret));
+    }
+    return ret;
+}
+
+LZ4F_blockSizeID_t blockSizeId(size_t block_size) {
+    switch (block_size) {
+        case 64 * 1024: return LZ4F_max64KB;
+        case 256 * 1024: return LZ4F_max256KB;
+        case 1024 * 1024: return LZ4F_max1MB;
+        case 4 * 1024 * 1024: return LZ4F_max4MB;
+        default: return LZ4F_default;
+    }
+}
+
+LZ4F_preferences_t framePreferences(const Lz4Compressor::Options& options, int level, size_t content_size) {
+    LZ4F_preferences_t preferences;
+    std::memset(&preferences, 0, sizeof(preferences));
+    preferences.frameInfo.blockSizeID = blockSizeId(options.block_size);
+    preferences.frameInfo.blockMode = options.independent_blocks ? LZ4F_blockIndependent : LZ4F_blockLinked;
+    preferences.frameInfo.contentChecksumFlag =
+        options.content_checksum ? LZ4F_contentChecksumEnabled : LZ4F_noContentChecksum;
+    preferences.frameInfo.contentSize = content_size;
+    // lz4frame runs the fast compressor below level 3, with acceleration 1 - level
+    preferences.compressionLevel =
+        level >= Lz4Compressor::kMinHighCompressionLevel ? level : 1 - options.acceleration;
+    // Every caller consumes all output per call, so skip lz4frame's input staging buffer
+    preferences.autoFlush = 1;
+    return preferences;
+}
+
+// The fields of a frame header (FLG and BD bytes, optional content size)
+// that decide what lz4frame allocates and how large the output will be
+struct FrameHeader {
+    size_t block_size = 0;
+    bool linked = false;
+    size_t content_size = 0;  // 0 if not recorded
+};
+
+bool parseFrameHeader(ByteView data, FrameHeader& header) {
+    if (data.size() < 7 || data[0] != 0x04 || data[1] != 0x22 || data[2] != 0x4d || data[3] != 0x18) {
+        return false;
+    }
+    uint8_t flags = data[4];
+    header.block_size = size_t(1) << (8 + 2 * ((data[5] >> 4) & 0x07));
+    header.linked = (flags & 0x20) == 0;
+    header.content_size = 0;
+    if ((flags & 0x08) && data.size() >= 14) {
+        for (int i = 7; i >= 0; --i) {
+            header.content_size = header.content_size << 8 | data[6 + i];
+        }
+    }
+    return true;
+}
+
+size_t stateSize(int level) {
+    return level >= Lz4Compressor::kMinHighCompressionLevel ? LZ4_sizeofStateHC() : LZ4_sizeofState();
+}
+
+// lz4frame exposes no allocator hooks outside its static-only API, so its
+// footprint comes from its buffer sizing rules: the match state plus, with
+// autoFlush, a 64 KB history copy for linked blocks
+size_t frameCompressionMemory(int level, bool linked) {
+    return stateSize(level) + (linked ? 64 * 1024 : 0);
+}
+
+// An input block buffer and an output block buffer, the latter with 128 KB
+// of history when blocks are linked
+size_t frameDecompressionMemory(const FrameHeader& header) {
+    return 2 * header.block_size + 4 + (header.linked ? 128 * 1024 : 0);
+}
+
+// Per-thread LZ4 contexts and block-mode states, reused across calls the way
+// ZlibContextPool reuses z_streams
+class ContextCache {
+public:
+    ~ContextCache() {
+        LZ4F_freeCompressionContext(compression_);
+        LZ4F_freeDecompressionContext(decompression_);
+    }
+
+    LZ4F_cctx* frameCompression() {
+        // LZ4F_compressBegin resets the context for every frame
+        if (!compression_) {
+            checkLz4f(LZ4F_createCompressionContext(&compression_, LZ4F_VERSION), "LZ4F_createCompressionContext");
+        }
+        return compression_;
+    }
+
+    LZ4F_dctx* frameDecompression() {
+        if (decompression_) {
+            LZ4F_resetDecompressionContext(decompression_);
+            return decompression_;
+        }
+        checkLz4f(LZ4F_createDecompressionContext(&decompression_, LZ4F_VERSION), "LZ4F_createDecompressionContext");
+        return decompression_;
+    }
+
+    // State for the *_extState block functions, which reinitialize it per call
+    void* blockState(int level) {
+        bool high = level >= Lz4Compressor::kMinHighCompressionLevel;
+        std::unique_ptr<char[]>& state = high ? high_compression_state_ : fast_state_;
+        if (!state) {
+            state.reset(new char[stateSize(level)]);
+        }
+        return state.get();
+    }
+
+    static ContextCache& local() {
+        thread_local ContextCache cache;
+        return cache;
+    }
+
+private:
+    LZ4F_cctx* compression_ = nullptr;
+    LZ4F_dctx* decompression_ = nullptr;
+    std::unique_ptr<char[]> fast_state_;
+    std::unique_ptr<char[]> high_compression_state_;
+};
+
+using TrackedBuffer = std::vector<uint8_t, TrackingAllocator<uint8_t>>;
+
+} // namespace
+
+int Lz4Compressor::maxLevel() const {
+    return LZ4HC_CLEVEL_MAX;
+}
+
+void Lz4Compressor::setOptions(const Options& options) {
+    if (blockSizeId(options.block_size) == LZ4F_default) {
+        throw std::invalid_argument("LZ4 block size must be 64, 256, 1024 or 4096 KB: " +
+                                    std::to_string(options.block_size / 1024) + " KB");
+    }
+    if (options.acceleration < 1) {
+        throw std::invalid_argument("LZ4 acceleration must be at least 1: " + std::to_string(options.acceleration));
+    }
+    options_ = options;
+}
+
+std::string Lz4Compressor::getAlgorithmLabel(int level) const {
+    bool high = level >= kMinHighCompressionLevel;
+    std::string label = getName() + (high ? " HC" : "") + " (Level " + std::to_string(level);
+    if (!high && options_.acceleration > 1) {
+        label += ", accel " + std::to_string(options_.acceleration);
+    }
+    if (options_.format == Format::Block) {
+        label += ", block";
+    } else {
+        if (options_.block_size != 64 * 1024) {
+            label += ", " + std::to_string(options_.block_size / 1024) + " KB blocks";
+        }
+        if (options_.independent_blocks) {
+            label += ", independent";
+        }
+    }
+    return label + ")";
+}
+
+Compressor::CompressionResult Lz4Compressor::compress(ByteView data, int level) {
+    Compressor::CompressionResult result;
+    ScratchArena& arena = ScratchArena::local();
+    MutableByteView compressed = arena.buffer(ScratchArena::Compressed, compressBound(data.size(), level));
+    MutableByteView decompressed = arena.buffer(ScratchArena::Decompressed, data.size());
+
+    CallStats compression;
+    compression.buffer_memory.allocate(compressed.size());
+    auto start_time = std::chrono::high_resolution_clock::now();
+    size_t compressed_size = compressWith(data, compressed, level, &compression);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.compression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+
+    CallStats decompression;
+    decompression.buffer_memory.allocate(decompressed.size());
+    ByteView compressed_view = compressed.subview(0, compressed_size);
+    start_time = std::chrono::high_resolution_clock::now();
+    size_t decompressed_size = decompressWith(compressed_view, decompressed, nullptr, &decompression);
+    end_time = std::chrono::high_resolution_clock::now();
+    result.decompression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    recordStats(result, compression, decompression);
+
+    if (decompressed_size != data.size() ||
+        (data.size() > 0 && std::memcmp(decompressed.data(), data.data(), data.size()) != 0)) {
+        throw std::runtime_error("Round-trip mismatch after decompression");
+    }
+
+    result.compressed_size = compressed_size;
+    result.compression_ratio = data.size() ? static_cast<double>(compressed_size) / data.size() : 0.0;
+    return result;
+}
+
+size_t Lz4Compressor::compressBound(size_t input_size, int level) const {
+    if (options_.format == Format::Block) {
+        // 0 past LZ4_MAX_INPUT_SIZE; compressBlock reports that case
+        return kBlockPrefixSize + LZ4_COMPRESSBOUND(input_size);
+    }
+    LZ4F_preferences_t preferences = framePreferences(options_, level, input_size);
+    return LZ4F_HEADER_SIZE_MAX + LZ4F_compressBound(input_size, &preferences);
+}
+
+size_t Lz4Compressor::decompressedSizeHint(ByteView compressed_data) const {
+    if (options_.format == Format::Block) {
+        if (compressed_data.size() < kBlockPrefixSize) {
+            return 0;
+        }
+        return static_cast<size_t>(compressed_data[0]) | static_cast<size_t>(compressed_data[1]) << 8 |
+               static_cast<size_t>(compressed_data[2]) << 16 | static_cast<size_t>(compressed_data[3]) << 24;
+    }
+    // Content size of the first frame, which compressInto always records
+    FrameHeader header;
+    return parseFrameHeader(compressed_data, header) ? header.content_size : 0;
+}
+
+size_t Lz4Compressor::compressInto(ByteView data, MutableByteView output, int level) {
+    return compressWith(data, output, level, nullptr);
+}
+
+size_t Lz4Compressor::decompressInto(ByteView compressed_data, MutableByteView output) {
+    return decompressWith(compressed_data, output, nullptr, nullptr);
+}
+
+std::vector<uint8_t> Lz4Compressor::decompress(ByteView compressed_data) {
+    size_t hint = decompressedSizeHint(compressed_data);
+    std::vector<uint8_t> decompressed_data(hint ? hint : compressed_data.size() * 4 + 4096);
+    decompressed_data.resize(decompressWith(compressed_data, decompressed_data, &decompressed_data, nullptr));
+    return decompressed_data;
+}
+
+size_t Lz4Compressor::compressWith(ByteView data, MutableByteView output, int level, CallStats* stats) {
+    return options_.format == Format::Block ? compressBlock(data, output, level, stats)
+                                            : compressFrame(data, output, level, stats);
+}
+
+size_t Lz4Compressor::decompressWith(ByteView compressed_data, MutableByteView output,
+                                     std::vector<uint8_t>* growable, CallStats* stats) {
+    // Block decoding is stateless, so there is no setup or codec memory to record
+    return options_.format == Format::Block ? decompressBlock(compressed_data, output)
+                                            : decompressFrames(compressed_data, output, growable, stats);
+}
+
+size_t Lz4Compressor::compressFrame(ByteView data, MutableByteView output, int level, CallStats* stats) {
+    LZ4F_preferences_t preferences = framePreferences(options_, level, data.size());
+
+    // compressBegin resets the context (allocating its state on first use),
+    // the counterpart of deflateReset
+    auto start_time = std::chrono::steady_clock::now();
+    LZ4F_cctx* cctx = ContextCache::local().frameCompression();
+    size_t size = checkLz4f(LZ4F_compressBegin(cctx, output.data(), output.size(), &preferences),
+                            "LZ4F_compressBegin");
+    if (stats) {
+        stats->setup_time += std::chrono::steady_clock::now() - start_time;
+    }
+
+    size += checkLz4f(LZ4F_compressUpdate(cctx, output.data() + size, output.size() - size,
+                                          data.data(), data.size(), nullptr),
+                      "compression");
+    size += checkLz4f(LZ4F_compressEnd(cctx, output.data() + size, output.size() - size, nullptr),
+                      "LZ4F_compressEnd");
+    if (stats) {
+        stats->codec_memory.allocate(frameCompressionMemory(level, !options_.independent_blocks));
+    }
+    return size;
+}
+
+size_t Lz4Compressor::decompressFrames(ByteView compressed_data, MutableByteView output,
+                                       std::vector<uint8_t>* growable, CallStats* stats) {
+    auto start_time = std::chrono::steady_clock::now();
+    LZ4F_dctx* dctx = ContextCache::local().frameDecompression();
+    if (stats) {
+        stats->setup_time += std::chrono::steady_clock::now() - start_time;
+        FrameHeader header;
+        if (parseFrameHeader(compressed_data, header)) {
+            stats->codec_memory.allocate(frameDecompressionMemory(header));
+        }
+    }
+
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    size_t expected = 1;  // LZ4F's hint for the next call; 0 once a frame is complete
+    while (in_pos < compressed_data.size() || expected != 0) {
+        if (growable && out_pos == output.size()) {
+            growable->resize(std::max<size_t>(growable->size() * 2, 4096));
+            output = MutableByteView(*growable);
+        }
+
+        size_t in_size = compressed_data.size() - in_pos;
+        size_t out_size = output.size() - out_pos;
+        // A finished frame leaves the context ready for the next concatenated one
+        expected = checkLz4f(LZ4F_decompress(dctx, output.data() + out_pos, &out_size,
+                                             compressed_data.data() + in_pos, &in_size, nullptr),
+                             "decompression");
+        in_pos += in_size;
+        out_pos += out_size;
+
+        if (in_size == 0 && out_size == 0) {
+            if (out_pos == output.size() && !growable) {
+                throw std::runtime_error("Output buffer too small for decompressed data");
+            }
+            if (in_pos == compressed_data.size()) {
+                throw std::runtime_error("Truncated LZ4 frame");
+            }
+        }
+    }
+    return out_pos;
+}
+
+size_t Lz4Compressor::compressBlock(ByteView data, MutableByteView output, int level, CallStats* stats) {
+    if (data.size() > LZ4_MAX_INPUT_SIZE) {
+        throw std::runtime_error("Input exceeds the LZ4 block format limit of " +
+                                 std::to_string(LZ4_MAX_INPUT_SIZE) + " bytes; use the frame format");
+    }
+    if (output.size() < kBlockPrefixSize) {
+        throw std::runtime_error("Output buffer too small for compressed data");
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    void* state = ContextCache::local().blockState(level);
+    if (stats) {
+        stats->setup_time += std::chrono::steady_clock::now() - start_time;
+    }
+
+    const char* source = reinterpret_cast<const char*>(data.data());
+    char* destination = reinterpret_cast<char*>(output.data() + kBlockPrefixSize);
+    int source_size = static_cast<int>(data.size());
+    int capacity = static_cast<int>(std::min<size_t>(output.size() - kBlockPrefixSize, INT_MAX));
+    int size = level >= kMinHighCompressionLevel
+        ? LZ4_compress_HC_extStateHC(state, source, destination, source_size, capacity, level)
+        : LZ4_compress_fast_extState(state, source, destination, source_size, capacity, options_.acceleration);
+    if (size <= 0 && source_size > 0) {
+        throw std::runtime_error("Output buffer too small for compressed data");
+    }
+
+    for (size_t i = 0; i < kBlockPrefixSize; ++i) {
+        output[i] = static_cast<uint8_t>(data.size() >> (8 * i));
+    }
+    if (stats) {
+        stats->codec_memory.allocate(stateSize(level));
+    }
+    return kBlockPrefixSize + static_cast<size_t>(size);
+}
+
+size_t Lz4Compressor::decompressBlock(ByteView compressed_data, MutableByteView output) {
+    if (compressed_data.size() < kBlockPrefixSize) {
+        throw std::runtime_error("Truncated LZ4 block");
+    }
+    size_t expected = decompressedSizeHint(compressed_data);
+    if (output.size() < expected) {
+        throw std::runtime_error("Output buffer too small for decompressed data");
+    }
+    int size = LZ4_decompress_safe(reinterpret_cast<const char*>(compressed_data.data() + kBlockPrefixSize),
+                                   reinterpret_cast<char*>(output.data()),
+                                   static_cast<int>(std::min<size_t>(compressed_data.size() - kBlockPrefixSize, INT_MAX)),
+                                   static_cast<int>(expected));
+    if (size < 0 || static_cast<size_t>(size) != expected) {
+        throw std::runtime_error("Corrupt LZ4 block");
+    }
+    return expected;
+}
+
+Compressor::StreamResult Lz4Compressor::compressStream(ByteSource& source, ByteSink& sink, int level) {
+    if (options_.format == Format::Block) {
+        return Compressor::compressStream(source, sink, level);
+    }
+
+    CallStats stats;
+    StreamResult result;
+    LZ4F_preferences_t preferences = framePreferences(options_, level, 0);
+    TrackedBuffer in(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    TrackedBuffer out(std::max<size_t>(LZ4F_compressBound(kStreamChunkSize, &preferences), LZ4F_HEADER_SIZE_MAX),
+                      TrackingAllocator<uint8_t>(&stats.buffer_memory));
+
+    auto start_time = std::chrono::steady_clock::now();
+    LZ4F_cctx* cctx = ContextCache::local().frameCompression();
+    size_t size = checkLz4f(LZ4F_compressBegin(cctx, out.data(), out.size(), &preferences), "LZ4F_compressBegin");
+    result.setup_time = std::chrono::steady_clock::now() - start_time;
+    sink.write(out.data(), size);
+    result.bytes_out += size;
+
+    while (size_t bytes_read = source.read(in.data(), in.size())) {
+        result.bytes_in += bytes_read;
+        size = checkLz4f(LZ4F_compressUpdate(cctx, out.data(), out.size(), in.data(), bytes_read, nullptr),
+                         "compression");
+        sink.write(out.data(), size);
+        result.bytes_out += size;
+    }
+    size = checkLz4f(LZ4F_compressEnd(cctx, out.data(), out.size(), nullptr), "LZ4F_compressEnd");
+    sink.write(out.data(), size);
+    result.bytes_out += size;
+
+    sink.flush();
+    result.codec_memory = frameCompressionMemory(level, !options_.independent_blocks);
+    result.buffer_memory = stats.buffer_memory.peak();
+    return result;
+}
+
+Compressor::StreamResult Lz4Compressor::decompressStream(ByteSource& source, ByteSink& sink) {
+    if (options_.format == Format::Block) {
+        return Compressor::decompressStream(source, sink);
+    }
+
+    CallStats stats;
+    StreamResult result;
+    auto start_time = std::chrono::steady_clock::now();
+    LZ4F_dctx* dctx = ContextCache::local().frameDecompression();
+    result.setup_time = std::chrono::steady_clock::now() - start_time;
+
+    TrackedBuffer in(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    TrackedBuffer out(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    size_t in_pos = 0;
+    size_t in_size = 0;
+    size_t pending = 0;  // Non-zero while a frame is incomplete
+    bool output_full = false;
+
+    while (true) {
+        // A full output buffer may mean the decoder still holds data, so drain before reading
+        if (in_pos == in_size && !output_full) {
+            size_t bytes_read = source.read(in.data(), in.size());
+            if (bytes_read == 0) {
+                break;
+            }
+            if (result.bytes_in == 0) {
+                FrameHeader header;
+                if (parseFrameHeader(ByteView(in.data(), bytes_read), header)) {
+                    result.codec_memory = frameDecompressionMemory(header);
+                }
+            }
+            result.bytes_in += bytes_read;
+            in_pos = 0;
+            in_size = bytes_read;
+        }
+
+        size_t consumed = in_size - in_pos;
+        size_t produced = out.size();
+        pending = checkLz4f(LZ4F_decompress(dctx, out.data(), &produced, in.data() + in_pos, &consumed, nullptr),
+                            "decompression");
+        in_pos += consumed;
+        sink.write(out.data(), produced);
+        result.bytes_out += produced;
+        output_full = (produced == out.size());
+    }
+    if (pending != 0) {
+        throw std::runtime_error("Truncated LZ4 frame");
+    }
+
+    sink.flush();
+    result.buffer_memory = stats.buffer_memory.peak();
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Compressor.h"
+
+// LZ4 backend, built when liblz4 is found (DCA_HAVE_LZ4). Levels below
+// kMinHighCompressionLevel run the fast compressor, tuned by
+// Options::acceleration; the rest are LZ4-HC levels.
+class Lz4Compressor : public Compressor {
+public:
+    enum class Format {
+        Frame,  // Standard .lz4 frame: header, checksum, streamable
+        Block   // A single raw block behind a 4-byte little-endian size prefix
+    };
+
+    struct Options {
+        Format format = Format::Frame;
+        int acceleration = 1;             // Fast levels only; higher is faster with a worse ratio
+        bool independent_blocks = false;  // Frame: blocks do not reference earlier blocks
+        size_t block_size = 64 * 1024;    // Frame: 64 KB, 256 KB, 1 MB or 4 MB
+        bool content_checksum = true;     // Frame: xxHash32 of the content
+    };
+
+    static constexpr int kMinHighCompressionLevel = 3;
+
+    Lz4Compressor() : Compressor("LZ4") {}
+    CompressionResult compress(ByteView data, int level = 1) override;
+    std::vector<uint8_t> decompress(ByteView compressed_data) override;
+    size_t compressBound(size_t input_size, int level = 1) const override;
+    size_t decompressedSizeHint(ByteView compressed_data) const override;
+    size_t compressInto(ByteView data, MutableByteView output, int level = 1) override;
+    size_t decompressInto(ByteView compressed_data, MutableByteView output) override;
+    StreamResult compressStream(ByteSource& source, ByteSink& sink, int level = 1) override;
+    StreamResult decompressStream(ByteSource& source, ByteSink& sink) override;
+    bool supportsStreaming() const override { return options_.format == Format::Frame; }
+    std::string getName() const override { return "LZ4"; }
+    std::string getFileExtension() const override { return ".lz4"; }
+    std::string getAlgorithmLabel(int level) const override;
+
+    // Levels 1 and 2 are both the fast compressor, as in the lz4 tool
+    int minLevel() const override { return 1; }
+    int maxLevel() const override;
+    int defaultLevel() const override { return 1; }
+
+    // Not thread-safe with respect to compress(); call before starting a run.
+    // Throws std::invalid_argument for an unsupported block size or acceleration.
+    void setOptions(const Options& options);
+    const Options& getOptions() const { return options_; }
+
+private:
+    Options options_;
+
+    size_t compressWith(ByteView data, MutableByteView output, int level, CallStats* stats);
+    // Frame format decodes every concatenated frame and, if growable is set,
+    // doubles that vector whenever output fills up
+    size_t decompressWith(ByteView compressed_data, MutableByteView output, std::vector<uint8_t>* growable,
+                          CallStats* stats);
+
+    size_t compressFrame(ByteView data, MutableByteView output, int level, CallStats* stats);
+    size_t decompressFrames(ByteView compressed_data, MutableByteView output, std::vector<uint8_t>* growable,
+                            CallStats* stats);
+    size_t compressBlock(ByteView data, MutableByteView output, int level, CallStats* stats);
+    size_t decompressBlock(ByteView compressed_data, MutableByteView output);
+};
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "Stream.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+
+FileSource::FileSource(const std::filesystem::path& path)
+    : path_(path), file_(path, std::ios::binary) {
+    if (!file_) {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+}
+
+FileSource::FileSource(const std::filesystem::path& path, uint64_t offset, uint64_t length)
+    : FileSource(path) {
+    file_.seekg(static_cast<std::streamoff>(offset));
+    if (!file_) {
+        throw std::runtime_error("Failed to seek in file: " + path.string());
+    }
+    remaining_ = length;
+}
+
+size_t FileSource::read(uint8_t* buffer, size_t capacity) {
+    capacity = static_cast<size_t>(std::min<uint64_t>(capacity, remaining_));
+    file_.read(reinterpret_cast<char*>(buffer), capacity);
+    if (file_.bad()) {
+        throw std::runtime_error("Failed to read file: " + path_.string());
+    }
+    size_t count = static_cast<size_t>(file_.gcount());
+    remaining_ -= count;
+    return count;
+}
+
+FileSink::FileSink(const std::filesystem::path& path)
+    : path_(path), file_(path, std::ios::binary) {
+    if (!file_) {
+        throw std::runtime_error("Failed to create file: " + path.string());
+    }
+}
+
+void FileSink::write(const uint8_t* data, size_t size) {
+    file_.write(reinterpret_cast<const char*>(data), size);
+    if (!file_) {
+        throw std::runtime_error("Failed to write to file: " + path_.string());
+    }
+}
+
+void FileSink::flush() {
+    file_.flush();
+    if (!file_) {
+        throw std::runtime_error("Failed to write to file: " + path_.string());
+    }
+}
+
+size_t MemorySource::read(uint8_t* buffer, size_t capacity) {
+    size_t count = std::min(capacity, size_ - pos_);
+    std::memcpy(buffer, data_ + pos_, count);
+    pos_ += count;
+    return count;
+}
+
+void MemorySink::write(const uint8_t* data, size_t size) {
+    data_.insert(data_.end(), data, data + size);
+}
+
+void ChecksumSink::write(const uint8_t* data, size_t size) {
+    // crc32 takes a uInt length, so feed very large writes in pieces
+    while (size > 0) {
+        uInt piece = static_cast<uInt>(std::min<size_t>(size, 1u << 30));
+        crc_ = static_cast<uint32_t>(crc32(crc_, data, piece));
+        data += piece;
+        size -= piece;
+        size_ += piece;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// Pull-based input for the streaming compressor interface
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+
+    // Fill up to capacity bytes; returns 0 only at end of input
+    virtual size_t read(uint8_t* buffer, size_t capacity) = 0;
+};
+
+// Push-based output for the streaming compressor interface
+class ByteSink {
+public:
+    virtual ~ByteSink() = default;
+    virtual void write(const uint8_t* data, size_t size) = 0;
+    virtual void flush() {}
+};
+
+class FileSource : public ByteSource {
+public:
+    explicit FileSource(const std::filesystem::path& path);
+    // Reads only the length bytes starting at offset
+    FileSource(const std::filesystem::path& path, uint64_t offset, uint64_t length);
+    size_t read(uint8_t* buffer, size_t capacity) override;
+
+private:
+    std::filesystem::path path_;
+    std::ifstream file_;
+    uint64_t remaining_ = UINT64_MAX;
+};
+
+class FileSink : public ByteSink {
+public:
+    explicit FileSink(const std::filesystem::path& path);
+    void write(const uint8_t* data, size_t size) override;
+    void flush() override;
+
+private:
+    std::filesystem::path path_;
+    std::ofstream file_;
+};
+
+// Reads from a buffer owned by the caller
+class MemorySource : public ByteSource {
+public:
+    MemorySource(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+    explicit MemorySource(const std::vector<uint8_t>& data) : MemorySource(data.data(), data.size()) {}
+    size_t read(uint8_t* buffer, size_t capacity) override;
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+class MemorySink : public ByteSink {
+public:
+    void write(const uint8_t* data, size_t size) override;
+    const std::vector<uint8_t>& data() const { return data_; }
+
+private:
+    std::vector<uint8_t> data_;
+};
+
+// Discards everything but the byte count and a running CRC-32, which is
+// enough to verify a round trip without keeping the output
+class ChecksumSink : public ByteSink {
+public:
+    void write(const uint8_t* data, size_t size) override;
+    uint64_t size() const { return size_; }
+    uint32_t crc() const { return crc_; }
+
+private:
+    uint64_t size_ = 0;
+    uint32_t crc_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,476 @@
+#include "XzCompressor.h"
+#include "../utils/ScratchArena.h"
+#include <lzma.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+std::string getLzmaErrorMessage(lzma_ret ret) {
+    switch (ret) {
+        case LZMA_MEM_ERROR:
+            return "Out of memory";
+        case LZMA_MEMLIMIT_ERROR:
+            return "Memory usage limit reached";
+        case LZMA_FORMAT_ERROR:
+            return "Not an xz stream";
+        case LZMA_OPTIONS_ERROR:
+            return "Unsupported options";
+        case LZMA_DATA_ERROR:
+            return "Corrupt xz data";
+        case LZMA_BUF_ERROR:
+            return "Truncated xz stream";
+        case LZMA_UNSUPPORTED_CHECK:
+            return "Unsupported integrity check";
+        case LZMA_PROG_ERROR:
+            return "Invalid arguments";
+        default:
+            return "Unknown error";
+    }
+}
+
+void checkLzma(lzma_ret ret, const char* operation) {
+    if (ret != LZMA_OK) {
+        throw std::runtime_error(std::string("liblzma error during ") + operation + ": " + getLzmaErrorMessage(ret));
+    }
+}
+
+// Each allocation is prefixed with its size so the free hook can uncount it,
+// as in ZlibContextPool
+constexpr size_t kAllocationHeader = alignof(std::max_align_t);
+
+// An lzma_stream that allocates through counting hooks. The multithreaded
+// encoder allocates from its worker threads, hence the atomics.
+struct Context {
+    lzma_stream strm = LZMA_STREAM_INIT;
+    lzma_allocator allocator;
+    std::atomic<size_t> live_bytes{0};
+    std::atomic<MemoryTracker*> tracker{nullptr};
+
+    Context() {
+        allocator.alloc = &Context::allocate;
+        allocator.free = &Context::deallocate;
+        allocator.opaque = this;
+        strm.allocator = &allocator;
+    }
+    ~Context() { lzma_end(&strm); }
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    static void* allocate(void* opaque, size_t items, size_t size) {
+        auto* context = static_cast<Context*>(opaque);
+        size_t bytes = items * size;
+        auto* block = static_cast<uint8_t*>(std::malloc(bytes + kAllocationHeader));
+        if (!block) {
+            return nullptr;
+        }
+        *reinterpret_cast<size_t*>(block) = bytes;
+        context->live_bytes += bytes;
+        if (MemoryTracker* tracker = context->tracker.load()) {
+            tracker->allocate(bytes);
+        }
+        return block + kAllocationHeader;
+    }
+
+    static void deallocate(void* opaque, void* address) {
+        if (!address) {
+            return;
+        }
+        auto* context = static_cast<Context*>(opaque);
+        uint8_t* block = static_cast<uint8_t*>(address) - kAllocationHeader;
+        size_t bytes = *reinterpret_cast<size_t*>(block);
+        context->live_bytes -= bytes;
+        if (MemoryTracker* tracker = context->tracker.load()) {
+            tracker->release(bytes);
+        }
+        std::free(block);
+    }
+};
+
+bool sameSettings(const XzCompressor::Options& a, const XzCompressor::Options& b) {
+    return a.extreme == b.extreme && a.dictionary_size == b.dictionary_size && a.threads == b.threads &&
+           a.block_size == b.block_size;
+}
+
+// Per-thread encoder. Re-initializing a used lzma_stream with the same
+// settings keeps its buffers and hash tables, the liblzma counterpart of
+// deflateReset; it is freed first when the settings change, so memory held
+// for another preset is never charged to this one. Decoders are not cached:
+// their setup is a plain allocation without table initialization.
+class ContextCache {
+public:
+    Context& encoder(int level, const XzCompressor::Options& options) {
+        if (level != level_ || !sameSettings(options, options_)) {
+            lzma_end(&encoder_.strm);
+            level_ = level;
+            options_ = options;
+        }
+        return encoder_;
+    }
+
+    static ContextCache& local() {
+        thread_local ContextCache cache;
+        return cache;
+    }
+
+private:
+    Context encoder_;
+    int level_ = -1;
+    XzCompressor::Options options_;
+};
+
+// Use of a cached context for one call. Charges what it already holds and
+// everything it allocates to tracker; afterwards frees the stream if it is
+// too large to keep idle (preset 9 holds ~674 MiB per encoder).
+class ContextUse {
+public:
+    ContextUse(Context& context, MemoryTracker* tracker) : context_(context) {
+        if (tracker) {
+            tracker->allocate(context.live_bytes);
+            context.tracker = tracker;
+        }
+    }
+
+    ~ContextUse() {
+        if (MemoryTracker* tracker = context_.tracker.exchange(nullptr)) {
+            tracker->release(context_.live_bytes);
+        }
+        if (context_.live_bytes > kMaxIdleBytes) {
+            lzma_end(&context_.strm);
+        }
+    }
+
+    ContextUse(const ContextUse&) = delete;
+    ContextUse& operator=(const ContextUse&) = delete;
+
+    lzma_stream* get() const { return &context_.strm; }
+
+private:
+    // Keeps the default preset's encoder (~94 MiB) cached
+    static constexpr size_t kMaxIdleBytes = 128 * 1024 * 1024;
+
+    Context& context_;
+};
+
+uint32_t presetOf(int level, bool extreme) {
+    if (level < 0 || level > 9) {
+        throw std::invalid_argument("xz preset out of range (0-9): " + std::to_string(level));
+    }
+    return static_cast<uint32_t>(level) | (extreme ? LZMA_PRESET_EXTREME : 0);
+}
+
+lzma_options_lzma lzmaOptions(int level, const XzCompressor::Options& options) {
+    lzma_options_lzma lzma;
+    if (lzma_lzma_preset(&lzma, presetOf(level, options.extreme))) {
+        throw std::invalid_argument("Unsupported xz preset: " + std::to_string(level));
+    }
+    if (options.dictionary_size > 0) {
+        lzma.dict_size = options.dictionary_size;
+    }
+    return lzma;
+}
+
+void initEncoder(lzma_stream* strm, int level, const XzCompressor::Options& options) {
+    lzma_options_lzma lzma = lzmaOptions(level, options);
+    lzma_filter filters[] = {{LZMA_FILTER_LZMA2, &lzma}, {LZMA_VLI_UNKNOWN, nullptr}};
+    // CRC64 is xz's default check
+    if (options.threads == 0) {
+        checkLzma(lzma_stream_encoder(strm, filters, LZMA_CHECK_CRC64), "lzma_stream_encoder");
+        return;
+    }
+    lzma_mt mt;
+    std::memset(&mt, 0, sizeof(mt));
+    mt.threads = options.threads;
+    mt.block_size = options.block_size;
+    mt.filters = filters;
+    mt.check = LZMA_CHECK_CRC64;
+    checkLzma(lzma_stream_encoder_mt(strm, &mt), "lzma_stream_encoder_mt");
+}
+
+void initDecoder(lzma_stream* strm) {
+    checkLzma(lzma_stream_decoder(strm, UINT64_MAX, LZMA_CONCATENATED), "lzma_stream_decoder");
+}
+
+using TrackedBuffer = std::vector<uint8_t, TrackingAllocator<uint8_t>>;
+
+} // namespace
+
+void XzCompressor::setOptions(const Options& options) {
+    // LZMA2's encoder accepts dictionaries up to 1.5 GiB
+    constexpr uint32_t kMaxDictionarySize = UINT32_C(1536) << 20;
+    // liblzma's internal LZMA_THREADS_MAX, which its headers do not export
+    constexpr unsigned kMaxThreads = 16384;
+    if (options.dictionary_size > 0 &&
+        (options.dictionary_size < LZMA_DICT_SIZE_MIN || options.dictionary_size > kMaxDictionarySize)) {
+        throw std::invalid_argument("xz dictionary size out of range (4 KiB-1536 MiB): " +
+                                    std::to_string(options.dictionary_size) + " bytes");
+    }
+    if (options.threads > kMaxThreads) {
+        throw std::invalid_argument("xz thread count out of range (0-" + std::to_string(kMaxThreads) + "): " +
+                                    std::to_string(options.threads));
+    }
+    options_ = options;
+}
+
+std::string XzCompressor::getAlgorithmLabel(int level) const {
+    std::string label = getName() + " (Level " + std::to_string(level);
+    if (options_.extreme) {
+        label += ", extreme";
+    }
+    if (options_.dictionary_size > 0) {
+        label += ", dict " + std::to_string(options_.dictionary_size / 1024) + " KiB";
+    }
+    if (options_.threads > 0) {
+        label += ", " + std::to_string(options_.threads) + " threads";
+    }
+    return label + ")";
+}
+
+std::string XzCompressor::getCacheKey(int level) const {
+    return getAlgorithmLabel(level) + " block " + std::to_string(options_.block_size);
+}
+
+Compressor::CompressionResult XzCompressor::compress(ByteView data, int level) {
+    Compressor::CompressionResult result;
+    ScratchArena& arena = ScratchArena::local();
+    MutableByteView compressed = arena.buffer(ScratchArena::Compressed, compressBound(data.size(), level));
+    MutableByteView decompressed = arena.buffer(ScratchArena::Decompressed, data.size());
+
+    CallStats compression;
+    compression.buffer_memory.allocate(compressed.size());
+    auto start_time = std::chrono::high_resolution_clock::now();
+    size_t compressed_size = compressWith(data, compressed, level, &compression);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.compression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+
+    CallStats decompression;
+    decompression.buffer_memory.allocate(decompressed.size());
+    ByteView compressed_view = compressed.subview(0, compressed_size);
+    start_time = std::chrono::high_resolution_clock::now();
+    size_t decompressed_size = decompressWith(compressed_view, decompressed, nullptr, &decompression);
+    end_time = std::chrono::high_resolution_clock::now();
+    result.decompression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    recordStats(result, compression, decompression);
+
+    if (decompressed_size != data.size() ||
+        (data.size() > 0 && std::memcmp(decompressed.data(), data.data(), data.size()) != 0)) {
+        throw std::runtime_error("Round-trip mismatch after decompression");
+    }
+
+    result.compressed_size = compressed_size;
+    result.compression_ratio = data.size() ? static_cast<double>(compressed_size) / data.size() : 0.0;
+    return result;
+}
+
+size_t XzCompressor::compressBound(size_t input_size, int level) const {
+    // The single-threaded encoder writes one block
+    size_t bound = lzma_stream_buffer_bound(input_size);
+    if (options_.threads == 0) {
+        return bound;
+    }
+    // The multithreaded one writes a block, and an index record, per block_size of input
+    uint64_t block_size = options_.block_size;
+    if (block_size == 0) {
+        block_size = std::max<uint64_t>(uint64_t(3) * lzmaOptions(level, options_).dict_size, 1 << 20);
+    }
+    size_t blocks = static_cast<size_t>((input_size + block_size - 1) / block_size);
+    return bound + blocks * (lzma_block_buffer_bound(0) + 2 * LZMA_VLI_BYTES_MAX);
+}
+
+size_t XzCompressor::decompressedSizeHint(ByteView compressed_data) const {
+    // The index before the stream footer records every block's size, as used
+    // by xz --list; only trusted if it describes the whole input
+    if (compressed_data.size() < 2 * LZMA_STREAM_HEADER_SIZE) {
+        return 0;
+    }
+    lzma_stream_flags footer;
+    if (lzma_stream_footer_decode(&footer, compressed_data.end() - LZMA_STREAM_HEADER_SIZE) != LZMA_OK ||
+        footer.backward_size > compressed_data.size() - 2 * LZMA_STREAM_HEADER_SIZE) {
+        return 0;
+    }
+
+    size_t index_pos = compressed_data.size() - LZMA_STREAM_HEADER_SIZE - static_cast<size_t>(footer.backward_size);
+    lzma_index* index = nullptr;
+    uint64_t memory_limit = UINT64_MAX;
+    size_t in_pos = index_pos;
+    if (lzma_index_buffer_decode(&index, &memory_limit, nullptr, compressed_data.data(), &in_pos,
+                                 compressed_data.size() - LZMA_STREAM_HEADER_SIZE) != LZMA_OK) {
+        return 0;
+    }
+    size_t size = lzma_index_stream_size(index) == compressed_data.size()
+        ? static_cast<size_t>(lzma_index_uncompressed_size(index)) : 0;
+    lzma_index_end(index, nullptr);
+    return size;
+}
+
+size_t XzCompressor::compressInto(ByteView data, MutableByteView output, int level) {
+    return compressWith(data, output, level, nullptr);
+}
+
+size_t XzCompressor::decompressInto(ByteView compressed_data, MutableByteView output) {
+    return decompressWith(compressed_data, output, nullptr, nullptr);
+}
+
+std::vector<uint8_t> XzCompressor::decompress(ByteView compressed_data) {
+    size_t hint = decompressedSizeHint(compressed_data);
+    std::vector<uint8_t> decompressed_data(hint ? hint : compressed_data.size() * 4 + 4096);
+    decompressed_data.resize(decompressWith(compressed_data, decompressed_data, &decompressed_data, nullptr));
+    return decompressed_data;
+}
+
+size_t XzCompressor::compressWith(ByteView data, MutableByteView output, int level, CallStats* stats) {
+    ContextUse context(ContextCache::local().encoder(level, options_), stats ? &stats->codec_memory : nullptr);
+    lzma_stream* strm = context.get();
+    auto start_time = std::chrono::steady_clock::now();
+    initEncoder(strm, level, options_);
+    if (stats) {
+        stats->setup_time += std::chrono::steady_clock::now() - start_time;
+    }
+
+    strm->next_in = data.data();
+    strm->avail_in = data.size();
+    strm->next_out = output.data();
+    strm->avail_out = output.size();
+    lzma_ret ret;
+    while ((ret = lzma_code(strm, LZMA_FINISH)) == LZMA_OK) {
+        if (strm->avail_out == 0) {
+            throw std::runtime_error("Output buffer too small for compressed data");
+        }
+    }
+    if (ret != LZMA_STREAM_END) {
+        checkLzma(ret, "compression");
+    }
+    return output.size() - strm->avail_out;
+}
+
+size_t XzCompressor::decompressWith(ByteView compressed_data, MutableByteView output,
+                                    std::vector<uint8_t>* growable, CallStats* stats) {
+    Context decoder;
+    ContextUse context(decoder, stats ? &stats->codec_memory : nullptr);
+    lzma_stream* strm = context.get();
+    auto start_time = std::chrono::steady_clock::now();
+    initDecoder(strm);
+    if (stats) {
+        stats->setup_time += std::chrono::steady_clock::now() - start_time;
+    }
+
+    strm->next_in = compressed_data.data();
+    strm->avail_in = compressed_data.size();
+    size_t out_pos = 0;
+    while (true) {
+        if (growable && out_pos == output.size()) {
+            growable->resize(std::max<size_t>(growable->size() * 2, 4096));
+            output = MutableByteView(*growable);
+        }
+        strm->next_out = output.data() + out_pos;
+        strm->avail_out = output.size() - out_pos;
+
+        lzma_ret ret = lzma_code(strm, LZMA_FINISH);
+        out_pos = output.size() - strm->avail_out;
+
+        if (ret == LZMA_STREAM_END) {
+            break;
+        }
+        if (ret == LZMA_BUF_ERROR) {
+            if (strm->avail_out == 0 && !growable) {
+                throw std::runtime_error("Output buffer too small for decompressed data");
+            }
+            throw std::runtime_error("Truncated xz stream");
+        }
+        checkLzma(ret, "decompression");
+    }
+    return out_pos;
+}
+
+Compressor::StreamResult XzCompressor::compressStream(ByteSource& source, ByteSink& sink, int level) {
+    CallStats stats;
+    StreamResult result;
+    {
+        ContextUse context(ContextCache::local().encoder(level, options_), &stats.codec_memory);
+        lzma_stream* strm = context.get();
+        auto start_time = std::chrono::steady_clock::now();
+        initEncoder(strm, level, options_);
+        result.setup_time = std::chrono::steady_clock::now() - start_time;
+
+        TrackedBuffer in(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+        TrackedBuffer out(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+        lzma_action action = LZMA_RUN;
+        while (true) {
+            if (strm->avail_in == 0 && action == LZMA_RUN) {
+                size_t bytes_read = source.read(in.data(), in.size());
+                result.bytes_in += bytes_read;
+                strm->next_in = in.data();
+                strm->avail_in = bytes_read;
+                if (bytes_read == 0) {
+                    action = LZMA_FINISH;
+                }
+            }
+
+            strm->next_out = out.data();
+            strm->avail_out = out.size();
+            lzma_ret ret = lzma_code(strm, action);
+            size_t produced = out.size() - strm->avail_out;
+            sink.write(out.data(), produced);
+            result.bytes_out += produced;
+            if (ret == LZMA_STREAM_END) {
+                break;
+            }
+            checkLzma(ret, "compression");
+        }
+    }
+
+    sink.flush();
+    result.codec_memory = stats.codec_memory.peak();
+    result.buffer_memory = stats.buffer_memory.peak();
+    return result;
+}
+
+Compressor::StreamResult XzCompressor::decompressStream(ByteSource& source, ByteSink& sink) {
+    CallStats stats;
+    StreamResult result;
+    {
+        Context decoder;
+        ContextUse context(decoder, &stats.codec_memory);
+        lzma_stream* strm = context.get();
+        auto start_time = std::chrono::steady_clock::now();
+        initDecoder(strm);
+        result.setup_time = std::chrono::steady_clock::now() - start_time;
+
+        TrackedBuffer in(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+        TrackedBuffer out(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+        lzma_action action = LZMA_RUN;
+        while (true) {
+            if (strm->avail_in == 0 && action == LZMA_RUN) {
+                size_t bytes_read = source.read(in.data(), in.size());
+                result.bytes_in += bytes_read;
+                strm->next_in = in.data();
+                strm->avail_in = bytes_read;
+                // LZMA_CONCATENATED only ends the last stream once told input is over
+                if (bytes_read == 0) {
+                    action = LZMA_FINISH;
+                }
+            }
+
+            strm->next_out = out.data();
+            strm->avail_out = out.size();
+            lzma_ret ret = lzma_code(strm, action);
+            size_t produced = out.size() - strm->avail_out;
+            sink.write(out.data(), produced);
+            result.bytes_out += produced;
+            if (ret == LZMA_STREAM_END) {
+                break;
+            }
+            checkLzma(ret, "decompression");
+        }
+    }
+
+    sink.flush();
+    result.codec_memory = stats.codec_memory.peak();
+    result.buffer_memory = stats.buffer_memory.peak();
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Compressor.h"
+#include <cstdint>
+
+// xz (LZMA2) backend, built when liblzma is found (DCA_HAVE_XZ). Levels are
+// xz's presets 0-9; liblzma allocates through counting hooks, so the large
+// dictionaries of the high presets show up exactly in the memory columns.
+class XzCompressor : public Compressor {
+public:
+    struct Options {
+        bool extreme = false;          // xz -e: slower match finding for a slightly better ratio
+        uint32_t dictionary_size = 0;  // Bytes; 0 = the preset's
+        unsigned threads = 0;          // liblzma's multithreaded block encoder; 0 = single-threaded
+        uint64_t block_size = 0;       // Multithreaded input bytes per block; 0 = liblzma's default (3x dictionary)
+    };
+
+    XzCompressor() : Compressor("Xz") {}
+    CompressionResult compress(ByteView data, int level = 6) override;
+    std::vector<uint8_t> decompress(ByteView compressed_data) override;
+    size_t compressBound(size_t input_size, int level = 6) const override;
+    size_t decompressedSizeHint(ByteView compressed_data) const override;
+    size_t compressInto(ByteView data, MutableByteView output, int level = 6) override;
+    size_t decompressInto(ByteView compressed_data, MutableByteView output) override;
+    StreamResult compressStream(ByteSource& source, ByteSink& sink, int level = 6) override;
+    StreamResult decompressStream(ByteSource& source, ByteSink& sink) override;
+    bool supportsStreaming() const override { return true; }
+    std::string getName() const override { return "Xz"; }
+    std::string getFileExtension() const override { return ".xz"; }
+    std::string getAlgorithmLabel(int level) const override;
+    // The label plus the block size, which the label leaves out
+    std::string getCacheKey(int level) const override;
+
+    int minLevel() const override { return 0; }
+    int maxLevel() const override { return 9; }
+    int defaultLevel() const override { return 6; }
+
+    // Not thread-safe with respect to compress(); call before starting a run.
+    // Throws std::invalid_argument for a dictionary or thread count liblzma rejects.
+    void setOptions(const Options& options);
+    const Options& getOptions() const { return options_; }
+
+private:
+    Options options_;
+
+    size_t compressWith(ByteView data, MutableByteView output, int level, CallStats* stats);
+    // Decodes every concatenated stream; if growable is set, output is that
+    // vector and it is doubled whenever it fills up
+    size_t decompressWith(ByteView compressed_data, MutableByteView output, std::vector<uint8_t>* growable,
+                          CallStats* stats);
+};
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "ZlibContextPool.h"
+#include "../utils/MemoryTracker.h"
+#include <cstdlib>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+uint64_t makeKey(bool is_deflate, int level, int window_bits, int mem_level, int strategy) {
+    // Each field fits comfortably in a byte once offset to be non-negative
+    return (static_cast<uint64_t>(is_deflate) << 32) |
+           (static_cast<uint64_t>(level + 1) << 24) |
+           (static_cast<uint64_t>(window_bits + 64) << 16) |
+           (static_cast<uint64_t>(mem_level) << 8) |
+           static_cast<uint64_t>(strategy);
+}
+
+// Each zlib allocation is prefixed with its size so zfree can uncount it;
+// the prefix keeps the returned pointer maximally aligned
+constexpr size_t kAllocationHeader = alignof(std::max_align_t);
+
+} // namespace
+
+ZlibContextPool::Lease::Lease(ZlibContextPool* pool, std::unique_ptr<Context> context,
+                              std::chrono::nanoseconds setup_time)
+    : pool_(pool), context_(std::move(context)), setup_time_(setup_time) {
+    // Reset leaves the buffer pointers alone; a call that threw mid-stream
+    // would otherwise hand the next lease input it no longer owns
+    z_stream& strm = context_->strm;
+    strm.next_in = nullptr;
+    strm.avail_in = 0;
+    strm.next_out = nullptr;
+    strm.avail_out = 0;
+}
+
+ZlibContextPool::Lease::~Lease() {
+    if (context_) {
+        attachTracker(nullptr);
+        pool_->release(std::move(context_));
+    }
+}
+
+z_stream* ZlibContextPool::Lease::get() const {
+    return &context_->strm;
+}
+
+void ZlibContextPool::Lease::attachTracker(MemoryTracker* tracker) {
+    if (context_->tracker) {
+        context_->tracker->release(context_->live_bytes);
+    }
+    context_->tracker = tracker;
+    if (tracker) {
+        tracker->allocate(context_->live_bytes);
+    }
+}
+
+ZlibContextPool::~ZlibContextPool() {
+    for (auto& [key, contexts] : idle_) {
+        for (auto& context : contexts) {
+            destroy(*context);
+        }
+    }
+}
+
+ZlibContextPool& ZlibContextPool::local() {
+    thread_local ZlibContextPool pool;
+    return pool;
+}
+
+std::unique_ptr<ZlibContextPool::Context> ZlibContextPool::takeIdle(uint64_t key) {
+    auto it = idle_.find(key);
+    if (it == idle_.end() || it->second.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<Context> context = std::move(it->second.back());
+    it->second.pop_back();
+    if (it->second.empty()) {
+        idle_.erase(it);
+    }
+    --idle_count_;
+    return context;
+}
+
+ZlibContextPool::Lease ZlibContextPool::acquireDeflate(int level, int window_bits, int mem_level, int strategy) {
+    auto start_time = std::chrono::steady_clock::now();
+    uint64_t key = makeKey(true, level, window_bits, mem_level, strategy);
+
+    std::unique_ptr<Context> context = takeIdle(key);
+    if (context && deflateReset(&context->strm) != Z_OK) {
+        destroy(*context);
+        context.reset();
+    }
+    if (!context) {
+        context = newContext(true, key);
+        int ret = deflateInit2(&context->strm, level, Z_DEFLATED, window_bits, mem_level, strategy);
+        if (ret != Z_OK) {
+            throw std::runtime_error(std::string("zlib error during deflateInit2: ") + zError(ret));
+        }
+    }
+
+    auto setup_time = std::chrono::steady_clock::now() - start_time;
+    return Lease(this, std::move(context), std::chrono::duration_cast<std::chrono::nanoseconds>(setup_time));
+}
+
+ZlibContextPool::Lease ZlibContextPool::acquireInflate(int window_bits) {
+    auto start_time = std::chrono::steady_clock::now();
+    uint64_t key = makeKey(false, 0, window_bits, 0, 0);
+
+    std::unique_ptr<Context> context = takeIdle(key);
+    if (context && inflateReset(&context->strm) != Z_OK) {
+        destroy(*context);
+        context.reset();
+    }
+    if (!context) {
+        context = newContext(false, key);
+        int ret = inflateInit2(&context->strm, window_bits);
+        if (ret != Z_OK) {
+            throw std::runtime_error(std::string("zlib error during inflateInit2: ") + zError(ret));
+        }
+    }
+
+    auto setup_time = std::chrono::steady_clock::now() - start_time;
+    return Lease(this, std::move(context), std::chrono::duration_cast<std::chrono::nanoseconds>(setup_time));
+}
+
+void ZlibContextPool::release(std::unique_ptr<Context> context) {
+    auto& contexts = idle_[context->key];
+    if (contexts.size() >= kMaxIdlePerKey) {
+        destroy(*context);
+        return;
+    }
+    context->released_at = ++releases_;
+    contexts.push_back(std::move(context));
+    if (++idle_count_ > kMaxIdleTotal) {
+        evictOldest();
+    }
+}
+
+void ZlibContextPool::evictOldest() {
+    // Each key's front is its oldest, and there are at most kMaxIdleTotal keys
+    auto oldest = idle_.end();
+    for (auto it = idle_.begin(); it != idle_.end(); ++it) {
+        if (oldest == idle_.end() || it->second.front()->released_at < oldest->second.front()->released_at) {
+            oldest = it;
+        }
+    }
+    destroy(*oldest->second.front());
+    oldest->second.erase(oldest->second.begin());
+    if (oldest->second.empty()) {
+        idle_.erase(oldest);
+    }
+    --idle_count_;
+}
+
+std::unique_ptr<ZlibContextPool::Context> ZlibContextPool::newContext(bool is_deflate, uint64_t key) {
+    auto context = std::make_unique<Context>();
+    context->strm.zalloc = &ZlibContextPool::allocate;
+    context->strm.zfree = &ZlibContextPool::deallocate;
+    context->strm.opaque = context.get();
+    context->strm.avail_in = 0;
+    context->strm.next_in = Z_NULL;
+    context->is_deflate = is_deflate;
+    context->key = key;
+    return context;
+}
+
+voidpf ZlibContextPool::allocate(voidpf opaque, uInt items, uInt size) {
+    auto* context = static_cast<Context*>(opaque);
+    size_t bytes = static_cast<size_t>(items) * size;
+    auto* block = static_cast<uint8_t*>(std::malloc(bytes + kAllocationHeader));
+    if (!block) {
+        return Z_NULL;
+    }
+    *reinterpret_cast<size_t*>(block) = bytes;
+    context->live_bytes += bytes;
+    if (context->tracker) {
+        context->tracker->allocate(bytes);
+    }
+    return block + kAllocationHeader;
+}
+
+void ZlibContextPool::deallocate(voidpf opaque, voidpf address) {
+    auto* context = static_cast<Context*>(opaque);
+    uint8_t* block = static_cast<uint8_t*>(address) - kAllocationHeader;
+    size_t bytes = *reinterpret_cast<size_t*>(block);
+    context->live_bytes -= bytes;
+    if (context->tracker) {
+        context->tracker->release(bytes);
+    }
+    std::free(block);
+}
+
+void ZlibContextPool::destroy(Context& context) {
+    if (context.is_deflate) {
+        deflateEnd(&context.strm);
+    } else {
+        inflateEnd(&context.strm);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+class MemoryTracker;
+
+// Per-thread cache of initialized z_streams. deflateInit2/inflateInit2
+// allocate several hundred KB of window and hash tables, which dominates
+// the cost of compressing small inputs; a leased context is instead reset
+// with deflateReset/inflateReset. Contexts are keyed by every parameter
+// that reset does not change (level, windowBits, memLevel, strategy).
+// Every context allocates through counting zalloc/zfree hooks, so the
+// memory zlib holds for an operation can be reported exactly. Idle contexts
+// are capped per key and per thread; past the thread cap the least recently
+// released one is freed, so a sweep over many settings stays bounded.
+class ZlibContextPool {
+private:
+    struct Context;
+
+public:
+    // Exclusive use of one context; returns it to the pool when destroyed
+    class Lease {
+    public:
+        Lease(ZlibContextPool* pool, std::unique_ptr<Context> context, std::chrono::nanoseconds setup_time);
+        ~Lease();
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&& other) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        z_stream* get() const;
+        z_stream* operator->() const { return get(); }
+
+        // Time spent obtaining a ready context (init on a miss, reset on a hit)
+        std::chrono::nanoseconds setupTime() const { return setup_time_; }
+
+        // Charge the context's allocations to tracker until the lease ends,
+        // including what it already holds from earlier use
+        void attachTracker(MemoryTracker* tracker);
+
+    private:
+        ZlibContextPool* pool_;
+        std::unique_ptr<Context> context_;
+        std::chrono::nanoseconds setup_time_;
+    };
+
+    ZlibContextPool() = default;
+    ~ZlibContextPool();
+    ZlibContextPool(const ZlibContextPool&) = delete;
+    ZlibContextPool& operator=(const ZlibContextPool&) = delete;
+
+    Lease acquireDeflate(int level, int window_bits = 15 + 16, int mem_level = 8,
+                         int strategy = Z_DEFAULT_STRATEGY);
+    Lease acquireInflate(int window_bits = 15 + 16);
+
+    // Pool owned by the calling thread; leases must be released on that thread
+    static ZlibContextPool& local();
+
+private:
+    struct Context {
+        z_stream strm;  // zlib keeps a back-pointer to this, so contexts never move
+        bool is_deflate;
+        uint64_t key;
+        size_t live_bytes = 0;             // Currently allocated by zlib for this stream
+        uint64_t released_at = 0;          // Pool release count when last returned
+        MemoryTracker* tracker = nullptr;  // Set while leased with attachTracker
+    };
+
+    // Idle contexts kept per key; more than this are freed on release
+    static constexpr size_t kMaxIdlePerKey = 4;
+    // Idle contexts kept across all keys; the oldest is freed past this
+    static constexpr size_t kMaxIdleTotal = 16;
+
+    // Per key, oldest release first
+    std::unordered_map<uint64_t, std::vector<std::unique_ptr<Context>>> idle_;
+    size_t idle_count_ = 0;
+    uint64_t releases_ = 0;
+
+    std::unique_ptr<Context> takeIdle(uint64_t key);
+    void release(std::unique_ptr<Context> context);
+    void evictOldest();
+    static void destroy(Context& context);
+    static std::unique_ptr<Context> newContext(bool is_deflate, uint64_t key);
+
+    // zalloc/zfree hooks; opaque is the owning Context
+    static voidpf allocate(voidpf opaque, uInt items, uInt size);
+    static void deallocate(voidpf opaque, voidpf address);
+};
\ No newline at end of file
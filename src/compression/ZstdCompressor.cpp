@@ -0,0 +1,373 @@
+#include "ZstdCompressor.h"
+#include "../utils/ContentHash.h"
+#include "../utils/ScratchArena.h"
+#include <zstd.h>
+#include <zstd_errors.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+size_t checkZstd(size_t ret, const char* operation) {
+    if (ZSTD_isError(ret)) {
+        throw std::runtime_error(std::string("zstd error during ") + operation + ": " + ZSTD_getErrorName(ret));
+    }
+    return ret;
+}
+
+void setParameter(ZSTD_CCtx* cctx, ZSTD_cParameter parameter, int value) {
+    checkZstd(ZSTD_CCtx_setParameter(cctx, parameter, value), "ZSTD_CCtx_setParameter");
+}
+
+// Per-thread zstd contexts, reused across calls the way ZlibContextPool
+// reuses z_streams. Compression contexts are keyed by their parameters, so
+// a workspace sized for level 19 is never charged to a level 1 run. With
+// workers each context owns a thread pool, hence the small cap.
+class ContextCache {
+public:
+    ~ContextCache() {
+        for (auto& [key, cctx] : compression_) {
+            ZSTD_freeCCtx(cctx);
+        }
+        ZSTD_freeDCtx(decompression_);
+    }
+
+    ZSTD_CCtx* compression(int level, const ZstdCompressor::Options& options) {
+        uint64_t key = (static_cast<uint64_t>(level + 1024) << 40) |
+                       (static_cast<uint64_t>(options.long_window_log) << 32) | options.workers;
+        auto it = compression_.find(key);
+        if (it != compression_.end()) {
+            // Parameters survive a session reset; only the frame state is dropped
+            ZSTD_CCtx_reset(it->second, ZSTD_reset_session_only);
+            return it->second;
+        }
+
+        if (compression_.size() >= kMaxCompressionContexts) {
+            ZSTD_freeCCtx(compression_.begin()->second);
+            compression_.erase(compression_.begin());
+        }
+        ZSTD_CCtx* cctx = ZSTD_createCCtx();
+        if (!cctx) {
+            throw std::runtime_error("zstd error: failed to create compression context");
+        }
+        try {
+            setParameter(cctx, ZSTD_c_compressionLevel, level);
+            // gzip always carries a CRC-32; keep the comparison fair
+            setParameter(cctx, ZSTD_c_checksumFlag, 1);
+            if (options.long_window_log > 0) {
+                setParameter(cctx, ZSTD_c_enableLongDistanceMatching, 1);
+                setParameter(cctx, ZSTD_c_windowLog, options.long_window_log);
+            }
+            if (options.workers > 0) {
+                setParameter(cctx, ZSTD_c_nbWorkers, static_cast<int>(options.workers));
+            }
+        } catch (...) {
+            ZSTD_freeCCtx(cctx);
+            throw;
+        }
+        compression_.emplace(key, cctx);
+        return cctx;
+    }
+
+    ZSTD_DCtx* decompression() {
+        if (decompression_) {
+            ZSTD_DCtx_reset(decompression_, ZSTD_reset_session_only);
+            return decompression_;
+        }
+        decompression_ = ZSTD_createDCtx();
+        if (!decompression_) {
+            throw std::runtime_error("zstd error: failed to create decompression context");
+        }
+        // Accept the large windows long-distance matching produces
+        int window_log_max = sizeof(size_t) == 4 ? 30 : 31;
+        checkZstd(ZSTD_DCtx_setParameter(decompression_, ZSTD_d_windowLogMax, window_log_max),
+                  "ZSTD_DCtx_setParameter");
+        return decompression_;
+    }
+
+    static ContextCache& local() {
+        thread_local ContextCache cache;
+        return cache;
+    }
+
+private:
+    static constexpr size_t kMaxCompressionContexts = 4;
+
+    std::unordered_map<uint64_t, ZSTD_CCtx*> compression_;
+    ZSTD_DCtx* decompression_ = nullptr;
+};
+
+using TrackedBuffer = std::vector<uint8_t, TrackingAllocator<uint8_t>>;
+
+} // namespace
+
+// CDicts depend on the level, so they are built on first use per level;
+// the DDict serves every level
+struct ZstdCompressor::DigestedDictionary {
+    std::shared_ptr<const std::vector<uint8_t>> content;
+    ZSTD_DDict* decompression = nullptr;
+    std::mutex mutex;
+    std::map<int, ZSTD_CDict*> compression;
+
+    explicit DigestedDictionary(std::shared_ptr<const std::vector<uint8_t>> dictionary)
+        : content(std::move(dictionary)) {
+        decompression = ZSTD_createDDict(content->data(), content->size());
+        if (!decompression) {
+            throw std::runtime_error("zstd error: failed to digest dictionary");
+        }
+    }
+
+    ~DigestedDictionary() {
+        for (auto& [level, cdict] : compression) {
+            ZSTD_freeCDict(cdict);
+        }
+        ZSTD_freeDDict(decompression);
+    }
+
+    const ZSTD_CDict* forLevel(int level) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ZSTD_CDict*& cdict = compression[level];
+        if (!cdict) {
+            cdict = ZSTD_createCDict(content->data(), content->size(), level);
+            if (!cdict) {
+                compression.erase(level);
+                throw std::runtime_error("zstd error: failed to digest dictionary");
+            }
+        }
+        return cdict;
+    }
+};
+
+int ZstdCompressor::maxLevel() const {
+    return ZSTD_maxCLevel();
+}
+
+void ZstdCompressor::setOptions(const Options& options) {
+    if (options.long_window_log > 0) {
+        ZSTD_bounds bounds = ZSTD_cParam_getBounds(ZSTD_c_windowLog);
+        if (options.long_window_log < bounds.lowerBound || options.long_window_log > bounds.upperBound) {
+            throw std::invalid_argument("Zstd long-distance window out of range (" +
+                                        std::to_string(bounds.lowerBound) + "-" +
+                                        std::to_string(bounds.upperBound) + "): " +
+                                        std::to_string(options.long_window_log));
+        }
+    }
+    if (options.workers > 0 && ZSTD_cParam_getBounds(ZSTD_c_nbWorkers).upperBound == 0) {
+        throw std::invalid_argument("libzstd was built without multithreading support");
+    }
+    options_ = options;
+    if (!options_.dictionary) {
+        digested_.reset();
+        dictionary_digest_.clear();
+    } else if (!digested_ || digested_->content != options_.dictionary) {
+        digested_ = std::make_shared<DigestedDictionary>(options_.dictionary);
+        dictionary_digest_ = ContentHasher::of(*options_.dictionary).hex();
+    }
+}
+
+std::string ZstdCompressor::getCacheKey(int level) const {
+    std::string key = getAlgorithmLabel(level);
+    return dictionary_digest_.empty() ? key : key + " " + dictionary_digest_;
+}
+
+std::string ZstdCompressor::getAlgorithmLabel(int level) const {
+    std::string label = getName() + " (Level " + std::to_string(level);
+    if (options_.long_window_log > 0) {
+        label += ", long " + std::to_string(options_.long_window_log);
+    }
+    if (options_.workers > 0) {
+        label += ", " + std::to_string(options_.workers) + " workers";
+    }
+    if (options_.dictionary) {
+        label += ", dict " + std::to_string((options_.dictionary->size() + 1023) / 1024) + " KB";
+    }
+    return label + ")";
+}
+
+Compressor::CompressionResult ZstdCompressor::compress(ByteView data, int level) {
+    Compressor::CompressionResult result;
+    ScratchArena& arena = ScratchArena::local();
+    MutableByteView compressed = arena.buffer(ScratchArena::Compressed, compressBound(data.size(), level));
+    MutableByteView decompressed = arena.buffer(ScratchArena::Decompressed, data.size());
+
+    CallStats compression;
+    compression.buffer_memory.allocate(compressed.size());
+    auto start_time = std::chrono::high_resolution_clock::now();
+    size_t compressed_size = compressWith(data, compressed, level, &compression);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.compression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+
+    CallStats decompression;
+    decompression.buffer_memory.allocate(decompressed.size());
+    ByteView compressed_view = compressed.subview(0, compressed_size);
+    start_time = std::chrono::high_resolution_clock::now();
+    size_t decompressed_size = decompressWith(compressed_view, decompressed, &decompression);
+    end_time = std::chrono::high_resolution_clock::now();
+    result.decompression_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    recordStats(result, compression, decompression);
+
+    if (decompressed_size != data.size() ||
+        (data.size() > 0 && std::memcmp(decompressed.data(), data.data(), data.size()) != 0)) {
+        throw std::runtime_error("Round-trip mismatch after decompression");
+    }
+
+    result.compressed_size = compressed_size;
+    result.compression_ratio = data.size() ? static_cast<double>(compressed_size) / data.size() : 0.0;
+    return result;
+}
+
+size_t ZstdCompressor::compressBound(size_t input_size, int) const {
+    return ZSTD_compressBound(input_size);
+}
+
+size_t ZstdCompressor::decompressedSizeHint(ByteView compressed_data) const {
+    unsigned long long size = ZSTD_getFrameContentSize(compressed_data.data(), compressed_data.size());
+    if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR) {
+        return 0;
+    }
+    // The header only describes the first frame
+    if (ZSTD_findFrameCompressedSize(compressed_data.data(), compressed_data.size()) != compressed_data.size()) {
+        return 0;
+    }
+    return static_cast<size_t>(size);
+}
+
+size_t ZstdCompressor::compressInto(ByteView data, MutableByteView output, int level) {
+    return compressWith(data, output, level, nullptr);
+}
+
+size_t ZstdCompressor::decompressInto(ByteView compressed_data, MutableByteView output) {
+    return decompressWith(compressed_data, output, nullptr);
+}
+
+std::vector<uint8_t> ZstdCompressor::decompress(ByteView compressed_data) {
+    size_t hint = decompressedSizeHint(compressed_data);
+    if (hint > 0) {
+        std::vector<uint8_t> decompressed_data(hint);
+        decompressed_data.resize(decompressWith(compressed_data, decompressed_data, nullptr));
+        return decompressed_data;
+    }
+    // Streamed or multi-frame input carries no usable size, so grow as we go
+    MemorySource source(compressed_data.data(), compressed_data.size());
+    MemorySink sink;
+    decompressStream(source, sink);
+    return sink.data();
+}
+
+size_t ZstdCompressor::compressWith(ByteView data, MutableByteView output, int level, CallStats* stats) {
+    auto start_time = std::chrono::steady_clock::now();
+    ZSTD_CCtx* cctx = ContextCache::local().compression(level, options_);
+    // Cached contexts are shared with other instances, so always (un)set it
+    checkZstd(ZSTD_CCtx_refCDict(cctx, digested_ ? digested_->forLevel(level) : nullptr), "ZSTD_CCtx_refCDict");
+    if (stats) {
+        stats->setup_time += std::chrono::steady_clock::now() - start_time;
+    }
+
+    size_t size = checkZstd(ZSTD_compress2(cctx, output.data(), output.size(), data.data(), data.size()),
+                            "compression");
+    // zstd sizes its workspace once per context and keeps it, so the
+    // footprint after the call is the peak the call needed
+    if (stats) {
+        stats->codec_memory.allocate(ZSTD_sizeof_CCtx(cctx));
+    }
+    return size;
+}
+
+size_t ZstdCompressor::decompressWith(ByteView compressed_data, MutableByteView output, CallStats* stats) {
+    auto start_time = std::chrono::steady_clock::now();
+    ZSTD_DCtx* dctx = ContextCache::local().decompression();
+    checkZstd(ZSTD_DCtx_refDDict(dctx, digested_ ? digested_->decompression : nullptr), "ZSTD_DCtx_refDDict");
+    if (stats) {
+        stats->setup_time += std::chrono::steady_clock::now() - start_time;
+    }
+
+    // Decodes every concatenated frame
+    size_t size = checkZstd(ZSTD_decompressDCtx(dctx, output.data(), output.size(),
+                                                compressed_data.data(), compressed_data.size()),
+                            "decompression");
+    if (stats) {
+        stats->codec_memory.allocate(ZSTD_sizeof_DCtx(dctx));
+    }
+    return size;
+}
+
+Compressor::StreamResult ZstdCompressor::compressStream(ByteSource& source, ByteSink& sink, int level) {
+    CallStats stats;
+    StreamResult result;
+    auto start_time = std::chrono::steady_clock::now();
+    ZSTD_CCtx* cctx = ContextCache::local().compression(level, options_);
+    checkZstd(ZSTD_CCtx_refCDict(cctx, digested_ ? digested_->forLevel(level) : nullptr), "ZSTD_CCtx_refCDict");
+    result.setup_time = std::chrono::steady_clock::now() - start_time;
+
+    TrackedBuffer in(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    TrackedBuffer out(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+
+    ZSTD_EndDirective mode;
+    do {
+        size_t bytes_read = source.read(in.data(), in.size());
+        result.bytes_in += bytes_read;
+        mode = bytes_read == 0 ? ZSTD_e_end : ZSTD_e_continue;
+        ZSTD_inBuffer input = {in.data(), bytes_read, 0};
+
+        // Until the chunk is consumed, or the frame is fully flushed at the end
+        bool finished;
+        do {
+            ZSTD_outBuffer output = {out.data(), out.size(), 0};
+            size_t remaining = checkZstd(ZSTD_compressStream2(cctx, &output, &input, mode), "compression");
+            sink.write(out.data(), output.pos);
+            result.bytes_out += output.pos;
+            finished = mode == ZSTD_e_end ? remaining == 0 : input.pos == input.size;
+        } while (!finished);
+    } while (mode != ZSTD_e_end);
+
+    sink.flush();
+    result.codec_memory = ZSTD_sizeof_CCtx(cctx);
+    result.buffer_memory = stats.buffer_memory.peak();
+    return result;
+}
+
+Compressor::StreamResult ZstdCompressor::decompressStream(ByteSource& source, ByteSink& sink) {
+    CallStats stats;
+    StreamResult result;
+    auto start_time = std::chrono::steady_clock::now();
+    ZSTD_DCtx* dctx = ContextCache::local().decompression();
+    checkZstd(ZSTD_DCtx_refDDict(dctx, digested_ ? digested_->decompression : nullptr), "ZSTD_DCtx_refDDict");
+    result.setup_time = std::chrono::steady_clock::now() - start_time;
+
+    TrackedBuffer in(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    TrackedBuffer out(kStreamChunkSize, TrackingAllocator<uint8_t>(&stats.buffer_memory));
+    ZSTD_inBuffer input = {in.data(), 0, 0};
+    size_t pending = 0;  // Non-zero while a frame is incomplete
+    bool output_full = false;
+
+    while (true) {
+        // A full output buffer may mean the decoder still holds data, so drain before reading
+        if (input.pos == input.size && !output_full) {
+            size_t bytes_read = source.read(in.data(), in.size());
+            if (bytes_read == 0) {
+                break;
+            }
+            result.bytes_in += bytes_read;
+            input = {in.data(), bytes_read, 0};
+        }
+
+        ZSTD_outBuffer output = {out.data(), out.size(), 0};
+        pending = checkZstd(ZSTD_decompressStream(dctx, &output, &input), "decompression");
+        sink.write(out.data(), output.pos);
+        result.bytes_out += output.pos;
+        output_full = (output.pos == output.size);
+    }
+    if (pending != 0) {
+        throw std::runtime_error("Truncated zstd stream");
+    }
+
+    sink.flush();
+    result.codec_memory = ZSTD_sizeof_DCtx(dctx);
+    result.buffer_memory = stats.buffer_memory.peak();
+    return result;
+}
\ No newline at end of file
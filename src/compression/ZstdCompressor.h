@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Compressor.h"
+
+// Zstandard backend, built when libzstd is found (DCA_HAVE_ZSTD)
+class ZstdCompressor : public Compressor {
+public:
+    struct Options {
+        int long_window_log = 0;  // Long-distance matching window as log2 bytes; 0 = off
+        unsigned workers = 0;     // zstd's internal compression threads; 0 = in the calling thread
+        // Dictionary (see DictionaryTrainer): a ZDICT one, or raw content.
+        // Digested once per level and shared by every thread.
+        std::shared_ptr<const std::vector<uint8_t>> dictionary;
+    };
+
+    ZstdCompressor() : Compressor("Zstd") {}
+    CompressionResult compress(ByteView data, int level = 3) override;
+    std::vector<uint8_t> decompress(ByteView compressed_data) override;
+    size_t compressBound(size_t input_size, int level = 3) const override;
+    size_t decompressedSizeHint(ByteView compressed_data) const override;
+    size_t compressInto(ByteView data, MutableByteView output, int level = 3) override;
+    size_t decompressInto(ByteView compressed_data, MutableByteView output) override;
+    StreamResult compressStream(ByteSource& source, ByteSink& sink, int level = 3) override;
+    StreamResult decompressStream(ByteSource& source, ByteSink& sink) override;
+    bool supportsStreaming() const override { return true; }
+    std::string getName() const override { return "Zstd"; }
+    std::string getFileExtension() const override { return ".zst"; }
+    std::string getAlgorithmLabel(int level) const override;
+    // The label plus the dictionary's digest; the label only gives its size
+    std::string getCacheKey(int level) const override;
+
+    // Negative levels are zstd's fast modes; it accepts lower still, but
+    // past -7 they mostly trade ratio for nothing
+    int minLevel() const override { return -7; }
+    int maxLevel() const override;
+    int defaultLevel() const override { return 3; }
+
+    // Not thread-safe with respect to compress(); call before starting a run.
+    // Throws if libzstd rejects a setting (e.g. workers on a single-threaded build).
+    void setOptions(const Options& options);
+    const Options& getOptions() const { return options_; }
+
+private:
+    struct DigestedDictionary;
+
+    Options options_;
+    std::shared_ptr<DigestedDictionary> digested_;  // Set when options_ has a dictionary
+    std::string dictionary_digest_;                 // Hex ContentDigest of it, empty if none
+
+    size_t compressWith(ByteView data, MutableByteView output, int level, CallStats* stats);
+    size_t decompressWith(ByteView compressed_data, MutableByteView output, CallStats* stats);
+};
\ No newline at end of file
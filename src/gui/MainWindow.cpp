@@ -1,11 +1,28 @@
 #include "MainWindow.h"
-#include "../compression/GzipCompressor.h"
+#include "../analysis/ResultCache.h"
 #include "../compression/ArchiveCompressor.h"
+#include "../compression/AutoCompressor.h"
+#include "../compression/CompressorFactory.h"
+#include "../compression/DictionaryTrainer.h"
+#include "../compression/GzipCompressor.h"
+#ifdef DCA_HAVE_ZSTD
+#include "../compression/ZstdCompressor.h"
+#endif
+#ifdef DCA_HAVE_LZ4
+#include "../compression/Lz4Compressor.h"
+#endif
+#ifdef DCA_HAVE_XZ
+#include "../compression/XzCompressor.h"
+#endif
 #include "../utils/FileHandler.h"
+#include "../utils/ThreadPool.h"
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <algorithm>
-#include <thread>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <future>
 #include <iostream>
 #include <tinyfiledialogs.h>
@@ -19,6 +36,7 @@ MainWindow::MainWindow() {
 }
 
 MainWindow::~MainWindow() {
+    job_.reset();
     cleanupImGui();
     cleanup();
 }
@@ -55,8 +73,7 @@ void MainWindow::initImGui() {
 }
 
 void MainWindow::initCompressors() {
-    compressors_.push_back(std::make_unique<GzipCompressor>());
-    compressors_.push_back(std::make_unique<ArchiveCompressor>());
+    compressors_ = CompressorFactory::createAll();
 }
 
 void MainWindow::run() {
@@ -86,6 +103,7 @@ void MainWindow::render() {
 
     renderFileSelection();
     renderCompressionOptions();
+    renderProgress();
     renderResults();
     renderExportOptions();
 
@@ -121,47 +139,457 @@ void MainWindow::renderFileSelection() {
 void MainWindow::renderCompressionOptions() {
     if (ImGui::CollapsingHeader("Compression Options", ImGuiTreeNodeFlags_DefaultOpen)) {
         static int selected_compressor = 0;
-        static int gzip_level = 6;
+        static int compression_level = compressors_[0]->defaultLevel();
         static bool archive_mode = false;
+        static int worker_threads = static_cast<int>(ThreadPool::defaultThreadCount());
+        static bool gzip_parallel = false;
+        static int gzip_block_kb = 128;
+        static int gzip_block_threads = static_cast<int>(ThreadPool::defaultThreadCount());
+        static bool streaming = false;
+        static bool use_cache = false;
+        static int warmup_runs = 1;
+        static int repetitions = 5;
+        static float target_ci_percent = 0.0f;
+        static int entropy_window_index = 2;
+        static int estimate_mode = 0;
+        static int sample_blocks = 32;
+        static bool skip_incompressible = false;
+        static float skip_ratio = 0.95f;
+        static bool shared_dictionary = false;
+#ifdef DCA_HAVE_ZSTD
+        static bool zstd_long = false;
+        static int zstd_window_log = 27;
+        static int zstd_workers = 0;
+#endif
+#ifdef DCA_HAVE_LZ4
+        static int lz4_format = 0;
+        static int lz4_acceleration = 1;
+        static bool lz4_independent = false;
+        static int lz4_block_size_index = 0;
+#endif
+#ifdef DCA_HAVE_XZ
+        static bool xz_extreme = false;
+        static bool xz_custom_dictionary = false;
+        static int xz_dictionary_log = 23;
+        static int xz_threads = 0;
+#endif
+        static float auto_min_speed = 100.0f;
+        static bool auto_time_limit = false;
+        static float auto_max_ms = 50.0f;
+        static int archive_layout = 0;
+        static int archive_frame_index = 2;
+        static int archive_threads = 1;
 
         if (ImGui::BeginCombo("Compressor", compressors_[selected_compressor]->getName().c_str())) {
             for (int i = 0; i < compressors_.size(); i++) {
                 if (ImGui::Selectable(compressors_[i]->getName().c_str(), selected_compressor == i)) {
                     selected_compressor = i;
-                    archive_mode = (i == 1); // Enable archive mode for ArchiveCompressor
+                    compression_level = compressors_[i]->defaultLevel();
+                    archive_mode = dynamic_cast<ArchiveCompressor*>(compressors_[i].get()) != nullptr;
                 }
             }
             ImGui::EndCombo();
         }
 
-        // Show Gzip level slider for both Gzip and Archive compressors
-        if (selected_compressor == 0 || selected_compressor == 1) {
-            ImGui::SliderInt("Gzip Compression Level", &gzip_level, 1, 9);
+        // Level range depends on the codec (zstd goes from -7 to 22)
+        Compressor& compressor = *compressors_[selected_compressor];
+        auto* selector = dynamic_cast<AutoCompressor*>(compressors_[selected_compressor].get());
+        if (selector) {
+            ImGui::SliderFloat("Min Compression Speed (MB/s)", &auto_min_speed, 0.0f, 1000.0f, "%.0f");
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Each file gets the smallest setting whose trial compressions reach\n"
+                                  "this speed; 0 accepts any speed");
+            }
+            ImGui::Checkbox("Time Limit per File", &auto_time_limit);
+            if (auto_time_limit) {
+                ImGui::SameLine();
+                ImGui::SliderFloat("ms", &auto_max_ms, 1.0f, 1000.0f, "%.0f");
+            }
+        } else {
+            ImGui::SliderInt("Compression Level", &compression_level, compressor.minLevel(), compressor.maxLevel());
             if (ImGui::IsItemHovered()) {
                 ImGui::SetTooltip("Higher levels provide better compression but are slower");
             }
         }
 
-        if (ImGui::Button("Start Analysis") && !selected_files_.empty() && !is_processing_) {
-            is_processing_ = true;
-            int current_compressor = selected_compressor;
-            int current_level = gzip_level;
-            bool current_archive_mode = archive_mode;
-            std::thread([this, current_compressor, current_level, current_archive_mode]() {
-                processFiles(current_compressor, current_level, current_archive_mode);
-                is_processing_ = false;
-            }).detach();
+        auto* gzip = dynamic_cast<GzipCompressor*>(compressors_[selected_compressor].get());
+        if (gzip) {
+            ImGui::Checkbox("Block-Parallel Gzip", &gzip_parallel);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Deflate independent blocks on several threads (pigz-style) and\n"
+                                  "report the ratio cost versus one single-stream deflate");
+            }
+            if (gzip_parallel) {
+                ImGui::SliderInt("Block Size (KB)", &gzip_block_kb, 32, 4096);
+                ImGui::SliderInt("Block Threads", &gzip_block_threads, 1,
+                                 static_cast<int>(ThreadPool::defaultThreadCount()) * 2);
+            } else {
+                ImGui::Checkbox("Shared Dictionary", &shared_dictionary);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Train a dictionary on a sample of the selected files and give every\n"
+                                      "other file its history up front (output becomes zlib-wrapped);\n"
+                                      "the sample is held out of the results");
+                }
+            }
+        }
+        bool takes_dictionary = gzip && !gzip_parallel;
+
+#ifdef DCA_HAVE_ZSTD
+        auto* zstd = dynamic_cast<ZstdCompressor*>(compressors_[selected_compressor].get());
+        if (zstd) {
+            ImGui::Checkbox("Long-Distance Matching", &zstd_long);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Find repeats far back in large inputs; the decoder needs a window this big");
+            }
+            if (zstd_long) {
+                ImGui::SliderInt("LDM Window (log2 bytes)", &zstd_window_log, 20, 31);
+            }
+            ImGui::SliderInt("Zstd Workers", &zstd_workers, 0, static_cast<int>(ThreadPool::defaultThreadCount()) * 2);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("zstd's own compression threads; 0 compresses in the calling thread");
+            }
+            ImGui::Checkbox("Shared Dictionary", &shared_dictionary);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Train a zstd dictionary on a sample of the selected files and measure\n"
+                                  "the others with it");
+            }
+            takes_dictionary = true;
+        }
+#endif
+
+        bool streamable = compressors_[selected_compressor]->supportsStreaming();
+#ifdef DCA_HAVE_LZ4
+        static const char* const lz4_formats[] = {"Frame", "Raw Block"};
+        static const char* const lz4_block_sizes[] = {"64 KB", "256 KB", "1 MB", "4 MB"};
+        auto* lz4 = dynamic_cast<Lz4Compressor*>(compressors_[selected_compressor].get());
+        if (lz4) {
+            ImGui::Combo("LZ4 Format", &lz4_format, lz4_formats, 2);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Frame: the .lz4 container with checksum, streamable.\n"
+                                  "Raw Block: one block behind a 4-byte size, inputs under 2 GB");
+            }
+            if (compression_level < Lz4Compressor::kMinHighCompressionLevel) {
+                ImGui::SliderInt("Acceleration", &lz4_acceleration, 1, 64);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Fast levels only: skip more match candidates for speed at the cost of ratio");
+                }
+            }
+            if (lz4_format == 0) {
+                ImGui::Checkbox("Independent Blocks", &lz4_independent);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Blocks do not reference earlier blocks: worse ratio, less decoder memory");
+                }
+                ImGui::Combo("LZ4 Block Size", &lz4_block_size_index, lz4_block_sizes, 4);
+            }
+            // Options are applied at start, so follow the pending format here
+            streamable = lz4_format == 0;
+        }
+#endif
+
+#ifdef DCA_HAVE_XZ
+        auto* xz = dynamic_cast<XzCompressor*>(compressors_[selected_compressor].get());
+        if (xz) {
+            ImGui::Checkbox("Extreme (xz -e)", &xz_extreme);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Slower match finding for a slightly better ratio; memory is unchanged");
+            }
+            ImGui::Checkbox("Custom Dictionary", &xz_custom_dictionary);
+            if (xz_custom_dictionary) {
+                ImGui::SliderInt("Dictionary (log2 bytes)", &xz_dictionary_log, 12, 30);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Encoder memory is roughly 10x the dictionary; the decoder needs about 1x");
+                }
+            }
+            ImGui::SliderInt("Xz Threads", &xz_threads, 0, static_cast<int>(ThreadPool::defaultThreadCount()) * 2);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("liblzma's multithreaded block encoder; 0 uses the single-threaded encoder");
+            }
+        }
+#endif
+
+        auto* archive = dynamic_cast<ArchiveCompressor*>(compressors_[selected_compressor].get());
+        if (archive) {
+            static const char* const archive_layouts[] = {"Single Stream", "Indexed Frames"};
+            ImGui::Combo("Archive Layout", &archive_layout, archive_layouts, 2);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Single Stream: one gzip stream over all members, best ratio.\n"
+                                  "Indexed Frames: independent frames and a central directory, so one\n"
+                                  "member can be extracted without inflating the rest.");
+            }
+            if (archive_layout == 1) {
+                static const char* const frame_sizes[] = {"Per Member", "256 KB", "1 MB", "4 MB"};
+                ImGui::Combo("Frame Size", &archive_frame_index, frame_sizes, 4);
+                ImGui::SliderInt("Frame Threads", &archive_threads, 1,
+                                 static_cast<int>(ThreadPool::defaultThreadCount()) * 2);
+            }
+        }
+
+        if (streamable) {
+            ImGui::Checkbox("Streaming (bounded memory)", &streaming);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Compress and verify in fixed-size chunks via a temp file so memory\n"
+                                  "stays constant. Files of 1 GB or more always stream.");
+            }
+        }
+
+        ImGui::Checkbox("Result Cache", &use_cache);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Reuse the rows of files analyzed before with the same content and\n"
+                              "settings, and keep new rows on disk for the next run");
+        }
+
+        ImGui::SliderInt("Warmup Runs", &warmup_runs, 0, 10);
+        ImGui::SliderInt("Repetitions", &repetitions, 1, 50);
+        ImGui::SliderFloat("Target CI (%)", &target_ci_percent, 0.0f, 10.0f, "%.1f");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("If non-zero, keep repeating (up to 100 runs) until the 95%% confidence\n"
+                              "interval of mean throughput is within this percentage of the mean");
+        }
+
+        const char* entropy_windows[] = {"4 KB", "16 KB", "64 KB", "256 KB", "1 MB"};
+        ImGui::Combo("Entropy Window", &entropy_window_index, entropy_windows, 5);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Granularity of the entropy profile shown for the selected result");
+        }
+
+        if (!archive_mode && !selector) {
+            const char* estimate_modes[] = {"Full run", "Estimate only", "Estimate and verify"};
+            ImGui::Combo("Estimation", &estimate_mode, estimate_modes, 3);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Estimate ratio and speeds by compressing a stratified sample of 128 KB\n"
+                                  "blocks; verifying also runs in full and reports the estimate's error");
+            }
+            if (estimate_mode != 0 || skip_incompressible) {
+                ImGui::SliderInt("Sample Blocks", &sample_blocks, 2, 256);
+            }
+            ImGui::Checkbox("Skip Incompressible", &skip_incompressible);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Estimate first and skip the full run for files whose estimated ratio\n"
+                                  "is at least the threshold even at the low end of its 95%% interval");
+            }
+            if (skip_incompressible) {
+                ImGui::SameLine();
+                ImGui::SliderFloat("Threshold", &skip_ratio, 0.5f, 1.0f, "%.2f");
+            }
+        }
+
+        ImGui::SliderInt("Worker Threads", &worker_threads, 1,
+                         static_cast<int>(ThreadPool::defaultThreadCount()) * 2);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Files are analyzed concurrently, largest first");
+        }
+
+        bool processing = job_ && !job_->finished();
+        if (ImGui::Button("Start Analysis") && !selected_files_.empty() && !processing) {
+            // The training files are held out of the measured set; training
+            // itself is the job's first stage, so it can be watched and cancelled
+            std::vector<std::filesystem::path> measured_files = selected_files_;
+            std::vector<std::filesystem::path> training_files;
+            bool train_dictionary = shared_dictionary && takes_dictionary;
+            DictionaryTrainer::Options trainer_options;
+            if (train_dictionary) {
+                trainer_options.zstd_format = !gzip;
+                trainer_options.max_size = gzip ? 32 * 1024 : 110 * 1024;
+                try {
+                    auto split = DictionaryTrainer::splitFiles(selected_files_, trainer_options.max_samples);
+                    training_files = std::move(split.training);
+                    measured_files = std::move(split.measured);
+                } catch (const std::exception& e) {
+                    showError(e.what());
+                    return;
+                }
+            }
+#ifdef DCA_HAVE_ZSTD
+            if (zstd) {
+                ZstdCompressor::Options options;
+                options.long_window_log = zstd_long ? zstd_window_log : 0;
+                options.workers = static_cast<unsigned>(zstd_workers);
+                try {
+                    zstd->setOptions(options);
+                } catch (const std::exception& e) {
+                    showError(e.what());
+                    return;
+                }
+            }
+#endif
+#ifdef DCA_HAVE_LZ4
+            if (lz4) {
+                Lz4Compressor::Options options;
+                options.format = lz4_format == 0 ? Lz4Compressor::Format::Frame : Lz4Compressor::Format::Block;
+                options.acceleration = lz4_acceleration;
+                options.independent_blocks = lz4_independent;
+                options.block_size = size_t(64 * 1024) << (2 * lz4_block_size_index);
+                lz4->setOptions(options);
+            }
+#endif
+#ifdef DCA_HAVE_XZ
+            if (xz) {
+                XzCompressor::Options options;
+                options.extreme = xz_extreme;
+                options.dictionary_size = xz_custom_dictionary ? UINT32_C(1) << xz_dictionary_log : 0;
+                options.threads = static_cast<unsigned>(xz_threads);
+                xz->setOptions(options);
+            }
+#endif
+            if (archive) {
+                ArchiveCompressor::Options options;
+                options.layout = archive_layout == 1 ? ArchiveCompressor::Layout::Indexed
+                                                     : ArchiveCompressor::Layout::Stream;
+                options.frame_size = archive_frame_index == 0 ? 0 : size_t(64 * 1024) << (2 * archive_frame_index);
+                options.threads = archive_layout == 1 ? static_cast<unsigned>(archive_threads) : 1;
+                archive->setOptions(options);
+            }
+            if (selector) {
+                AutoCompressor::Options options;
+                options.min_throughput = auto_min_speed;
+                options.max_time_ms = auto_time_limit ? auto_max_ms : 0.0;
+                selector->setOptions(options);
+                selector->resetComparison();
+            }
+            if (use_cache && !cache_) {
+                try {
+                    cache_ = std::make_unique<ResultCache>(ResultCache::defaultDirectory());
+                } catch (const std::exception& e) {
+                    showError(e.what());
+                    return;
+                }
+            }
+            if (cache_) {
+                cache_->resetStats();
+            }
+            if (gzip) {
+                GzipCompressor::Options options;
+                options.parallel = gzip_parallel;
+                options.block_size = static_cast<size_t>(gzip_block_kb) * 1024;
+                options.threads = static_cast<unsigned>(gzip_block_threads);
+                gzip->setOptions(options);
+            }
+            AnalysisOptions options;
+            options.streaming = streaming;
+            options.benchmark.warmup_runs = static_cast<unsigned>(warmup_runs);
+            options.benchmark.repetitions = static_cast<unsigned>(repetitions);
+            options.benchmark.target_ci = target_ci_percent / 100.0;
+            options.entropy_window = size_t(4 * 1024) << (2 * entropy_window_index);
+            if (!selector) {
+                options.estimate = static_cast<AnalysisOptions::Estimate>(estimate_mode);
+                options.estimator.blocks = static_cast<size_t>(sample_blocks);
+                options.skip_ratio = skip_incompressible ? skip_ratio : 0.0;
+            }
+            options.cache = use_cache ? cache_.get() : nullptr;
+
+            AnalysisJob::Request request;
+            request.compressor = compressors_[selected_compressor].get();
+            request.files = measured_files;
+            request.levels = {compression_level};
+            request.threads = static_cast<unsigned>(worker_threads);
+            request.archive = archive_mode && archive;
+            request.options = options;
+            request.on_error = [this](const std::string& message) { showError(message); };
+            if (train_dictionary) {
+                Compressor* compressor = request.compressor;
+                request.prepare = [this, compressor, training_files, trainer_options,
+                                   measured = measured_files.size()](const JobProgress& progress) {
+                    DictionaryTrainer::Options checked = trainer_options;
+                    checked.checkpoint = [&progress]() { progress.throwIfCancelled(); };
+                    TrainedDictionary dictionary = DictionaryTrainer::trainFromFiles(training_files, checked);
+                    if (auto* gzip_codec = dynamic_cast<GzipCompressor*>(compressor)) {
+                        GzipCompressor::Options options = gzip_codec->getOptions();
+                        options.dictionary = dictionary.data;
+                        gzip_codec->setOptions(options);
+                    }
+#ifdef DCA_HAVE_ZSTD
+                    if (auto* zstd_codec = dynamic_cast<ZstdCompressor*>(compressor)) {
+                        ZstdCompressor::Options options = zstd_codec->getOptions();
+                        options.dictionary = dictionary.data;
+                        zstd_codec->setOptions(options);
+                    }
+#endif
+                    char summary[160];
+                    std::snprintf(summary, sizeof(summary),
+                                  "Dictionary of %.2f KB (%s) from %zu samples in %.2f ms; %zu files held out to measure",
+                                  dictionary.size() / 1024.0, dictionary.method.c_str(), dictionary.samples,
+                                  std::chrono::duration<double, std::milli>(dictionary.build_time).count(), measured);
+                    showSuccess(summary);
+                };
+            }
+            job_.reset();
+            displayed_results_.clear();
+            selected_result_ = SIZE_MAX;
+            job_ = std::make_unique<AnalysisJob>(std::move(request));
+        }
+    }
+}
+
+void MainWindow::renderProgress() {
+    if (!job_) {
+        return;
+    }
+    const JobProgress& progress = job_->progress();
+    bool finished = job_->finished();
+
+    // Completed input, ETA at the average rate so far
+    char overlay[128];
+    double done_mb = progress.processedBytes() / (1024.0 * 1024.0);
+    double total_mb = progress.totalBytes() / (1024.0 * 1024.0);
+    double eta = progress.etaSeconds();
+    if (progress.preparing()) {
+        std::snprintf(overlay, sizeof(overlay), "Training dictionary... %.1f s",
+                      std::chrono::duration<double>(progress.elapsed()).count());
+    } else if (finished) {
+        std::snprintf(overlay, sizeof(overlay), "%.1f / %.1f MB, %s in %.1f s", done_mb, total_mb,
+                      job_->cancelled() ? "cancelled" : "done",
+                      std::chrono::duration<double>(progress.elapsed()).count());
+    } else if (eta >= 0.0) {
+        std::snprintf(overlay, sizeof(overlay), "%.1f / %.1f MB, %d:%02d left", done_mb, total_mb,
+                      static_cast<int>(eta) / 60, static_cast<int>(eta) % 60);
+    } else {
+        std::snprintf(overlay, sizeof(overlay), "%.1f / %.1f MB", done_mb, total_mb);
+    }
+    ImGui::ProgressBar(static_cast<float>(progress.fraction()), ImVec2(-120.0f, 0.0f), overlay);
+    if (!finished) {
+        ImGui::SameLine();
+        if (ImGui::Button(job_->cancelled() ? "Cancelling..." : "Cancel")) {
+            job_->cancel();
         }
-        if (is_processing_) {
-            ImGui::SameLine();
-            ImGui::Text("Processing...");
+    }
+
+    // One status per (file, level) job; the GUI runs one level at a time
+    size_t counts[6] = {};
+    for (size_t i = 0; i < progress.jobCount(); ++i) {
+        ++counts[static_cast<size_t>(progress.status(i))];
+    }
+    if (ImGui::TreeNode("File Status")) {
+        ImGui::Text("%zu done, %zu cached, %zu running, %zu pending, %zu failed, %zu cancelled",
+                    counts[size_t(JobProgress::Status::Done)], counts[size_t(JobProgress::Status::Cached)],
+                    counts[size_t(JobProgress::Status::Running)], counts[size_t(JobProgress::Status::Pending)],
+                    counts[size_t(JobProgress::Status::Failed)], counts[size_t(JobProgress::Status::Cancelled)]);
+        const auto& files = job_->request().files;
+        ImGui::BeginChild("FileStatus", ImVec2(0, 160), true);
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(progress.jobCount()));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                // Archive runs have one job per level instead of per file
+                std::string label = job_->request().archive
+                    ? "Archive (Level " + std::to_string(job_->request().levels[i]) + ")"
+                    : files[i].filename().string();
+                ImGui::Text("%-10s %s", JobProgress::statusName(progress.status(i)), label.c_str());
+            }
         }
+        ImGui::EndChild();
+        ImGui::TreePop();
     }
 }
 
 void MainWindow::renderResults() {
     if (ImGui::CollapsingHeader("Results", ImGuiTreeNodeFlags_DefaultOpen)) {
-        if (results_.empty()) {
+        // Published rows never change, so only the new ones are copied
+        if (job_) {
+            for (size_t i = displayed_results_.size(), count = job_->resultCount(); i < count; ++i) {
+                displayed_results_.push_back(job_->result(i));
+            }
+        }
+        if (displayed_results_.empty()) {
             ImGui::Text("No results available. Run analysis first.");
             return;
         }
@@ -176,7 +604,7 @@ void MainWindow::renderResults() {
             size_t total_original_size = 0;
             size_t total_compressed_size = 0;
             
-            for (const auto& result : results_) {
+            for (const auto& result : displayed_results_) {
                 avg_ratio += result.ratio;
                 avg_entropy += result.entropy;
                 avg_comp_time_ms += result.compression_time_us / 1000.0;
@@ -186,7 +614,7 @@ void MainWindow::renderResults() {
                 total_original_size += result.original_size;
                 total_compressed_size += result.compressed_size;
             }
-            size_t count = results_.size();
+            size_t count = displayed_results_.size();
             avg_ratio /= count;
             avg_entropy /= count;
             avg_comp_time_ms /= count;
@@ -205,43 +633,173 @@ void MainWindow::renderResults() {
             ImGui::Text("Total Space Saved: %.2f KB (%.1f%%)", 
                 (total_original_size - total_compressed_size) / 1024.0,
                 (1.0 - static_cast<double>(total_compressed_size) / total_original_size) * 100.0);
+            double estimate_error = 0.0;
+            size_t verified = 0;
+            for (const auto& result : displayed_results_) {
+                if (Analyzer::hasEstimateError(result)) {
+                    estimate_error += std::abs(Analyzer::estimateError(result));
+                    verified++;
+                }
+            }
+            if (verified > 0) {
+                ImGui::Text("Mean Estimate Error: %.2f%% over %zu files", estimate_error / verified, verified);
+            }
+            if (cache_) {
+                ResultCache::Stats cache_stats = cache_->stats();
+                if (cache_stats.hits + cache_stats.misses > 0) {
+                    ImGui::Text("Result Cache: %llu hits, %llu misses (%zu rows stored)",
+                                static_cast<unsigned long long>(cache_stats.hits),
+                                static_cast<unsigned long long>(cache_stats.misses), cache_stats.entries);
+                }
+            }
+            for (const auto& candidate : compressors_) {
+                auto* selector = dynamic_cast<AutoCompressor*>(candidate.get());
+                if (!selector) continue;
+                auto totals = selector->comparison();
+                if (totals.empty() || totals.front().inputs == 0) continue;
+                ImGui::Text("Per-file choice vs. fixed settings (estimated from trials):");
+                if (ImGui::BeginTable("PolicyComparison", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                    ImGui::TableSetupColumn("Setting");
+                    ImGui::TableSetupColumn("Ratio");
+                    ImGui::TableSetupColumn("Compressed (KB)");
+                    ImGui::TableSetupColumn("Compression (ms)");
+                    ImGui::TableSetupColumn("Files in Budget");
+                    ImGui::TableHeadersRow();
+                    for (const auto& setting : totals) {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%s", setting.label.c_str());
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.4f", setting.original_bytes ? setting.compressed_bytes / setting.original_bytes : 0.0);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.2f", setting.compressed_bytes / 1024.0);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.2f", setting.compression_ms);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%zu / %zu", setting.within_budget, setting.inputs);
+                    }
+                    ImGui::EndTable();
+                }
+            }
+            ImGui::TreePop();
+        }
+        // Entropy strip chart of the row selected in the table below
+        if (selected_result_ >= displayed_results_.size()) {
+            selected_result_ = SIZE_MAX;
+        }
+        if (ImGui::TreeNodeEx("Entropy Profile", ImGuiTreeNodeFlags_DefaultOpen)) {
+            if (selected_result_ == SIZE_MAX) {
+                ImGui::TextDisabled("Select a result to see its entropy per region.");
+            } else {
+                const AnalysisResult& result = displayed_results_[selected_result_];
+                char overlay[160];
+                std::snprintf(overlay, sizeof(overlay), "%s: order-0 %.2f, order-1 %.2f, order-2 %.2f bits/byte",
+                              result.filename.c_str(), result.entropy, result.entropy_order1, result.entropy_order2);
+                ImGui::PlotLines("##EntropyProfile", result.entropy_profile.data(),
+                                 static_cast<int>(result.entropy_profile.size()), 0, overlay, 0.0f, 8.0f,
+                                 ImVec2(-1.0f, 80.0f));
+                ImGui::Text("%.1f%% of the data is in windows at or above %.1f bits/byte (likely stored better than deflated)",
+                            result.high_entropy_fraction * 100.0, EntropyProfile::kStoredThreshold);
+            }
             ImGui::TreePop();
         }
         // Detailed results table
-        if (ImGui::BeginTable("ResultsTable", 10, ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY)) {
+        if (ImGui::BeginTable("ResultsTable", 18, ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY)) {
             ImGui::TableSetupColumn("File");
             ImGui::TableSetupColumn("Type");
             ImGui::TableSetupColumn("Algorithm");
             ImGui::TableSetupColumn("Ratio");
             ImGui::TableSetupColumn("Entropy");
+            ImGui::TableSetupColumn("Order-1 / Order-2");
+            ImGui::TableSetupColumn("High-Entropy (%)");
             ImGui::TableSetupColumn("Original Size (KB)");
             ImGui::TableSetupColumn("Compressed Size (KB)");
             ImGui::TableSetupColumn("Compression Speed (MB/s)");
             ImGui::TableSetupColumn("Decompression Speed (MB/s)");
             ImGui::TableSetupColumn("Time (ms)");
+            ImGui::TableSetupColumn("Runs");
+            ImGui::TableSetupColumn("Setup (us)");
+            ImGui::TableSetupColumn("Comp Memory (KB)");
+            ImGui::TableSetupColumn("Decomp Memory (KB)");
+            ImGui::TableSetupColumn("Cost vs Single Stream (%)");
+            ImGui::TableSetupColumn("Estimate (95% CI)");
             ImGui::TableHeadersRow();
-            for (const auto& result : results_) {
+            for (size_t i = 0; i < displayed_results_.size(); ++i) {
+                const auto& result = displayed_results_[i];
                 ImGui::TableNextRow();
                 ImGui::TableNextColumn();
-                ImGui::Text("%s", result.filename.c_str());
+                ImGui::PushID(static_cast<int>(i));
+                if (ImGui::Selectable(result.filename.c_str(), selected_result_ == i, ImGuiSelectableFlags_SpanAllColumns)) {
+                    selected_result_ = i;
+                }
+                ImGui::PopID();
                 ImGui::TableNextColumn();
                 ImGui::Text("%s", result.file_type.c_str());
                 ImGui::TableNextColumn();
                 ImGui::Text("%s", result.algorithm.c_str());
+                if (!result.policy.empty() && ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("%s", result.policy.c_str());
+                }
                 ImGui::TableNextColumn();
                 ImGui::Text("%.2f", result.ratio);
                 ImGui::TableNextColumn();
                 ImGui::Text("%.2f", result.entropy);
                 ImGui::TableNextColumn();
+                ImGui::Text("%.2f / %.2f", result.entropy_order1, result.entropy_order2);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", result.high_entropy_fraction * 100.0);
+                ImGui::TableNextColumn();
                 ImGui::Text("%.2f", result.original_size / 1024.0);
                 ImGui::TableNextColumn();
                 ImGui::Text("%.2f", result.compressed_size / 1024.0);
                 ImGui::TableNextColumn();
-                ImGui::Text("%.2f", result.compression_throughput);
+                ImGui::Text("%.2f +/- %.2f", result.compression_throughput, result.compression_stats.stddev);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("min %.2f  mean %.2f  p95 %.2f", result.compression_stats.min,
+                                      result.compression_stats.mean, result.compression_stats.p95);
+                }
                 ImGui::TableNextColumn();
-                ImGui::Text("%.2f", result.decompression_throughput);
+                ImGui::Text("%.2f +/- %.2f", result.decompression_throughput, result.decompression_stats.stddev);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("min %.2f  mean %.2f  p95 %.2f", result.decompression_stats.min,
+                                      result.decompression_stats.mean, result.decompression_stats.p95);
+                }
                 ImGui::TableNextColumn();
                 ImGui::Text("%.3f", (result.compression_time_us + result.decompression_time_us) / 1000.0);
+                if (result.member_extraction_us > 0.0 && ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Extracting one member: %.3f ms", result.member_extraction_us / 1000.0);
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", result.compression_stats.samples);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f / %.1f", result.compression_setup_us, result.decompression_setup_us);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f + %.0f", result.compression_codec_memory / 1024.0,
+                            result.compression_buffer_memory / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f + %.0f", result.decompression_codec_memory / 1024.0,
+                            result.decompression_buffer_memory / 1024.0);
+                ImGui::TableNextColumn();
+                if (result.reference_ratio > 0.0) {
+                    ImGui::Text("%+.2f", Analyzer::ratioCost(result));
+                } else {
+                    ImGui::TextDisabled("-");
+                }
+                ImGui::TableNextColumn();
+                if (result.estimated_ratio > 0.0) {
+                    ImGui::Text("%.3f [%.3f-%.3f]%s", result.estimated_ratio, result.estimated_ratio_low,
+                                result.estimated_ratio_high, result.skipped ? " skipped" : "");
+                    if (ImGui::IsItemHovered()) {
+                        if (Analyzer::hasEstimateError(result)) {
+                            ImGui::SetTooltip("Sampled %.1f%% of the file; %+.2f%% off the full run",
+                                              result.sampled_fraction * 100.0, Analyzer::estimateError(result));
+                        } else {
+                            ImGui::SetTooltip("Sampled %.1f%% of the file", result.sampled_fraction * 100.0);
+                        }
+                    }
+                } else {
+                    ImGui::TextDisabled("-");
+                }
             }
             ImGui::EndTable();
         }
@@ -284,64 +842,6 @@ void MainWindow::openFileDialog() {
     }
 }
 
-void MainWindow::processFiles(int selected_compressor, int gzip_level, bool archive_mode) {
-    results_.clear();
-    
-    if (archive_mode && selected_compressor == 1) { // Archive mode
-        try {
-            std::vector<std::pair<std::string, std::vector<uint8_t>>> files;
-            size_t total_original_size = 0;
-            for (const auto& file_path : selected_files_) {
-                auto file_data = FileHandler::readFile(file_path);
-                total_original_size += file_data.size();
-                files.emplace_back(file_path.filename().string(), std::move(file_data));
-            }
-            
-            auto result = static_cast<ArchiveCompressor*>(compressors_[selected_compressor].get())
-                ->compress(files, gzip_level);
-            
-            CompressionResult ui_result;
-            ui_result.filename = "Archive (" + std::to_string(selected_files_.size()) + " files)";
-            ui_result.algorithm = compressors_[selected_compressor]->getName() + " (Level " + std::to_string(gzip_level) + ")";
-            ui_result.file_type = "Archive";
-            ui_result.ratio = result.compression_ratio;
-            ui_result.entropy = FileHandler::calculateEntropy(files[0].second); // Calculate entropy of first file
-            ui_result.compression_time_us = result.compression_time.count();
-            ui_result.decompression_time_us = result.decompression_time.count();
-            ui_result.compression_throughput = FileHandler::calculateThroughput(total_original_size, result.compression_time.count());
-            ui_result.decompression_throughput = FileHandler::calculateThroughput(total_original_size, result.decompression_time.count());
-            ui_result.original_size = total_original_size;
-            ui_result.compressed_size = static_cast<size_t>(total_original_size * result.compression_ratio);
-            results_.push_back(ui_result);
-        } catch (const std::exception& e) {
-            showError("Error processing archive: " + std::string(e.what()));
-        }
-    } else { // Individual file mode
-        for (const auto& file_path : selected_files_) {
-            try {
-                auto file_data = FileHandler::readFile(file_path);
-                auto result = compressors_[selected_compressor]->compress(file_data, gzip_level);
-                CompressionResult ui_result;
-                ui_result.filename = file_path.filename().string();
-                ui_result.algorithm = compressors_[selected_compressor]->getName() + 
-                                    (selected_compressor == 0 ? " (Level " + std::to_string(gzip_level) + ")" : "");
-                ui_result.file_type = FileHandler::detectFileType(file_data);
-                ui_result.ratio = result.compression_ratio;
-                ui_result.entropy = FileHandler::calculateEntropy(file_data);
-                ui_result.compression_time_us = result.compression_time.count();
-                ui_result.decompression_time_us = result.decompression_time.count();
-                ui_result.compression_throughput = FileHandler::calculateThroughput(file_data.size(), result.compression_time.count());
-                ui_result.decompression_throughput = FileHandler::calculateThroughput(file_data.size(), result.decompression_time.count());
-                ui_result.original_size = file_data.size();
-                ui_result.compressed_size = static_cast<size_t>(file_data.size() * result.compression_ratio);
-                results_.push_back(ui_result);
-            } catch (const std::exception& e) {
-                showError("Error processing file " + file_path.string() + ": " + e.what());
-            }
-        }
-    }
-}
-
 void MainWindow::exportResults(const std::string& default_filename, bool as_json) {
     const char* filters[] = { as_json ? "*.json" : "*.csv" };
     const char* default_path = default_filename.c_str();
@@ -354,24 +854,10 @@ void MainWindow::exportResults(const std::string& default_filename, bool as_json
     );
     if (save_path) {
         try {
-            std::vector<std::string> headers = {
-                "File", "Type", "Algorithm", "Ratio", "Entropy", "Original Size (KB)", "Compressed Size (KB)",
-                "Compression Speed (MB/s)", "Decompression Speed (MB/s)", "Time (ms)"
-            };
+            std::vector<std::string> headers = Analyzer::resultHeaders();
             std::vector<std::vector<std::string>> rows;
-            for (const auto& result : results_) {
-                rows.push_back({
-                    result.filename,
-                    result.file_type,
-                    result.algorithm,
-                    std::to_string(result.ratio),
-                    std::to_string(result.entropy),
-                    std::to_string(result.original_size / 1024.0),
-                    std::to_string(result.compressed_size / 1024.0),
-                    std::to_string(result.compression_throughput),
-                    std::to_string(result.decompression_throughput),
-                    std::to_string((result.compression_time_us + result.decompression_time_us) / 1000.0)
-                });
+            for (const auto& result : displayed_results_) {
+                rows.push_back(Analyzer::resultRow(result));
             }
             if (as_json) {
                 FileHandler::exportToJSON(save_path, headers, rows);
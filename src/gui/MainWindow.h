@@ -7,8 +7,12 @@
 #include <GLFW/glfw3.h>
 #include "imgui.h"
 #include "../compression/Compressor.h"
+#include "../analysis/AnalysisJob.h"
+#include "../analysis/Analyzer.h"
 #include "tinyfiledialogs.h"
 
+class ResultCache;
+
 class MainWindow {
 public:
     MainWindow();
@@ -30,39 +34,31 @@ private:
     void render();
     void renderFileSelection();
     void renderCompressionOptions();
+    void renderProgress();
     void renderResults();
     void renderExportOptions();
     
     // File handling
     void openFileDialog();
-    void processFiles(int selected_compressor, int gzip_level, bool archive_mode);
     
     // Compression handling
     std::vector<std::unique_ptr<Compressor>> compressors_;
     void initCompressors();
     
-    // Results storage
-    struct CompressionResult {
-        std::string filename;
-        std::string algorithm;
-        std::string file_type;
-        double ratio;
-        double entropy;
-        long long compression_time_us;
-        long long decompression_time_us;
-        double compression_throughput;  // MB/s
-        double decompression_throughput;  // MB/s
-        size_t memory_used;
-        size_t original_size;    // Size in bytes
-        size_t compressed_size;  // Size in bytes
-    };
-    std::vector<CompressionResult> results_;
+    // Opened in ResultCache::defaultDirectory() the first time it is enabled
+    std::unique_ptr<ResultCache> cache_;
+
+    // The current or last run. Declared after what it uses, so it is
+    // cancelled and joined before they go away. Each frame copies the rows
+    // it published since the last one into displayed_results_.
+    std::unique_ptr<AnalysisJob> job_;
+    std::vector<AnalysisResult> displayed_results_;
+    size_t selected_result_ = SIZE_MAX;  // Row whose entropy profile is charted
     
     // UI state
     std::vector<std::filesystem::path> selected_files_;
     bool show_compression_options_ = true;
     bool show_results_ = false;
-    bool is_processing_ = false;
     
     // Export options
     void exportResults(const std::string& default_filename, bool as_json);
@@ -1,8 +1,16 @@
 #include "gui/MainWindow.h"
+#include "cli/BatchRunner.h"
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 int main(int argc, char* argv[]) {
+    // "--batch" runs the headless driver without touching GLFW/OpenGL
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        return BatchRunner::runCommandLine(std::vector<std::string>(argv + 2, argv + argc),
+                                           std::string(argv[0]) + " --batch");
+    }
+
     try {
         MainWindow window;
         window.run();
@@ -11,4 +19,4 @@ int main(int argc, char* argv[]) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
         return 1;
     }
-} 
\ No newline at end of file
+}
\ No newline at end of file
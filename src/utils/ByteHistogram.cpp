@@ -0,0 +1,169 @@
+#include "ByteHistogram.h"
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define DCA_HISTOGRAM_AVX2 1
+#endif
+
+namespace {
+
+// One table per byte lane of a 64-bit word, so consecutive equal bytes bump
+// different counters instead of waiting on each other's store. 8 KiB of
+// 32-bit counters stays in L1.
+constexpr size_t kTables = 8;
+using Tables = uint32_t[kTables][256];
+
+// Tables are flushed into the 64-bit totals at least this often, keeping
+// every 32-bit counter from wrapping
+constexpr size_t kFlushBytes = size_t(1) << 31;
+
+// Below this the table setup and merge cost more than they save
+constexpr size_t kSmallInput = 1024;
+
+// Smallest slice worth a thread of its own
+constexpr size_t kMinChunk = 16 * 1024 * 1024;
+
+inline void countWord(uint64_t word, Tables& tables) {
+    tables[0][word & 0xff]++;
+    tables[1][(word >> 8) & 0xff]++;
+    tables[2][(word >> 16) & 0xff]++;
+    tables[3][(word >> 24) & 0xff]++;
+    tables[4][(word >> 32) & 0xff]++;
+    tables[5][(word >> 40) & 0xff]++;
+    tables[6][(word >> 48) & 0xff]++;
+    tables[7][word >> 56]++;
+}
+
+inline uint64_t loadWord(const uint8_t* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+void countUnrolled(const uint8_t* data, size_t size, Tables& tables) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        countWord(loadWord(data + i), tables);
+        countWord(loadWord(data + i + 8), tables);
+    }
+    for (; i < size; ++i) {
+        tables[0][data[i]]++;
+    }
+}
+
+#ifdef DCA_HISTOGRAM_AVX2
+// Same scatter as countUnrolled, but each 32-byte block is first compared
+// against its first byte; uniform blocks (zero pages, padding, sparse files)
+// then cost one add instead of 32
+__attribute__((target("avx2")))
+void countAvx2(const uint8_t* data, size_t size, Tables& tables) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i first = _mm256_set1_epi8(static_cast<char>(data[i]));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, first)) == -1) {
+            tables[0][data[i]] += 32;
+            continue;
+        }
+        countWord(loadWord(data + i), tables);
+        countWord(loadWord(data + i + 8), tables);
+        countWord(loadWord(data + i + 16), tables);
+        countWord(loadWord(data + i + 24), tables);
+    }
+    // The compiler does not add this before a tail call; without it every
+    // later SSE or libm call on the thread pays the AVX-SSE transition
+    _mm256_zeroupper();
+    countUnrolled(data + i, size - i, tables);
+}
+#endif
+
+struct Kernel {
+    void (*count)(const uint8_t*, size_t, Tables&);
+    const char* name;
+};
+
+const Kernel& selectKernel() {
+    static const Kernel kernel = []() -> Kernel {
+#ifdef DCA_HISTOGRAM_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+            return {countAvx2, "avx2"};
+        }
+#endif
+        return {countUnrolled, "unrolled"};
+    }();
+    return kernel;
+}
+
+} // namespace
+
+void ByteHistogram::accumulate(ByteView data, Counts& counts) {
+    if (data.size() < kSmallInput) {
+        for (uint8_t byte : data) {
+            counts[byte]++;
+        }
+        return;
+    }
+
+    const Kernel& kernel = selectKernel();
+    Tables tables;
+    for (size_t offset = 0; offset < data.size(); offset += kFlushBytes) {
+        std::memset(tables, 0, sizeof(tables));
+        kernel.count(data.data() + offset, std::min(kFlushBytes, data.size() - offset), tables);
+        for (size_t byte = 0; byte < 256; ++byte) {
+            uint64_t total = 0;
+            for (size_t t = 0; t < kTables; ++t) {
+                total += tables[t][byte];
+            }
+            counts[byte] += total;
+        }
+    }
+}
+
+ByteHistogram::Counts ByteHistogram::count(ByteView data, unsigned max_threads) {
+    Counts counts{};
+    size_t threads = max_threads ? max_threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, data.size() / kMinChunk);
+    if (data.size() < kParallelThreshold || threads <= 1) {
+        accumulate(data, counts);
+        return counts;
+    }
+
+    size_t chunk = (data.size() + threads - 1) / threads;
+    std::vector<Counts> partial(threads, Counts{});
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    size_t inline_from = 1;
+    for (; inline_from < threads; ++inline_from) {
+        size_t offset = inline_from * chunk;
+        ByteView slice = data.subview(offset, std::min(chunk, data.size() - offset));
+        try {
+            workers.emplace_back([slice, &partial, inline_from]() { accumulate(slice, partial[inline_from]); });
+        } catch (const std::system_error&) {
+            break;  // Out of threads; the rest is counted here
+        }
+    }
+    accumulate(data.subview(0, chunk), partial[0]);
+    for (size_t i = inline_from; i < threads; ++i) {
+        size_t offset = i * chunk;
+        accumulate(data.subview(offset, std::min(chunk, data.size() - offset)), partial[i]);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const Counts& part : partial) {
+        for (size_t byte = 0; byte < 256; ++byte) {
+            counts[byte] += part[byte];
+        }
+    }
+    return counts;
+}
+
+const char* ByteHistogram::kernelName() {
+    return selectKernel().name;
+}
\ No newline at end of file
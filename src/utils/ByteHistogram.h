@@ -0,0 +1,26 @@
+#pragma once
+
+#include "ByteView.h"
+#include <array>
+#include <cstdint>
+
+// Byte frequency counting at close to memory bandwidth. Counts are spread
+// over several interleaved tables so runs of one byte value do not serialize
+// on a single counter, and the kernel is picked at runtime for the CPU.
+class ByteHistogram {
+public:
+    using Counts = std::array<uint64_t, 256>;
+
+    // Inputs at least this large are split into chunks counted on separate threads
+    static constexpr size_t kParallelThreshold = 64 * 1024 * 1024;
+
+    // Adds the byte counts of data to counts, on the calling thread
+    static void accumulate(ByteView data, Counts& counts);
+
+    // Byte counts of data. Large inputs are counted on up to max_threads
+    // threads (0 = hardware concurrency) and the partial tables merged.
+    static Counts count(ByteView data, unsigned max_threads = 0);
+
+    // Name of the kernel accumulate() dispatches to, e.g. "avx2"
+    static const char* kernelName();
+};
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Non-owning, read-only view of contiguous bytes (a C++17 stand-in for
+// std::span<const uint8_t>). Vectors convert implicitly, so call sites that
+// already hold a std::vector keep working unchanged.
+class ByteView {
+public:
+    ByteView() = default;
+    ByteView(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+    ByteView(const std::vector<uint8_t>& bytes) : data_(bytes.data()), size_(bytes.size()) {}
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const uint8_t* begin() const { return data_; }
+    const uint8_t* end() const { return data_ + size_; }
+    const uint8_t& operator[](size_t index) const { return data_[index]; }
+
+    ByteView subview(size_t offset, size_t length) const {
+        return ByteView(data_ + offset, length);
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Writable counterpart of ByteView for caller-owned output buffers
+class MutableByteView {
+public:
+    MutableByteView() = default;
+    MutableByteView(uint8_t* data, size_t size) : data_(data), size_(size) {}
+    MutableByteView(std::vector<uint8_t>& bytes) : data_(bytes.data()), size_(bytes.size()) {}
+
+    uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    uint8_t* begin() const { return data_; }
+    uint8_t* end() const { return data_ + size_; }
+    uint8_t& operator[](size_t index) const { return data_[index]; }
+
+    MutableByteView subview(size_t offset, size_t length) const {
+        return MutableByteView(data_ + offset, length);
+    }
+    operator ByteView() const { return ByteView(data_, size_); }
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "ContentChunker.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Fixed random value per byte; boundaries must not change between builds
+constexpr std::array<uint64_t, 256> makeGearTable() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x4443414443444300ULL;
+    for (auto& value : table) {
+        value = splitmix64(state);
+    }
+    return table;
+}
+
+constexpr std::array<uint64_t, 256> kGear = makeGearTable();
+
+// The top bits of the gear hash depend on the last 64 bytes
+uint64_t topBits(unsigned bits) {
+    return bits >= 64 ? ~0ULL : ~0ULL << (64 - bits);
+}
+
+uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    return value ^ (value >> 33);
+}
+
+uint64_t rotl(uint64_t value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+} // namespace
+
+ContentChunker::ContentChunker(const Options& options)
+    : min_size_(options.min_size), max_size_(options.max_size) {
+    if (options.min_size < 64 || options.min_size > options.avg_size || options.avg_size > options.max_size) {
+        throw std::invalid_argument("Chunk sizes must satisfy 64 <= min <= avg <= max");
+    }
+    unsigned bits = 0;
+    while ((size_t(2) << bits) <= options.avg_size) {
+        ++bits;
+    }
+    avg_size_ = size_t(1) << bits;
+    // Normalization level 2, as in the FastCDC paper
+    mask_small_ = topBits(bits + 2);
+    mask_large_ = topBits(bits > 2 ? bits - 2 : 1);
+}
+
+size_t ContentChunker::next(ByteView data) const {
+    size_t size = data.size();
+    if (size <= min_size_) {
+        return size;
+    }
+    size_t limit = std::min(size, max_size_);
+    size_t normal = std::min(avg_size_, limit);
+    const uint8_t* bytes = data.data();
+    uint64_t hash = 0;
+    size_t i = min_size_;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + kGear[bytes[i]];
+        if (!(hash & mask_small_)) {
+            return i + 1;
+        }
+    }
+    for (; i < limit; ++i) {
+        hash = (hash << 1) + kGear[bytes[i]];
+        if (!(hash & mask_large_)) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+ChunkFingerprint ChunkFingerprint::of(ByteView data) {
+    uint64_t a = 0x243F6A8885A308D3ULL ^ data.size();
+    uint64_t b = 0x13198A2E03707344ULL + data.size();
+    const uint8_t* bytes = data.data();
+    size_t size = data.size();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        a = rotl(a ^ (word * 0x87C37B91114253D5ULL), 31) * 0x4CF5AD432745937FULL;
+        b = rotl(b + (word * 0x9E3779B97F4A7C15ULL), 27) * 0xC2B2AE3D27D4EB4FULL + a;
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + i, size - i);
+        a = rotl(a ^ (word * 0x87C37B91114253D5ULL), 31) * 0x4CF5AD432745937FULL;
+        b = rotl(b + (word * 0x9E3779B97F4A7C15ULL), 27) * 0xC2B2AE3D27D4EB4FULL + a;
+    }
+    ChunkFingerprint fingerprint;
+    fingerprint.high = mix(a + b);
+    fingerprint.low = mix(b ^ rotl(a, 17));
+    return fingerprint;
+}
\ No newline at end of file
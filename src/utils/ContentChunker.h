@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ByteView.h"
+#include <cstddef>
+#include <cstdint>
+
+// Content-defined chunking in the style of FastCDC: a gear rolling hash over
+// the bytes after min_size, cut where its top bits are zero. A stricter mask
+// before avg_size and a looser one after (normalized chunking) keep sizes
+// close to the average. Boundaries depend only on nearby content, so an
+// insertion shifts the chunks around it and leaves the rest identical.
+class ContentChunker {
+public:
+    struct Options {
+        size_t min_size = 2 * 1024;
+        size_t avg_size = 8 * 1024;   // Rounded down to a power of two
+        size_t max_size = 64 * 1024;
+    };
+
+    // Throws std::invalid_argument unless 64 <= min_size <= avg_size <= max_size
+    explicit ContentChunker(const Options& options);
+
+    // Length of the chunk starting at data. Unless data is the end of the
+    // input, callers must pass at least maxSize() bytes when they have them,
+    // so that a cut is never made just because the buffer ran out.
+    size_t next(ByteView data) const;
+
+    size_t minSize() const { return min_size_; }
+    size_t avgSize() const { return avg_size_; }
+    size_t maxSize() const { return max_size_; }
+
+private:
+    size_t min_size_;
+    size_t avg_size_;
+    size_t max_size_;
+    uint64_t mask_small_;  // Used before avg_size: more bits, cuts less likely
+    uint64_t mask_large_;  // Used after: fewer bits, cuts more likely
+};
+
+// 128-bit chunk fingerprint. Not cryptographic; a collision between two
+// different chunks is about as likely as 2^-64 per pair compared.
+struct ChunkFingerprint {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool operator==(const ChunkFingerprint& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const ChunkFingerprint& other) const { return !(*this == other); }
+
+    // Hashes 8 bytes at a time, two independent lanes
+    static ChunkFingerprint of(ByteView data);
+};
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "ContentHash.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+uint64_t rotl(uint64_t value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+uint64_t load64(const uint8_t* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint64_t round(uint64_t lane, uint64_t input) {
+    return rotl(lane + input * kPrime2, 31) * kPrime1;
+}
+
+uint64_t merge(uint64_t hash, uint64_t lane) {
+    return (hash ^ round(0, lane)) * kPrime1 + kPrime4;
+}
+
+uint64_t avalanche(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    return hash ^ (hash >> 32);
+}
+
+} // namespace
+
+std::string ContentDigest::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        text[15 - i] = digits[(high >> (4 * i)) & 0xF];
+        text[31 - i] = digits[(low >> (4 * i)) & 0xF];
+    }
+    return text;
+}
+
+ContentHasher::ContentHasher()
+    : lanes_{kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1} {}
+
+void ContentHasher::consumeStripes(const uint8_t* data, size_t stripes) {
+    // Locals, so the compiler keeps the lanes in registers across the loop
+    uint64_t a = lanes_[0], b = lanes_[1], c = lanes_[2], d = lanes_[3];
+    for (size_t i = 0; i < stripes; ++i, data += kStripeSize) {
+        a = round(a, load64(data));
+        b = round(b, load64(data + 8));
+        c = round(c, load64(data + 16));
+        d = round(d, load64(data + 24));
+    }
+    lanes_[0] = a;
+    lanes_[1] = b;
+    lanes_[2] = c;
+    lanes_[3] = d;
+}
+
+void ContentHasher::update(ByteView data) {
+    const uint8_t* bytes = data.data();
+    size_t size = data.size();
+    total_ += size;
+    if (pending_size_ > 0) {
+        size_t take = std::min(size, kStripeSize - pending_size_);
+        std::memcpy(pending_ + pending_size_, bytes, take);
+        pending_size_ += take;
+        bytes += take;
+        size -= take;
+        if (pending_size_ < kStripeSize) {
+            return;
+        }
+        consumeStripes(pending_, 1);
+        pending_size_ = 0;
+    }
+    size_t stripes = size / kStripeSize;
+    consumeStripes(bytes, stripes);
+    bytes += stripes * kStripeSize;
+    size -= stripes * kStripeSize;
+    std::memcpy(pending_, bytes, size);
+    pending_size_ = size;
+}
+
+ContentDigest ContentHasher::finish() const {
+    uint64_t hash = rotl(lanes_[0], 1) + rotl(lanes_[1], 7) + rotl(lanes_[2], 12) + rotl(lanes_[3], 18);
+    for (uint64_t lane : lanes_) {
+        hash = merge(hash, lane);
+    }
+    hash += total_;
+
+    // Tail: whole words, then the last few bytes one at a time
+    size_t i = 0;
+    for (; i + 8 <= pending_size_; i += 8) {
+        hash = rotl(hash ^ round(0, load64(pending_ + i)), 27) * kPrime1 + kPrime4;
+    }
+    for (; i < pending_size_; ++i) {
+        hash = rotl(hash ^ (pending_[i] * kPrime5), 11) * kPrime1;
+    }
+
+    // Two finalizations of the same state, one with the lanes folded in
+    // again, give the second 64 bits
+    ContentDigest digest;
+    digest.low = avalanche(hash);
+    digest.high = avalanche(hash ^ rotl(lanes_[0] ^ lanes_[2], 29) ^ (rotl(lanes_[1] ^ lanes_[3], 41) * kPrime3));
+    return digest;
+}
+
+ContentDigest ContentHasher::of(ByteView data) {
+    ContentHasher hasher;
+    hasher.update(data);
+    return hasher.finish();
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ByteView.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 128-bit digest of a whole input. Not cryptographic: it detects changed
+// content, it does not resist someone crafting collisions.
+struct ContentDigest {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool operator==(const ContentDigest& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const ContentDigest& other) const { return !(*this == other); }
+
+    // 32 lowercase hex digits
+    std::string hex() const;
+};
+
+// Streaming content hash in the style of xxHash64: input is consumed in
+// 32-byte stripes by four independent 64-bit lanes, so the multiplies of one
+// stripe overlap in the pipeline (and vectorize where the target has 64-bit
+// vector multiplies). Feeding the same bytes in any split gives the same
+// digest. Runs at several GB/s, far faster than any codec it is keyed for.
+class ContentHasher {
+public:
+    ContentHasher();
+
+    void update(ByteView data);
+    ContentDigest finish() const;
+
+    uint64_t size() const { return total_; }
+
+    static ContentDigest of(ByteView data);
+
+private:
+    static constexpr size_t kStripeSize = 32;
+
+    uint64_t lanes_[4];
+    uint8_t pending_[kStripeSize];
+    size_t pending_size_ = 0;
+    uint64_t total_ = 0;
+
+    void consumeStripes(const uint8_t* data, size_t stripes);
+};
\ No newline at end of file
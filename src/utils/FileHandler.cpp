@@ -1,8 +1,12 @@
 #include "FileHandler.h"
+#include "ByteHistogram.h"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <cmath>
+#include <atomic>
+#include <thread>
+#include <unistd.h>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -79,6 +83,14 @@ std::filesystem::path FileHandler::createOutputPath(const std::filesystem::path&
     return output_path;
 }
 
+std::filesystem::path FileHandler::createTempFilePath(const std::string& prefix) {
+    static std::atomic<uint64_t> counter{0};
+    std::ostringstream name;
+    name << prefix << "-" << getpid() << "-" << std::hash<std::thread::id>()(std::this_thread::get_id())
+         << "-" << counter++ << ".tmp";
+    return std::filesystem::temp_directory_path() / name.str();
+}
+
 void FileHandler::exportToCSV(const std::filesystem::path& output_path,
                              const std::vector<std::string>& headers,
                              const std::vector<std::vector<std::string>>& rows) {
@@ -131,7 +143,7 @@ void FileHandler::exportToJSON(const std::filesystem::path& output_path,
     file << std::setw(4) << j << std::endl;
 }
 
-std::string FileHandler::detectFileType(const std::vector<uint8_t>& data) {
+std::string FileHandler::detectFileType(ByteView data) {
     if (data.size() < 4) return "Unknown";
     
     // Check for common file signatures
@@ -156,19 +168,21 @@ std::string FileHandler::detectFileType(const std::vector<uint8_t>& data) {
     return "Binary";
 }
 
-double FileHandler::calculateEntropy(const std::vector<uint8_t>& data) {
-    if (data.empty()) return 0.0;
-    
-    // Count byte frequencies
-    std::map<uint8_t, size_t> frequencies;
-    for (uint8_t byte : data) {
-        frequencies[byte]++;
+double FileHandler::calculateEntropy(ByteView data) {
+    return calculateEntropy(ByteHistogram::count(data));
+}
+
+double FileHandler::calculateEntropy(const std::array<uint64_t, 256>& histogram) {
+    uint64_t total = 0;
+    for (uint64_t count : histogram) {
+        total += count;
     }
+    if (total == 0) return 0.0;
     
-    // Calculate entropy
     double entropy = 0.0;
-    double size = static_cast<double>(data.size());
-    for (const auto& [byte, count] : frequencies) {
+    double size = static_cast<double>(total);
+    for (uint64_t count : histogram) {
+        if (count == 0) continue;
         double probability = static_cast<double>(count) / size;
         entropy -= probability * std::log2(probability);
     }
@@ -179,4 +193,9 @@ double FileHandler::calculateEntropy(const std::vector<uint8_t>& data) {
 double FileHandler::calculateThroughput(size_t bytes, long long microseconds) {
     if (microseconds == 0) return 0.0;
     return (bytes * 1000000.0) / (microseconds * 1024.0 * 1024.0); // Convert to MB/s
-} 
\ No newline at end of file
+}
+
+double FileHandler::calculateThroughput(size_t bytes, std::chrono::nanoseconds elapsed) {
+    if (elapsed.count() == 0) return 0.0;
+    return (bytes * 1e9) / (elapsed.count() * 1024.0 * 1024.0); // Convert to MB/s
+}
\ No newline at end of file
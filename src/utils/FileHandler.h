@@ -4,11 +4,14 @@
 #include <vector>
 #include <filesystem>
 #include <optional>
-#include <map>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "ByteView.h"
 
 class FileHandler {
 public:
-    // Read file contents into a byte vector
+    // Read file contents into a byte vector (see MappedFile for a zero-copy view)
     static std::vector<uint8_t> readFile(const std::filesystem::path& file_path);
     
     // Write data to a file
@@ -30,6 +33,9 @@ public:
     static std::filesystem::path createOutputPath(const std::filesystem::path& input_path,
                                                 const std::string& suffix);
     
+    // Unique path in the system temp directory for scratch output
+    static std::filesystem::path createTempFilePath(const std::string& prefix);
+    
     // Export results to CSV
     static void exportToCSV(const std::filesystem::path& output_path,
                            const std::vector<std::string>& headers,
@@ -41,7 +47,9 @@ public:
                             const std::vector<std::vector<std::string>>& rows);
     
     // New utility functions
-    static std::string detectFileType(const std::vector<uint8_t>& data);
-    static double calculateEntropy(const std::vector<uint8_t>& data);
+    static std::string detectFileType(ByteView data);
+    static double calculateEntropy(ByteView data);
+    static double calculateEntropy(const std::array<uint64_t, 256>& histogram);
     static double calculateThroughput(size_t bytes, long long microseconds);
+    static double calculateThroughput(size_t bytes, std::chrono::nanoseconds elapsed);
 }; 
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path, Access access) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            if (access == Access::Random) {
+                ::madvise(mapping, static_cast<size_t>(st.st_size), MADV_RANDOM);
+            } else {
+                ::madvise(mapping, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                ::madvise(mapping, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+            }
+            data_ = static_cast<const uint8_t*>(mapping);
+            size_ = static_cast<size_t>(st.st_size);
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+    if (mapped_) {
+        return;
+    }
+#endif
+    readFallback(path);
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      mapped_(std::exchange(other.mapped_, false)),
+      buffer_(std::move(other.buffer_)) {
+    if (!mapped_) {
+        data_ = buffer_.data();
+    }
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        mapped_ = std::exchange(other.mapped_, false);
+        buffer_ = std::move(other.buffer_);
+        if (!mapped_) {
+            data_ = buffer_.data();
+        }
+    }
+    return *this;
+}
+
+void MappedFile::readFallback(const std::filesystem::path& path) {
+    // Size is unknown or meaningless for non-regular files, so read to EOF
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+    constexpr size_t kChunk = 64 * 1024;
+    size_t used = 0;
+    while (true) {
+        buffer_.resize(used + kChunk);
+        file.read(reinterpret_cast<char*>(buffer_.data() + used), kChunk);
+        used += static_cast<size_t>(file.gcount());
+        if (!file) {
+            break;
+        }
+    }
+    if (file.bad()) {
+        throw std::runtime_error("Failed to read file: " + path.string());
+    }
+    buffer_.resize(used);
+    buffer_.shrink_to_fit();
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+void MappedFile::release() {
+#ifndef _WIN32
+    if (mapped_ && data_) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+}
\ No newline at end of file
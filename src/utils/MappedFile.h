@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ByteView.h"
+#include <filesystem>
+#include <vector>
+
+// Read-only contents of a whole file. Regular files are memory-mapped with a
+// sequential-access hint, so no copy is made and pages are shared with the
+// page cache; pipes, devices, procfs entries and empty files are read into an
+// owned buffer instead.
+class MappedFile {
+public:
+    // Sequential prefetches the whole file; Random reads in only the pages
+    // touched, for callers that look at a few scattered regions
+    enum class Access { Sequential, Random };
+
+    explicit MappedFile(const std::filesystem::path& path, Access access = Access::Sequential);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    ByteView view() const { return ByteView(data_, size_); }
+    bool isMapped() const { return mapped_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> buffer_;  // Fallback storage when not mapped
+
+    void readFallback(const std::filesystem::path& path);
+    void release();
+};
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Live and peak byte counts for one operation. Updates are atomic so the
+// blocks of a parallel compression can charge the same tracker.
+class MemoryTracker {
+public:
+    void allocate(size_t bytes) {
+        size_t current = current_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t peak = peak_.load(std::memory_order_relaxed);
+        while (current > peak && !peak_.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+    }
+
+    void release(size_t bytes) {
+        current_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    size_t current() const { return current_.load(std::memory_order_relaxed); }
+    size_t peak() const { return peak_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<size_t> current_{0};
+    std::atomic<size_t> peak_{0};
+};
+
+// std::allocator that charges every allocation to a MemoryTracker, for
+// buffers whose footprint belongs in a CompressionResult
+template <typename T>
+class TrackingAllocator {
+public:
+    using value_type = T;
+
+    explicit TrackingAllocator(MemoryTracker* tracker = nullptr) noexcept : tracker_(tracker) {}
+    template <typename U>
+    TrackingAllocator(const TrackingAllocator<U>& other) noexcept : tracker_(other.tracker()) {}
+
+    T* allocate(size_t count) {
+        T* pointer = std::allocator<T>().allocate(count);
+        if (tracker_) {
+            tracker_->allocate(count * sizeof(T));
+        }
+        return pointer;
+    }
+
+    void deallocate(T* pointer, size_t count) noexcept {
+        if (tracker_) {
+            tracker_->release(count * sizeof(T));
+        }
+        std::allocator<T>().deallocate(pointer, count);
+    }
+
+    MemoryTracker* tracker() const { return tracker_; }
+
+    template <typename U>
+    bool operator==(const TrackingAllocator<U>& other) const { return tracker_ == other.tracker(); }
+    template <typename U>
+    bool operator!=(const TrackingAllocator<U>& other) const { return tracker_ != other.tracker(); }
+
+private:
+    MemoryTracker* tracker_;
+};
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "ScratchArena.h"
+#include <algorithm>
+
+MutableByteView ScratchArena::buffer(Slot slot, size_t size) {
+    Buffer& buffer = buffers_[slot];
+    // Allocated even for size 0: codecs such as zlib reject a null buffer
+    if (!buffer.data || buffer.capacity < size) {
+        // Grow by at least half again so slowly increasing sizes settle quickly
+        size_t capacity = std::max({size_t(1), size, buffer.capacity + buffer.capacity / 2});
+        buffer.data.reset(new uint8_t[capacity]);
+        buffer.capacity = capacity;
+    }
+    return MutableByteView(buffer.data.get(), size);
+}
+
+size_t ScratchArena::capacity() const {
+    size_t total = 0;
+    for (const Buffer& buffer : buffers_) {
+        total += buffer.capacity;
+    }
+    return total;
+}
+
+ScratchArena& ScratchArena::local() {
+    thread_local ScratchArena arena;
+    return arena;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ByteView.h"
+#include <memory>
+#include <vector>
+
+// Grow-only scratch buffers reused across calls, so benchmarking many files
+// reaches a steady state with no heap allocation on the hot path. Buffers
+// are not zero-initialized and their contents do not survive the next
+// request for the same slot.
+class ScratchArena {
+public:
+    enum Slot : size_t {
+        Compressed = 0,
+        Decompressed = 1,
+        Reference = 2,
+        SlotCount
+    };
+
+    ScratchArena() : buffers_(SlotCount) {}
+
+    // A writable buffer of exactly size bytes for the given slot; the
+    // pointer is never null, even for size 0
+    MutableByteView buffer(Slot slot, size_t size);
+
+    // Bytes currently reserved across all slots
+    size_t capacity() const;
+
+    // Arena owned by the calling thread
+    static ScratchArena& local();
+
+private:
+    struct Buffer {
+        std::unique_ptr<uint8_t[]> data;
+        size_t capacity = 0;
+    };
+    std::vector<Buffer> buffers_;
+};
\ No newline at end of file
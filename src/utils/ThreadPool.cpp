@@ -0,0 +1,119 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+
+// Identifies the pool and queue index of the current worker thread
+thread_local ThreadPool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned thread_count) {
+    if (thread_count == 0) {
+        thread_count = defaultThreadCount();
+    }
+    for (unsigned i = 0; i < thread_count; ++i) {
+        local_queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::defaultThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::enqueue(Task task) {
+    ++unfinished_;
+    ++queued_;
+    if (current_pool == this) {
+        auto& queue = *local_queues_[current_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(global_mutex_);
+        global_queue_.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::tryPop(size_t index, Task& task) {
+    // Own work first, newest first
+    {
+        auto& queue = *local_queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            --queued_;
+            return true;
+        }
+    }
+    // Then externally submitted work, in submission order
+    {
+        std::lock_guard<std::mutex> lock(global_mutex_);
+        if (!global_queue_.empty()) {
+            task = std::move(global_queue_.front());
+            global_queue_.pop_front();
+            --queued_;
+            return true;
+        }
+    }
+    // Finally steal the oldest task from another worker
+    for (size_t offset = 1; offset < local_queues_.size(); ++offset) {
+        auto& victim = *local_queues_[(index + offset) % local_queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --queued_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        Task task;
+        if (tryPop(index, task)) {
+            task();
+            if (--unfinished_ == 0) {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                idle_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+        if (stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    idle_.wait(lock, [this]() { return unfinished_ == 0; });
+}
\ No newline at end of file
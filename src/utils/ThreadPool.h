@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing thread pool.
+//
+// Tasks submitted from outside the pool go to a shared FIFO queue, so callers
+// control the start order (e.g. largest file first). Tasks submitted from a
+// worker go to that worker's own deque; it pops newest-first for locality and
+// idle workers steal oldest-first from the other deques.
+class ThreadPool {
+public:
+    // thread_count == 0 means std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    auto submit(F&& func) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+        std::future<R> future = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return future;
+    }
+
+    // Block until every submitted task has finished
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    static unsigned defaultThreadCount();
+
+private:
+    using Task = std::function<void()>;
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> local_queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex global_mutex_;
+    std::deque<Task> global_queue_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::atomic<size_t> queued_{0};     // Tasks sitting in any queue
+    std::atomic<size_t> unfinished_{0}; // Tasks queued or running
+    bool stopping_ = false;
+
+    void enqueue(Task task);
+    bool tryPop(size_t index, Task& task);
+    void workerLoop(size_t index);
+};
\ No newline at end of file